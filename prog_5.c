@@ -1,9 +1,49 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
 
 #define MAX_VERTICES 20
 
+// Direction-optimizing BFS switch thresholds (Beamer et al.)
+#define BFS_ALPHA 15
+#define BFS_BETA 18
+
+// Binary graph file format
+#define GRAPH_FILE_MAGIC "DSAGRAPH"
+#define GRAPH_FILE_VERSION 1
+#define GRAPH_FLAG_WEIGHTED 1
+
+// Vertex order file written next to a relabeled graph
+#define ORDER_FILE_MAGIC "DSAORDER"
+#define ORDER_FILE_VERSION 1
+
+// Largest vertex id a text edge list may use, so that the vertex count + 1
+// offsets still fit in an int
+#define MAX_EDGE_LIST_VERTEX (INT_MAX - 2)
+
+// Upper limit on worker threads for the parallel traversals
+#define MAX_THREADS 64
+
+// Afforest components: neighbor rounds linked before sampling, sample size
+#define CC_NEIGHBOR_ROUNDS 2
+#define CC_SAMPLE_SIZE 1024
+
+// Multi-source BFS: 64-bit words per source mask (4 words = 256 sources)
+#define MSBFS_WORDS 4
+#define MSBFS_BATCH (MSBFS_WORDS * 64)
+
 typedef struct {
     int numVertices;
     int adjMatrix[MAX_VERTICES][MAX_VERTICES];
@@ -15,10 +55,110 @@ typedef struct {
     int rear;
 } Queue;
 
+// Compressed sparse row graph
 typedef struct {
-    int items[MAX_VERTICES];
-    int top;
-} Stack;
+    int numVertices;
+    long long numEdges;     // directed arcs, each undirected edge is stored twice
+    long long *offsets;     // neighbors of v are neighbors[offsets[v] .. offsets[v+1]-1]
+    int *neighbors;
+    int *weights;           // parallel to neighbors, NULL for unweighted graphs
+    void *mapping;          // start of mmap'ed file, NULL when arrays are malloc'ed
+    size_t mappingSize;
+} CSRGraph;
+
+// On-disk graph file header, followed by
+//   long long offsets[numVertices + 1]
+//   int neighbors[numEdges]
+//   int weights[numEdges]     (only if GRAPH_FLAG_WEIGHTED)
+// All values are stored in host (little-endian) byte order so the arrays can
+// be used straight from the mapping.
+typedef struct {
+    char magic[8];          // GRAPH_FILE_MAGIC
+    unsigned int version;   // GRAPH_FILE_VERSION
+    unsigned int flags;
+    long long numVertices;
+    long long numEdges;     // directed arcs
+} GraphFileHeader;
+
+// Order file layout: header followed by
+//   int order[numVertices]    (order[new id] = original id)
+typedef struct {
+    char magic[8];          // ORDER_FILE_MAGIC
+    unsigned int version;   // ORDER_FILE_VERSION
+    int numVertices;
+} OrderFileHeader;
+
+// BFS tree produced by the CSR traversals
+typedef struct {
+    int *parent;            // parent[source] = source, -1 if unreachable
+    int *depth;             // -1 if unreachable
+    int topDownSteps;
+    int bottomUpSteps;
+} BFSResult;
+
+// DFS stack frame: vertex and the next neighbor position to examine
+typedef struct {
+    int vertex;
+    long long next;
+} DFSFrame;
+
+// DFS forest produced by iterativeDFS()
+typedef struct {
+    int numVertices;
+    int *parent;            // -1 for roots and undiscovered vertices
+    int *discovery;         // time the vertex was first reached, -1 if undiscovered
+    int *finish;            // time all its descendants were done
+    int time;               // next timestamp
+    DFSFrame *stack;        // frame stack, at most one frame per vertex
+} DFSResult;
+
+// Called with the vertex and its DFS tree parent (-1 for a root)
+typedef void (*DFSVisitFn)(int vertex, int parent, void *context);
+
+typedef struct {
+    DFSVisitFn preVisit;    // when the vertex is discovered
+    DFSVisitFn postVisit;   // when the vertex is finished
+    void *context;
+} DFSCallbacks;
+
+// Connected components labeling
+typedef struct {
+    int numVertices;
+    int *label;             // smallest vertex id in the vertex's component
+    int numComponents;
+    int *representatives;   // representative (smallest vertex) of each component
+    int *sizes;             // number of vertices in each component
+} ComponentsResult;
+
+// Vertex permutation for locality
+typedef struct {
+    int numVertices;
+    int *order;             // order[newId] = old vertex id
+    int *newId;             // newId[old vertex id] = new id
+} VertexOrdering;
+
+// One bit per source of a multi-source BFS batch
+typedef struct {
+    unsigned long long word[MSBFS_WORDS];
+} SourceMask;
+
+// Per-source BFS distances
+typedef struct {
+    int numSources;
+    int numVertices;
+    int *sources;
+    int *distance;          // distance[s * numVertices + v], -1 if unreachable
+} MultiSourceBFSResult;
+
+void freeCSRGraph(CSRGraph *csr);
+bool buildCSRFromGraph(CSRGraph *csr, Graph *g);
+bool initDFSResult(DFSResult *result, int numVertices);
+void resetDFSResult(DFSResult *result);
+void freeDFSResult(DFSResult *result);
+void iterativeDFS(CSRGraph *csr, int source, DFSResult *result, DFSCallbacks *callbacks);
+void printVisitedVertex(int vertex, int parent, void *context);
+void freeVertexOrdering(VertexOrdering *ordering);
+void freeMultiSourceBFSResult(MultiSourceBFSResult *result);
 
 // Initialize graph
 void initGraph(Graph *g, int vertices) {
@@ -31,168 +171,2516 @@ void initGraph(Graph *g, int vertices) {
     }
 }
 
-// Add edge (undirected graph)
-void addEdge(Graph *g, int src, int dest) {
-    if (src >= g->numVertices || dest >= g->numVertices || src < 0 || dest < 0) {
-        printf("Invalid vertices!\n");
+// Add edge (undirected graph)
+void addEdge(Graph *g, int src, int dest) {
+    if (src >= g->numVertices || dest >= g->numVertices || src < 0 || dest < 0) {
+        printf("Invalid vertices!\n");
+        return;
+    }
+    
+    // Since it's undirected, add edge in both directions
+    g->adjMatrix[src][dest] = 1;
+    g->adjMatrix[dest][src] = 1;
+}
+
+// Display adjacency matrix
+void displayGraph(Graph *g) {
+    printf("\nAdjacency Matrix:\n");
+    printf("   ");
+    for (int i = 0; i < g->numVertices; i++) {
+        printf("%2d ", i);
+    }
+    printf("\n");
+    
+    for (int i = 0; i < g->numVertices; i++) {
+        printf("%2d ", i);
+        for (int j = 0; j < g->numVertices; j++) {
+            printf("%2d ", g->adjMatrix[i][j]);
+        }
+        printf("\n");
+    }
+}
+
+// Operations for BFS
+void initQueue(Queue *q) {
+    q->front = -1;
+    q->rear = -1;
+}
+
+bool isQueueEmpty(Queue *q) {
+    return q->front == -1;
+}
+
+void enqueue(Queue *q, int value) {
+    if (q->front == -1) {
+        q->front = 0;
+    }
+    q->rear++;
+    q->items[q->rear] = value;
+}
+
+int dequeue(Queue *q) {
+    int item = q->items[q->front];
+    q->front++;
+    if (q->front > q->rear) {
+        q->front = q->rear = -1;
+    }
+    return item;
+}
+
+// Breadth First Search (BFS)
+void BFS(Graph *g, int startVertex) {
+    if (startVertex >= g->numVertices || startVertex < 0) {
+        printf("Invalid start vertex!\n");
+        return;
+    }
+    
+    bool visited[MAX_VERTICES] = {false};
+    Queue q;
+    initQueue(&q);
+    
+    printf("\nBFS Traversal starting from vertex %d: ", startVertex);
+    
+    visited[startVertex] = true;
+    enqueue(&q, startVertex);
+    
+    while (!isQueueEmpty(&q)) {
+        int currentVertex = dequeue(&q);
+        printf("%d ", currentVertex);
+        
+        // Check all adjacent vertices
+        for (int i = 0; i < g->numVertices; i++) {
+            if (g->adjMatrix[currentVertex][i] == 1 && !visited[i]) {
+                visited[i] = true;
+                enqueue(&q, i);
+            }
+        }
+    }
+    printf("\n");
+}
+
+// Depth First Search (DFS)
+// Both matrix traversals run on the iterative engine below: the matrix is
+// converted to CSR (neighbors in ascending column order, the order the
+// recursive version scans a row) and iterativeDFS() prints each vertex as it
+// is discovered. The order is that of the recursive DFS, without recursion.
+void printMatrixDFS(Graph *g, int startVertex, const char *title) {
+    if (startVertex >= g->numVertices || startVertex < 0) {
+        printf("Invalid start vertex!\n");
+        return;
+    }
+    
+    CSRGraph csr;
+    DFSResult result;
+    DFSCallbacks printCallbacks = {printVisitedVertex, NULL, NULL};
+    if (!buildCSRFromGraph(&csr, g)) return;
+    if (initDFSResult(&result, csr.numVertices)) {
+        printf("\n%s starting from vertex %d: ", title, startVertex);
+        iterativeDFS(&csr, startVertex, &result, &printCallbacks);
+        printf("\n");
+        freeDFSResult(&result);
+    }
+    freeCSRGraph(&csr);
+}
+
+void DFS(Graph *g, int startVertex) {
+    printMatrixDFS(g, startVertex, "DFS Traversal");
+}
+
+// Recursive visiting order, produced by the same frame stack: each frame
+// keeps the state the recursive call would keep on the call stack
+void DFSRecursive(Graph *g, int startVertex) {
+    printMatrixDFS(g, startVertex, "DFS Traversal (Recursive)");
+}
+
+// Sparse graph (CSR) for large traversals
+// The adjacency matrix above is limited to MAX_VERTICES; the CSR layout stores
+// only existing edges so the traversals below scale to millions of vertices.
+
+// Get current wall clock time in seconds
+double getTimeSeconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Pseudo random generator (xorshift64*) with caller-owned state
+unsigned int nextRandom(unsigned long long *state) {
+    unsigned long long x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return (unsigned int)((x * 2685821657736338717ULL) >> 32);
+}
+
+void initCSRGraph(CSRGraph *csr) {
+    csr->numVertices = 0;
+    csr->numEdges = 0;
+    csr->offsets = NULL;
+    csr->neighbors = NULL;
+    csr->weights = NULL;
+    csr->mapping = NULL;
+    csr->mappingSize = 0;
+}
+
+void freeCSRGraph(CSRGraph *csr) {
+    if (csr->mapping != NULL) {
+        munmap(csr->mapping, csr->mappingSize);
+    } else {
+        free(csr->offsets);
+        free(csr->neighbors);
+        free(csr->weights);
+    }
+    initCSRGraph(csr);
+}
+
+// Build undirected CSR graph from an edge list (self loops are dropped)
+// weight may be NULL for an unweighted graph
+bool buildCSRFromEdges(CSRGraph *csr, int numVertices, const int src[],
+                       const int dest[], const int weight[], long long numEdges) {
+    initCSRGraph(csr);
+    csr->offsets = (long long*)calloc(numVertices + 1, sizeof(long long));
+    if (csr->offsets == NULL) {
+        printf("Memory allocation failed!\n");
+        return false;
+    }
+    
+    // Count degrees
+    long long arcs = 0;
+    for (long long e = 0; e < numEdges; e++) {
+        if (src[e] != dest[e]) {
+            csr->offsets[src[e] + 1]++;
+            csr->offsets[dest[e] + 1]++;
+            arcs += 2;
+        }
+    }
+    
+    // Prefix sum turns degrees into offsets
+    for (int v = 0; v < numVertices; v++) {
+        csr->offsets[v + 1] += csr->offsets[v];
+    }
+    
+    csr->neighbors = (int*)malloc((arcs > 0 ? arcs : 1) * sizeof(int));
+    if (weight != NULL) {
+        csr->weights = (int*)malloc((arcs > 0 ? arcs : 1) * sizeof(int));
+    }
+    long long *pos = (long long*)malloc(numVertices * sizeof(long long));
+    if (csr->neighbors == NULL || pos == NULL || (weight != NULL && csr->weights == NULL)) {
+        printf("Memory allocation failed!\n");
+        free(pos);
+        freeCSRGraph(csr);
+        return false;
+    }
+    
+    for (int v = 0; v < numVertices; v++) {
+        pos[v] = csr->offsets[v];
+    }
+    for (long long e = 0; e < numEdges; e++) {
+        if (src[e] != dest[e]) {
+            if (weight != NULL) {
+                csr->weights[pos[src[e]]] = weight[e];
+                csr->weights[pos[dest[e]]] = weight[e];
+            }
+            csr->neighbors[pos[src[e]]++] = dest[e];
+            csr->neighbors[pos[dest[e]]++] = src[e];
+        }
+    }
+    
+    free(pos);
+    csr->numVertices = numVertices;
+    csr->numEdges = arcs;
+    return true;
+}
+
+// Convert adjacency matrix graph to CSR (neighbors kept in ascending order)
+bool buildCSRFromGraph(CSRGraph *csr, Graph *g) {
+    initCSRGraph(csr);
+    int n = g->numVertices;
+    long long arcs = 0;
+    
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            if (g->adjMatrix[i][j] == 1) arcs++;
+        }
+    }
+    
+    csr->offsets = (long long*)malloc((n + 1) * sizeof(long long));
+    csr->neighbors = (int*)malloc((arcs > 0 ? arcs : 1) * sizeof(int));
+    if (csr->offsets == NULL || csr->neighbors == NULL) {
+        printf("Memory allocation failed!\n");
+        freeCSRGraph(csr);
+        return false;
+    }
+    
+    long long k = 0;
+    for (int i = 0; i < n; i++) {
+        csr->offsets[i] = k;
+        for (int j = 0; j < n; j++) {
+            if (g->adjMatrix[i][j] == 1) {
+                csr->neighbors[k++] = j;
+            }
+        }
+    }
+    csr->offsets[n] = k;
+    csr->numVertices = n;
+    csr->numEdges = arcs;
+    return true;
+}
+
+// Generate R-MAT power-law graph with 2^scale vertices and edgeFactor * 2^scale edges
+bool generateRMATGraph(CSRGraph *csr, int scale, int edgeFactor, unsigned long long seed) {
+    int n = 1 << scale;
+    long long m = (long long)edgeFactor * n;
+    int *src = (int*)malloc(m * sizeof(int));
+    int *dest = (int*)malloc(m * sizeof(int));
+    int *perm = (int*)malloc(n * sizeof(int));
+    unsigned long long state = seed ? seed : 1;
+    
+    if (src == NULL || dest == NULL || perm == NULL) {
+        printf("Memory allocation failed!\n");
+        free(src);
+        free(dest);
+        free(perm);
+        initCSRGraph(csr);
+        return false;
+    }
+    
+    // Quadrant probabilities a = 0.57, b = 0.19, c = 0.19, d = 0.05 (Graph500)
+    for (long long e = 0; e < m; e++) {
+        int u = 0, v = 0;
+        for (int bit = 0; bit < scale; bit++) {
+            unsigned int r = nextRandom(&state) % 100;
+            if (r >= 57 && r < 76) {
+                v |= 1 << bit;
+            } else if (r >= 76 && r < 95) {
+                u |= 1 << bit;
+            } else if (r >= 95) {
+                u |= 1 << bit;
+                v |= 1 << bit;
+            }
+        }
+        src[e] = u;
+        dest[e] = v;
+    }
+    
+    // Shuffle vertex labels so high degree vertices are not clustered at 0
+    for (int i = 0; i < n; i++) {
+        perm[i] = i;
+    }
+    for (int i = n - 1; i > 0; i--) {
+        int j = nextRandom(&state) % (i + 1);
+        int temp = perm[i];
+        perm[i] = perm[j];
+        perm[j] = temp;
+    }
+    for (long long e = 0; e < m; e++) {
+        src[e] = perm[src[e]];
+        dest[e] = perm[dest[e]];
+    }
+    
+    bool ok = buildCSRFromEdges(csr, n, src, dest, NULL, m);
+    free(src);
+    free(dest);
+    free(perm);
+    return ok;
+}
+
+bool initBFSResult(BFSResult *result, int numVertices) {
+    result->parent = (int*)malloc(numVertices * sizeof(int));
+    result->depth = (int*)malloc(numVertices * sizeof(int));
+    result->topDownSteps = 0;
+    result->bottomUpSteps = 0;
+    if (result->parent == NULL || result->depth == NULL) {
+        printf("Memory allocation failed!\n");
+        free(result->parent);
+        free(result->depth);
+        result->parent = result->depth = NULL;
+        return false;
+    }
+    return true;
+}
+
+void freeBFSResult(BFSResult *result) {
+    free(result->parent);
+    free(result->depth);
+    result->parent = result->depth = NULL;
+}
+
+// Top-down BFS on CSR graph (same queue algorithm as BFS(), without printing)
+bool topDownBFS(CSRGraph *csr, int source, BFSResult *result) {
+    int n = csr->numVertices;
+    int *queue = (int*)malloc((n > 0 ? n : 1) * sizeof(int));
+    int head = 0, tail = 0;
+    if (queue == NULL) {
+        printf("Memory allocation failed!\n");
+        return false;
+    }
+    
+    for (int v = 0; v < n; v++) {
+        result->parent[v] = -1;
+        result->depth[v] = -1;
+    }
+    result->topDownSteps = 0;
+    result->bottomUpSteps = 0;
+    
+    result->parent[source] = source;
+    result->depth[source] = 0;
+    queue[tail++] = source;
+    
+    while (head < tail) {
+        int u = queue[head++];
+        for (long long e = csr->offsets[u]; e < csr->offsets[u + 1]; e++) {
+            int v = csr->neighbors[e];
+            if (result->parent[v] == -1) {
+                result->parent[v] = u;
+                result->depth[v] = result->depth[u] + 1;
+                queue[tail++] = v;
+            }
+        }
+    }
+    
+    free(queue);
+    return true;
+}
+
+// Direction-optimizing BFS (Beamer et al.)
+// Top-down steps expand the frontier queue; bottom-up steps let every
+// unvisited vertex search for a parent in the frontier bitmap and stop at the
+// first hit, which skips most edges when the frontier is large.
+bool directionOptimizingBFS(CSRGraph *csr, int source, BFSResult *result) {
+    int n = csr->numVertices;
+    int *frontier = (int*)malloc((n > 0 ? n : 1) * sizeof(int));
+    int *next = (int*)malloc((n > 0 ? n : 1) * sizeof(int));
+    unsigned char *inFrontier = (unsigned char*)calloc(n > 0 ? n : 1, 1);
+    unsigned char *inNext = (unsigned char*)calloc(n > 0 ? n : 1, 1);
+    if (frontier == NULL || next == NULL || inFrontier == NULL || inNext == NULL) {
+        printf("Memory allocation failed!\n");
+        free(frontier);
+        free(next);
+        free(inFrontier);
+        free(inNext);
+        return false;
+    }
+    
+    for (int v = 0; v < n; v++) {
+        result->parent[v] = -1;
+        result->depth[v] = -1;
+    }
+    result->topDownSteps = 0;
+    result->bottomUpSteps = 0;
+    
+    result->parent[source] = source;
+    result->depth[source] = 0;
+    frontier[0] = source;
+    int frontierSize = 1;
+    
+    // scoutCount: edges leaving the frontier (m_f)
+    // edgesToCheck: edges incident to unvisited vertices (m_u)
+    long long scoutCount = csr->offsets[source + 1] - csr->offsets[source];
+    long long edgesToCheck = csr->numEdges - scoutCount;
+    bool bottomUp = false;
+    int level = 0;
+    
+    while (frontierSize > 0) {
+        if (!bottomUp && scoutCount > edgesToCheck / BFS_ALPHA) {
+            // Switch to bottom-up: convert frontier queue to bitmap
+            bottomUp = true;
+            for (int i = 0; i < frontierSize; i++) {
+                inFrontier[frontier[i]] = 1;
+            }
+        }
+        
+        if (bottomUp) {
+            int nextSize = 0;
+            memset(inNext, 0, n);
+            
+            for (int v = 0; v < n; v++) {
+                if (result->parent[v] != -1) continue;
+                for (long long e = csr->offsets[v]; e < csr->offsets[v + 1]; e++) {
+                    int u = csr->neighbors[e];
+                    if (inFrontier[u]) {
+                        result->parent[v] = u;
+                        result->depth[v] = level + 1;
+                        inNext[v] = 1;
+                        nextSize++;
+                        edgesToCheck -= csr->offsets[v + 1] - csr->offsets[v];
+                        break;
+                    }
+                }
+            }
+            
+            unsigned char *temp = inFrontier;
+            inFrontier = inNext;
+            inNext = temp;
+            result->bottomUpSteps++;
+            
+            // Switch back to top-down once the frontier shrinks
+            bool shrinking = nextSize < frontierSize;
+            frontierSize = nextSize;
+            if (shrinking && frontierSize < n / BFS_BETA) {
+                bottomUp = false;
+                int k = 0;
+                scoutCount = 0;
+                for (int v = 0; v < n; v++) {
+                    if (inFrontier[v]) {
+                        frontier[k++] = v;
+                        inFrontier[v] = 0;
+                        scoutCount += csr->offsets[v + 1] - csr->offsets[v];
+                    }
+                }
+            }
+        } else {
+            int nextSize = 0;
+            scoutCount = 0;
+            
+            for (int i = 0; i < frontierSize; i++) {
+                int u = frontier[i];
+                for (long long e = csr->offsets[u]; e < csr->offsets[u + 1]; e++) {
+                    int v = csr->neighbors[e];
+                    if (result->parent[v] == -1) {
+                        long long degree = csr->offsets[v + 1] - csr->offsets[v];
+                        result->parent[v] = u;
+                        result->depth[v] = level + 1;
+                        next[nextSize++] = v;
+                        scoutCount += degree;
+                        edgesToCheck -= degree;
+                    }
+                }
+            }
+            
+            int *temp = frontier;
+            frontier = next;
+            next = temp;
+            frontierSize = nextSize;
+            result->topDownSteps++;
+        }
+        level++;
+    }
+    
+    free(frontier);
+    free(next);
+    free(inFrontier);
+    free(inNext);
+    return true;
+}
+
+// Display parent and depth of every vertex
+void displayBFSResult(BFSResult *result, int numVertices) {
+    printf("Vertex\tParent\tDepth\n");
+    for (int v = 0; v < numVertices; v++) {
+        if (result->depth[v] == -1) {
+            printf("%d\t-\tunreachable\n", v);
+        } else {
+            printf("%d\t%d\t%d\n", v, result->parent[v], result->depth[v]);
+        }
+    }
+    printf("Top-down steps: %d, Bottom-up steps: %d\n",
+           result->topDownSteps, result->bottomUpSteps);
+}
+
+// Compare top-down and direction-optimizing BFS on an R-MAT graph
+void benchmarkBFS(int scale, int edgeFactor, int numSources) {
+    CSRGraph csr;
+    BFSResult baseline, optimized;
+    
+    printf("\nGenerating R-MAT graph (scale %d, edge factor %d)...\n", scale, edgeFactor);
+    double start = getTimeSeconds();
+    if (!generateRMATGraph(&csr, scale, edgeFactor, 12345)) {
+        return;
+    }
+    printf("Vertices: %d, Edges: %lld (%.3f s)\n",
+           csr.numVertices, csr.numEdges / 2, getTimeSeconds() - start);
+    
+    if (!initBFSResult(&baseline, csr.numVertices)) {
+        freeCSRGraph(&csr);
+        return;
+    }
+    if (!initBFSResult(&optimized, csr.numVertices)) {
+        freeBFSResult(&baseline);
+        freeCSRGraph(&csr);
+        return;
+    }
+    
+    unsigned long long state = 987654321;
+    double topDownTime = 0.0, optimizedTime = 0.0;
+    long long edgesTraversed = 0;
+    int runs = 0;
+    
+    printf("\nSource\tReached\tTop-down(s)\tDir-opt(s)\tSpeedup\tSteps(TD/BU)\n");
+    while (runs < numSources) {
+        int source = nextRandom(&state) % csr.numVertices;
+        if (csr.offsets[source + 1] == csr.offsets[source]) continue; // isolated
+        
+        start = getTimeSeconds();
+        if (!topDownBFS(&csr, source, &baseline)) break;
+        double t1 = getTimeSeconds() - start;
+        
+        start = getTimeSeconds();
+        if (!directionOptimizingBFS(&csr, source, &optimized)) break;
+        double t2 = getTimeSeconds() - start;
+        
+        int reached = 0;
+        for (int v = 0; v < csr.numVertices; v++) {
+            if (baseline.depth[v] != optimized.depth[v]) {
+                printf("Depth mismatch at vertex %d!\n", v);
+                break;
+            }
+            if (baseline.depth[v] != -1) {
+                reached++;
+                edgesTraversed += csr.offsets[v + 1] - csr.offsets[v];
+            }
+        }
+        
+        printf("%d\t%d\t%.6f\t%.6f\t%.2fx\t%d/%d\n", source, reached, t1, t2,
+               t2 > 0 ? t1 / t2 : 0.0, optimized.topDownSteps, optimized.bottomUpSteps);
+        topDownTime += t1;
+        optimizedTime += t2;
+        runs++;
+    }
+    
+    // Each undirected edge is stored twice in the CSR
+    if (runs > 0) {
+        printf("\nAverage top-down time:             %.6f s (%.1f MTEPS)\n",
+               topDownTime / runs, edgesTraversed / 2 / topDownTime / 1e6);
+        printf("Average direction-optimizing time: %.6f s (%.1f MTEPS)\n",
+               optimizedTime / runs, edgesTraversed / 2 / optimizedTime / 1e6);
+    }
+    
+    freeBFSResult(&baseline);
+    freeBFSResult(&optimized);
+    freeCSRGraph(&csr);
+}
+
+// Iterative DFS engine on CSR graph
+// Each stack frame holds a vertex and the position of the next neighbor to
+// examine, exactly the state a recursive call keeps on the call stack. A
+// vertex is pushed only when it is discovered, so the stack never exceeds V
+// frames and the visiting order is that of a recursive DFS. DFS() and
+// DFSRecursive() on the adjacency matrix use it as well.
+
+bool initDFSResult(DFSResult *result, int numVertices) {
+    result->numVertices = numVertices;
+    result->parent = (int*)malloc(numVertices * sizeof(int));
+    result->discovery = (int*)malloc(numVertices * sizeof(int));
+    result->finish = (int*)malloc(numVertices * sizeof(int));
+    result->stack = (DFSFrame*)malloc(numVertices * sizeof(DFSFrame));
+    if (result->parent == NULL || result->discovery == NULL ||
+        result->finish == NULL || result->stack == NULL) {
+        printf("Memory allocation failed!\n");
+        freeDFSResult(result);
+        return false;
+    }
+    resetDFSResult(result);
+    return true;
+}
+
+// Mark every vertex undiscovered and restart the clock
+void resetDFSResult(DFSResult *result) {
+    for (int v = 0; v < result->numVertices; v++) {
+        result->parent[v] = -1;
+        result->discovery[v] = -1;
+        result->finish[v] = -1;
+    }
+    result->time = 0;
+}
+
+void freeDFSResult(DFSResult *result) {
+    free(result->parent);
+    free(result->discovery);
+    free(result->finish);
+    free(result->stack);
+    result->parent = result->discovery = result->finish = NULL;
+    result->stack = NULL;
+}
+
+// DFS from source over vertices not yet discovered in result
+// callbacks may be NULL; the result is not reset, so calling this for every
+// undiscovered vertex builds a DFS forest with consistent timestamps
+void iterativeDFS(CSRGraph *csr, int source, DFSResult *result, DFSCallbacks *callbacks) {
+    if (result->discovery[source] != -1) return;
+    
+    DFSFrame *stack = result->stack;
+    int top = 0;
+    
+    result->discovery[source] = result->time++;
+    if (callbacks != NULL && callbacks->preVisit != NULL) {
+        callbacks->preVisit(source, -1, callbacks->context);
+    }
+    stack[0].vertex = source;
+    stack[0].next = csr->offsets[source];
+    
+    while (top >= 0) {
+        DFSFrame *frame = &stack[top];
+        int u = frame->vertex;
+        long long end = csr->offsets[u + 1];
+        
+        // Advance this frame's cursor to its next undiscovered neighbor
+        while (frame->next < end && result->discovery[csr->neighbors[frame->next]] != -1) {
+            frame->next++;
+        }
+        
+        if (frame->next == end) {
+            // All neighbors done: the "return" of the recursive call
+            result->finish[u] = result->time++;
+            if (callbacks != NULL && callbacks->postVisit != NULL) {
+                callbacks->postVisit(u, result->parent[u], callbacks->context);
+            }
+            top--;
+            continue;
+        }
+        
+        int v = csr->neighbors[frame->next++];
+        result->parent[v] = u;
+        result->discovery[v] = result->time++;
+        if (callbacks != NULL && callbacks->preVisit != NULL) {
+            callbacks->preVisit(v, u, callbacks->context);
+        }
+        top++;
+        stack[top].vertex = v;
+        stack[top].next = csr->offsets[v];
+    }
+}
+
+// DFS forest over the whole graph, roots taken in increasing vertex order
+void DFSForest(CSRGraph *csr, DFSResult *result, DFSCallbacks *callbacks) {
+    resetDFSResult(result);
+    for (int v = 0; v < csr->numVertices; v++) {
+        if (result->discovery[v] == -1) {
+            iterativeDFS(csr, v, result, callbacks);
+        }
+    }
+}
+
+// Pre-order callback that prints the vertex
+void printVisitedVertex(int vertex, int parent, void *context) {
+    (void)parent;
+    (void)context;
+    printf("%d ", vertex);
+}
+
+// Display discovery and finish times of every vertex
+void displayDFSResult(DFSResult *result) {
+    printf("Vertex\tParent\tDiscovery\tFinish\n");
+    for (int v = 0; v < result->numVertices; v++) {
+        if (result->discovery[v] == -1) {
+            printf("%d\t-\tunreachable\n", v);
+        } else {
+            printf("%d\t%d\t%d\t\t%d\n", v, result->parent[v],
+                   result->discovery[v], result->finish[v]);
+        }
+    }
+}
+
+// Run the engine on a path graph deep enough to overflow a recursive DFS
+void demonstrateDeepDFS(int length) {
+    int *src = (int*)malloc(length * sizeof(int));
+    int *dest = (int*)malloc(length * sizeof(int));
+    CSRGraph csr;
+    DFSResult result;
+    
+    if (src == NULL || dest == NULL) {
+        printf("Memory allocation failed!\n");
+        free(src);
+        free(dest);
+        return;
+    }
+    for (int i = 0; i + 1 < length; i++) {
+        src[i] = i;
+        dest[i] = i + 1;
+    }
+    
+    bool ok = buildCSRFromEdges(&csr, length, src, dest, NULL, length - 1);
+    free(src);
+    free(dest);
+    if (!ok) return;
+    
+    if (initDFSResult(&result, csr.numVertices)) {
+        double start = getTimeSeconds();
+        iterativeDFS(&csr, 0, &result, NULL);
+        printf("Path of %d vertices: depth-first order reached vertex %d at time %d "
+               "(%.6f s, no recursion)\n", length, length - 1,
+               result.discovery[length - 1], getTimeSeconds() - start);
+        freeDFSResult(&result);
+    }
+    freeCSRGraph(&csr);
+}
+
+// Parallel level-synchronous BFS
+// Every level the frontier is split into equal slices, one per thread. Vertices
+// are claimed with an atomic compare-and-swap on parent[], so each vertex
+// enters exactly one thread's local buffer. Threads then compute their write
+// offset from the buffer sizes of lower-numbered threads and copy into the
+// next frontier, so merging needs no lock.
+
+typedef struct {
+    CSRGraph *csr;
+    BFSResult *result;
+    int numThreads;             // threads actually started
+    bool started;               // start gate, set once numThreads and barrier are final
+    bool deterministic;
+    int *frontier[2];           // double buffer indexed by level parity
+    int frontierSize;
+    int *claim;                 // deterministic mode: lowest frontier position reaching v
+    int *localNext[MAX_THREADS];
+    int localCount[MAX_THREADS];
+    int localCapacity[MAX_THREADS];
+    bool failed;                // a local buffer could not grow; all threads stop
+    pthread_barrier_t barrier;
+} ParallelBFSContext;
+
+typedef struct {
+    ParallelBFSContext *ctx;
+    int id;
+} ParallelBFSWorker;
+
+// Append vertex to a thread-local buffer, growing it when full
+bool appendLocal(ParallelBFSContext *ctx, int t, int v) {
+    if (ctx->localCount[t] == ctx->localCapacity[t]) {
+        int newCapacity = ctx->localCapacity[t] * 2;
+        int *grown = (int*)realloc(ctx->localNext[t], newCapacity * sizeof(int));
+        if (grown == NULL) return false;
+        ctx->localNext[t] = grown;
+        ctx->localCapacity[t] = newCapacity;
+    }
+    ctx->localNext[t][ctx->localCount[t]++] = v;
+    return true;
+}
+
+void *parallelBFSWorker(void *arg) {
+    ParallelBFSWorker *worker = (ParallelBFSWorker*)arg;
+    ParallelBFSContext *ctx = worker->ctx;
+    CSRGraph *csr = ctx->csr;
+    int *parent = ctx->result->parent;
+    int *depth = ctx->result->depth;
+    int t = worker->id;
+    int level = 0;
+    
+    // Wait until parallelBFS() knows how many threads could be started
+    while (!__atomic_load_n(&ctx->started, __ATOMIC_ACQUIRE)) sched_yield();
+    
+    while (1) {
+        int *frontier = ctx->frontier[level & 1];
+        int *next = ctx->frontier[(level + 1) & 1];
+        int size = ctx->frontierSize;
+        if (size == 0) break;
+        
+        int begin = (int)((long long)size * t / ctx->numThreads);
+        int end = (int)((long long)size * (t + 1) / ctx->numThreads);
+        ctx->localCount[t] = 0;
+        
+        if (ctx->deterministic) {
+            // Pass 1: every unvisited neighbor keeps the lowest frontier position
+            for (int i = begin; i < end; i++) {
+                int u = frontier[i];
+                for (long long e = csr->offsets[u]; e < csr->offsets[u + 1]; e++) {
+                    int v = csr->neighbors[e];
+                    if (depth[v] != -1) continue;
+                    int current = __atomic_load_n(&ctx->claim[v], __ATOMIC_RELAXED);
+                    while (i < current &&
+                           !__atomic_compare_exchange_n(&ctx->claim[v], &current, i, false,
+                                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                    }
+                }
+            }
+            pthread_barrier_wait(&ctx->barrier);
+            
+            // Pass 2: the winning position appends v, giving the serial BFS order
+            for (int i = begin; i < end; i++) {
+                int u = frontier[i];
+                for (long long e = csr->offsets[u]; e < csr->offsets[u + 1]; e++) {
+                    int v = csr->neighbors[e];
+                    if (ctx->claim[v] == i && parent[v] == -1) {
+                        parent[v] = u;
+                        depth[v] = level + 1;
+                        if (!appendLocal(ctx, t, v)) {
+                            __atomic_store_n(&ctx->failed, true, __ATOMIC_RELAXED);
+                        }
+                    }
+                }
+            }
+        } else {
+            for (int i = begin; i < end; i++) {
+                int u = frontier[i];
+                for (long long e = csr->offsets[u]; e < csr->offsets[u + 1]; e++) {
+                    int v = csr->neighbors[e];
+                    int expected = -1;
+                    if (__atomic_load_n(&parent[v], __ATOMIC_RELAXED) == -1 &&
+                        __atomic_compare_exchange_n(&parent[v], &expected, u, false,
+                                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                        depth[v] = level + 1;
+                        if (!appendLocal(ctx, t, v)) {
+                            __atomic_store_n(&ctx->failed, true, __ATOMIC_RELAXED);
+                        }
+                    }
+                }
+            }
+        }
+        pthread_barrier_wait(&ctx->barrier);
+        
+        // Every thread reads the same flag after the barrier, so all stop together
+        if (__atomic_load_n(&ctx->failed, __ATOMIC_RELAXED)) break;
+        
+        // Lock-free merge: offset is the total size of lower threads' buffers
+        int offset = 0, total = 0;
+        for (int k = 0; k < ctx->numThreads; k++) {
+            if (k < t) offset += ctx->localCount[k];
+            total += ctx->localCount[k];
+        }
+        memcpy(next + offset, ctx->localNext[t], ctx->localCount[t] * sizeof(int));
+        pthread_barrier_wait(&ctx->barrier);
+        
+        if (t == 0) ctx->frontierSize = total;
+        pthread_barrier_wait(&ctx->barrier);
+        level++;
+    }
+    
+    return NULL;
+}
+
+// Multi-threaded BFS; deterministic mode reproduces topDownBFS() exactly
+bool parallelBFS(CSRGraph *csr, int source, BFSResult *result, int numThreads,
+                 bool deterministic) {
+    int n = csr->numVertices;
+    ParallelBFSContext ctx;
+    pthread_t threads[MAX_THREADS];
+    ParallelBFSWorker workers[MAX_THREADS];
+    bool ok = true;
+    
+    if (numThreads < 1) numThreads = 1;
+    if (numThreads > MAX_THREADS) numThreads = MAX_THREADS;
+    
+    ctx.csr = csr;
+    ctx.result = result;
+    ctx.numThreads = numThreads;
+    ctx.started = false;
+    ctx.deterministic = deterministic;
+    ctx.failed = false;
+    ctx.frontier[0] = (int*)malloc(n * sizeof(int));
+    ctx.frontier[1] = (int*)malloc(n * sizeof(int));
+    ctx.claim = deterministic ? (int*)malloc(n * sizeof(int)) : NULL;
+    for (int t = 0; t < numThreads; t++) {
+        ctx.localCapacity[t] = 1024;
+        ctx.localCount[t] = 0;
+        ctx.localNext[t] = (int*)malloc(ctx.localCapacity[t] * sizeof(int));
+        if (ctx.localNext[t] == NULL) ok = false;
+    }
+    if (ctx.frontier[0] == NULL || ctx.frontier[1] == NULL ||
+        (deterministic && ctx.claim == NULL)) {
+        ok = false;
+    }
+    
+    if (ok) {
+        for (int v = 0; v < n; v++) {
+            result->parent[v] = -1;
+            result->depth[v] = -1;
+            if (deterministic) ctx.claim[v] = INT_MAX;
+        }
+        result->topDownSteps = 0;
+        result->bottomUpSteps = 0;
+        result->parent[source] = source;
+        result->depth[source] = 0;
+        ctx.frontier[0][0] = source;
+        ctx.frontierSize = 1;
+        
+        // The calling thread is worker 0. Threads that failed to start are
+        // left out: the barrier and the frontier split only count the ones
+        // running before the gate opens
+        for (int t = 0; t < numThreads; t++) {
+            workers[t].ctx = &ctx;
+            workers[t].id = t;
+        }
+        int running = 1;
+        while (running < numThreads &&
+               pthread_create(&threads[running], NULL, parallelBFSWorker,
+                              &workers[running]) == 0) {
+            running++;
+        }
+        if (running < numThreads) {
+            printf("Could only start %d of %d threads\n", running, numThreads);
+        }
+        ctx.numThreads = running;
+        pthread_barrier_init(&ctx.barrier, NULL, running);
+        __atomic_store_n(&ctx.started, true, __ATOMIC_RELEASE);
+        
+        parallelBFSWorker(&workers[0]);
+        for (int t = 1; t < running; t++) {
+            pthread_join(threads[t], NULL);
+        }
+        pthread_barrier_destroy(&ctx.barrier);
+        ok = !ctx.failed;
+        
+        for (int v = 0; v < n; v++) {
+            if (result->depth[v] > result->topDownSteps) {
+                result->topDownSteps = result->depth[v];
+            }
+        }
+    }
+    if (!ok) {
+        printf("Memory allocation failed!\n");
+    }
+    
+    free(ctx.frontier[0]);
+    free(ctx.frontier[1]);
+    free(ctx.claim);
+    for (int t = 0; t < numThreads; t++) {
+        free(ctx.localNext[t]);
+    }
+    return ok;
+}
+
+// Scaling benchmark of parallelBFS() from 1 to maxThreads threads
+void benchmarkParallelBFS(int scale, int edgeFactor, int maxThreads) {
+    CSRGraph csr;
+    BFSResult serial, parallel;
+    
+    printf("\nGenerating R-MAT graph (scale %d, edge factor %d)...\n", scale, edgeFactor);
+    if (!generateRMATGraph(&csr, scale, edgeFactor, 12345)) {
+        return;
+    }
+    printf("Vertices: %d, Edges: %lld\n", csr.numVertices, csr.numEdges / 2);
+    
+    if (!initBFSResult(&serial, csr.numVertices)) {
+        freeCSRGraph(&csr);
+        return;
+    }
+    if (!initBFSResult(&parallel, csr.numVertices)) {
+        freeBFSResult(&serial);
+        freeCSRGraph(&csr);
+        return;
+    }
+    
+    // Start from the highest degree vertex so the search covers the giant component
+    int source = 0;
+    for (int v = 1; v < csr.numVertices; v++) {
+        if (csr.offsets[v + 1] - csr.offsets[v] > csr.offsets[source + 1] - csr.offsets[source]) {
+            source = v;
+        }
+    }
+    
+    double start = getTimeSeconds();
+    if (!topDownBFS(&csr, source, &serial)) {
+        freeBFSResult(&serial);
+        freeBFSResult(&parallel);
+        freeCSRGraph(&csr);
+        return;
+    }
+    double serialTime = getTimeSeconds() - start;
+    printf("Serial top-down BFS from %d: %.6f s\n", source, serialTime);
+    
+    printf("\nThreads\tRelaxed(s)\tSpeedup\tDeterministic(s)\tSpeedup\tCheck\n");
+    // Thread counts 1, 2, 4, ... up to maxThreads
+    int threads = 1;
+    while (1) {
+        start = getTimeSeconds();
+        if (!parallelBFS(&csr, source, &parallel, threads, false)) break;
+        double relaxedTime = getTimeSeconds() - start;
+        bool depthsMatch = true;
+        for (int v = 0; v < csr.numVertices; v++) {
+            if (parallel.depth[v] != serial.depth[v]) depthsMatch = false;
+        }
+        
+        start = getTimeSeconds();
+        if (!parallelBFS(&csr, source, &parallel, threads, true)) break;
+        double deterministicTime = getTimeSeconds() - start;
+        bool parentsMatch = true;
+        for (int v = 0; v < csr.numVertices; v++) {
+            if (parallel.parent[v] != serial.parent[v]) parentsMatch = false;
+        }
+        
+        printf("%d\t%.6f\t%.2fx\t%.6f\t\t%.2fx\t%s\n", threads, relaxedTime,
+               serialTime / relaxedTime, deterministicTime, serialTime / deterministicTime,
+               depthsMatch && parentsMatch ? "OK" : "MISMATCH");
+        if (threads == maxThreads) break;
+        threads = threads * 2 > maxThreads ? maxThreads : threads * 2;
+    }
+    
+    freeBFSResult(&serial);
+    freeBFSResult(&parallel);
+    freeCSRGraph(&csr);
+}
+
+// Parallel text edge list ingestion
+// The file is mapped and cut into one slice per thread; every cut is moved
+// forward to the next line start so no line is split. Each thread parses its
+// slice with a hand written integer parser into local edge arrays. The CSR is
+// then built in parallel: atomic degree counting, a two-pass blocked prefix
+// sum, and an atomic cursor per vertex for the scatter. Neighbor order within
+// a list depends on thread timing.
+
+typedef struct {
+    const char *data;
+    size_t size;
+    int numThreads;                 // threads actually started
+    bool started;                   // start gate, set once numThreads and barrier are final
+    pthread_barrier_t barrier;
+    bool failed;
+    // Per-thread parse output
+    int *src[MAX_THREADS];
+    int *dest[MAX_THREADS];
+    int *weight[MAX_THREADS];
+    long long count[MAX_THREADS];
+    int maxVertex[MAX_THREADS];
+    bool weighted[MAX_THREADS];
+    long long skipped[MAX_THREADS];     // malformed lines
+    long long blockSum[MAX_THREADS];
+    bool anyWeighted;
+    double parseTime;
+    // Shared CSR under construction
+    CSRGraph *csr;
+    long long *cursor;
+} EdgeListLoader;
+
+typedef struct {
+    EdgeListLoader *loader;
+    int id;
+} EdgeListWorker;
+
+// Move position forward to the start of the next line
+size_t alignToLineStart(const char *data, size_t size, size_t pos) {
+    if (pos == 0 || pos >= size) return pos < size ? pos : size;
+    while (pos < size && data[pos - 1] != '\n') pos++;
+    return pos;
+}
+
+// Parse non-negative decimal integer; returns false if no digits at *p
+bool parseNumber(const char **p, const char *end, long long *value) {
+    const char *q = *p;
+    long long result = 0;
+    
+    while (q < end && (*q == ' ' || *q == '\t' || *q == ',')) q++;
+    if (q == end || *q < '0' || *q > '9') {
+        *p = q;
+        return false;
+    }
+    while (q < end && *q >= '0' && *q <= '9') {
+        result = result * 10 + (*q - '0');
+        if (result > INT_MAX) result = INT_MAX; // saturate, rejected by caller
+        q++;
+    }
+    *p = q;
+    *value = result;
+    return true;
+}
+
+bool appendEdge(EdgeListLoader *loader, int t, long long *capacity, int u, int v, int w) {
+    if (loader->count[t] == *capacity) {
+        *capacity *= 2;
+        int *s = (int*)realloc(loader->src[t], *capacity * sizeof(int));
+        if (s != NULL) loader->src[t] = s;
+        int *d = (int*)realloc(loader->dest[t], *capacity * sizeof(int));
+        if (d != NULL) loader->dest[t] = d;
+        int *wt = (int*)realloc(loader->weight[t], *capacity * sizeof(int));
+        if (wt != NULL) loader->weight[t] = wt;
+        if (s == NULL || d == NULL || wt == NULL) return false;
+    }
+    long long i = loader->count[t]++;
+    loader->src[t][i] = u;
+    loader->dest[t][i] = v;
+    loader->weight[t][i] = w;
+    return true;
+}
+
+// Parse one slice of the file into the thread's edge arrays
+bool parseEdgeSlice(EdgeListLoader *loader, int t) {
+    size_t begin = alignToLineStart(loader->data, loader->size,
+                                    loader->size * t / loader->numThreads);
+    size_t finish = alignToLineStart(loader->data, loader->size,
+                                     loader->size * (t + 1) / loader->numThreads);
+    const char *p = loader->data + begin;
+    const char *end = loader->data + finish;
+    long long capacity = 1024 + (finish - begin) / 8;
+    
+    loader->count[t] = 0;
+    loader->maxVertex[t] = -1;
+    loader->weighted[t] = false;
+    loader->skipped[t] = 0;
+    loader->src[t] = (int*)malloc(capacity * sizeof(int));
+    loader->dest[t] = (int*)malloc(capacity * sizeof(int));
+    loader->weight[t] = (int*)malloc(capacity * sizeof(int));
+    if (loader->src[t] == NULL || loader->dest[t] == NULL || loader->weight[t] == NULL) {
+        return false;
+    }
+    
+    while (p < end) {
+        long long u, v, w = 1;
+        bool first = parseNumber(&p, end, &u);
+        bool blank = !first && (p == end || *p == '\n' || *p == '\r' || *p == '#' || *p == '%');
+        bool valid = first && parseNumber(&p, end, &v) &&
+                     u <= MAX_EDGE_LIST_VERTEX && v <= MAX_EDGE_LIST_VERTEX;
+        bool weighted = false;
+        
+        // A third field must be a weight below INT_MAX (saturated values
+        // are too large); '-' and any other text make the line malformed,
+        // only a trailing comment or the line end leave it unweighted
+        if (valid) {
+            weighted = parseNumber(&p, end, &w);
+            if (weighted) {
+                valid = w < INT_MAX;
+            } else {
+                valid = p == end || *p == '\n' || *p == '\r' || *p == '#' || *p == '%';
+            }
+        }
+        
+        if (valid) {
+            if (weighted) loader->weighted[t] = true;
+            if (!appendEdge(loader, t, &capacity, (int)u, (int)v, (int)w)) {
+                return false;
+            }
+            if (u > loader->maxVertex[t]) loader->maxVertex[t] = (int)u;
+            if (v > loader->maxVertex[t]) loader->maxVertex[t] = (int)v;
+        } else if (!blank) {
+            loader->skipped[t]++;
+        }
+        
+        // Skip the rest of the line (comments, blank and malformed lines)
+        while (p < end && *p != '\n') p++;
+        if (p < end) p++;
+    }
+    return true;
+}
+
+void *edgeListWorker(void *arg) {
+    EdgeListWorker *worker = (EdgeListWorker*)arg;
+    EdgeListLoader *loader = worker->loader;
+    int t = worker->id;
+    
+    // Wait until loadEdgeListParallel() knows how many threads could be started
+    while (!__atomic_load_n(&loader->started, __ATOMIC_ACQUIRE)) sched_yield();
+    int T = loader->numThreads;
+    
+    // Phase 1: parse
+    if (!parseEdgeSlice(loader, t)) {
+        loader->failed = true;
+    }
+    pthread_barrier_wait(&loader->barrier);
+    
+    // Phase 2: thread 0 sizes and allocates the CSR arrays
+    if (t == 0 && !loader->failed) {
+        CSRGraph *csr = loader->csr;
+        int maxVertex = -1;
+        bool weighted = false;
+        for (int k = 0; k < T; k++) {
+            if (loader->maxVertex[k] > maxVertex) maxVertex = loader->maxVertex[k];
+            if (loader->weighted[k]) weighted = true;
+        }
+        loader->parseTime = getTimeSeconds();
+        csr->numVertices = maxVertex + 1;
+        csr->offsets = (long long*)calloc(csr->numVertices + 1, sizeof(long long));
+        loader->cursor = (long long*)malloc((csr->numVertices + 1) * sizeof(long long));
+        loader->anyWeighted = weighted;
+        if (csr->offsets == NULL || loader->cursor == NULL) {
+            loader->failed = true;
+        }
+    }
+    pthread_barrier_wait(&loader->barrier);
+    if (loader->failed) return NULL;
+    
+    CSRGraph *csr = loader->csr;
+    int n = csr->numVertices;
+    
+    // Phase 3: count degrees into offsets[v + 1]
+    for (long long i = 0; i < loader->count[t]; i++) {
+        int u = loader->src[t][i], v = loader->dest[t][i];
+        if (u != v) {
+            __atomic_fetch_add(&csr->offsets[u + 1], 1, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&csr->offsets[v + 1], 1, __ATOMIC_RELAXED);
+        }
+    }
+    pthread_barrier_wait(&loader->barrier);
+    
+    // Phase 4: blocked prefix sum over offsets[1..n]
+    int blockBegin = 1 + (int)((long long)n * t / T);
+    int blockEnd = 1 + (int)((long long)n * (t + 1) / T);
+    long long sum = 0;
+    for (int v = blockBegin; v < blockEnd; v++) {
+        sum += csr->offsets[v];
+    }
+    loader->blockSum[t] = sum;
+    pthread_barrier_wait(&loader->barrier);
+    
+    long long running = 0;
+    for (int k = 0; k < t; k++) {
+        running += loader->blockSum[k];
+    }
+    for (int v = blockBegin; v < blockEnd; v++) {
+        running += csr->offsets[v];
+        csr->offsets[v] = running;
+    }
+    pthread_barrier_wait(&loader->barrier);
+    
+    // Scatter cursors start at offsets[v]
+    for (int v = blockBegin - 1; v < blockEnd - 1; v++) {
+        loader->cursor[v] = csr->offsets[v];
+    }
+    if (t == 0) {
+        long long arcs = csr->offsets[n];
+        csr->numEdges = arcs;
+        csr->neighbors = (int*)malloc((arcs > 0 ? arcs : 1) * sizeof(int));
+        if (csr->neighbors == NULL) loader->failed = true;
+        if (loader->anyWeighted) {
+            csr->weights = (int*)malloc((arcs > 0 ? arcs : 1) * sizeof(int));
+            if (csr->weights == NULL) loader->failed = true;
+        }
+    }
+    pthread_barrier_wait(&loader->barrier);
+    if (loader->failed) return NULL;
+    
+    // Phase 5: scatter both directions of every edge
+    for (long long i = 0; i < loader->count[t]; i++) {
+        int u = loader->src[t][i], v = loader->dest[t][i];
+        if (u == v) continue;
+        long long a = __atomic_fetch_add(&loader->cursor[u], 1, __ATOMIC_RELAXED);
+        long long b = __atomic_fetch_add(&loader->cursor[v], 1, __ATOMIC_RELAXED);
+        csr->neighbors[a] = v;
+        csr->neighbors[b] = u;
+        if (csr->weights != NULL) {
+            csr->weights[a] = loader->weight[t][i];
+            csr->weights[b] = loader->weight[t][i];
+        }
+    }
+    return NULL;
+}
+
+// Load text edge list ("src dst [weight]" per line, '#' or '%' comments) into CSR
+bool loadEdgeListParallel(CSRGraph *csr, const char *path, int numThreads, bool verbose) {
+    EdgeListLoader loader;
+    pthread_t threads[MAX_THREADS];
+    EdgeListWorker workers[MAX_THREADS];
+    
+    initCSRGraph(csr);
+    if (numThreads < 1) numThreads = 1;
+    if (numThreads > MAX_THREADS) numThreads = MAX_THREADS;
+    
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Cannot open file %s!\n", path);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        printf("Empty or unreadable file %s!\n", path);
+        close(fd);
+        return false;
+    }
+    size_t size = (size_t)info.st_size;
+    void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        printf("Cannot map file %s!\n", path);
+        return false;
+    }
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    
+    memset(&loader, 0, sizeof(loader));
+    loader.data = (const char*)mapping;
+    loader.size = size;
+    loader.numThreads = numThreads;
+    loader.csr = csr;
+    
+    double start = getTimeSeconds();
+    // The calling thread is worker 0; the file is cut into one slice per
+    // thread that actually started
+    for (int t = 0; t < numThreads; t++) {
+        workers[t].loader = &loader;
+        workers[t].id = t;
+    }
+    int running = 1;
+    while (running < numThreads &&
+           pthread_create(&threads[running], NULL, edgeListWorker, &workers[running]) == 0) {
+        running++;
+    }
+    if (running < numThreads) {
+        printf("Could only start %d of %d threads\n", running, numThreads);
+        numThreads = running;
+    }
+    loader.numThreads = numThreads;
+    pthread_barrier_init(&loader.barrier, NULL, numThreads);
+    __atomic_store_n(&loader.started, true, __ATOMIC_RELEASE);
+    
+    edgeListWorker(&workers[0]);
+    for (int t = 1; t < numThreads; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    pthread_barrier_destroy(&loader.barrier);
+    double finish = getTimeSeconds();
+    
+    long long inputEdges = 0, skipped = 0;
+    for (int t = 0; t < numThreads; t++) {
+        inputEdges += loader.count[t];
+        skipped += loader.skipped[t];
+        free(loader.src[t]);
+        free(loader.dest[t]);
+        free(loader.weight[t]);
+    }
+    free(loader.cursor);
+    munmap(mapping, size);
+    
+    if (loader.failed) {
+        printf("Memory allocation failed!\n");
+        freeCSRGraph(csr);
+        return false;
+    }
+    
+    if (verbose) {
+        double mb = size / 1e6;
+        printf("Read %.1f MB, %lld edges, %d vertices%s with %d thread(s)\n", mb, inputEdges,
+               csr->numVertices, csr->weights != NULL ? " (weighted)" : "", numThreads);
+        printf("Parse: %.3f s (%.1f MB/s), Build CSR: %.3f s, Total: %.3f s (%.1f MB/s)\n",
+               loader.parseTime - start, mb / (loader.parseTime - start),
+               finish - loader.parseTime, finish - start, mb / (finish - start));
+    }
+    if (skipped > 0) {
+        printf("Skipped %lld malformed line(s) (bad vertex id or weight)\n", skipped);
+    }
+    return true;
+}
+
+// Write every undirected edge once as "src dst [weight]" text
+bool saveEdgeListText(CSRGraph *csr, const char *path) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        printf("Cannot open file %s for writing!\n", path);
+        return false;
+    }
+    
+    fprintf(file, "# %d vertices\n", csr->numVertices);
+    for (int u = 0; u < csr->numVertices; u++) {
+        for (long long e = csr->offsets[u]; e < csr->offsets[u + 1]; e++) {
+            int v = csr->neighbors[e];
+            if (u > v) continue;
+            if (csr->weights != NULL) {
+                fprintf(file, "%d %d %d\n", u, v, csr->weights[e]);
+            } else {
+                fprintf(file, "%d %d\n", u, v);
+            }
+        }
+    }
+    
+    if (fclose(file) != 0) {
+        printf("Error writing file %s!\n", path);
+        return false;
+    }
+    return true;
+}
+
+// Binary graph files
+// A graph file is the CSR arrays written back to back after a small header.
+// Loading maps the file and points the CSR arrays into the mapping, so no
+// parsing or copying is done; pages are read on demand by the OS.
+
+// Write CSR graph to binary file
+bool saveCSRGraphBinary(CSRGraph *csr, const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        printf("Cannot open file %s for writing!\n", path);
+        return false;
+    }
+    
+    GraphFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, GRAPH_FILE_MAGIC, sizeof(header.magic));
+    header.version = GRAPH_FILE_VERSION;
+    header.flags = csr->weights != NULL ? GRAPH_FLAG_WEIGHTED : 0;
+    header.numVertices = csr->numVertices;
+    header.numEdges = csr->numEdges;
+    
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(csr->offsets, sizeof(long long), csr->numVertices + 1, file) ==
+                  (size_t)csr->numVertices + 1 &&
+              fwrite(csr->neighbors, sizeof(int), csr->numEdges, file) == (size_t)csr->numEdges;
+    if (ok && csr->weights != NULL) {
+        ok = fwrite(csr->weights, sizeof(int), csr->numEdges, file) == (size_t)csr->numEdges;
+    }
+    
+    if (fclose(file) != 0) ok = false;
+    if (!ok) {
+        printf("Error writing file %s!\n", path);
+    }
+    return ok;
+}
+
+// Offsets start at 0, never decrease and end at numEdges, and every
+// neighbor is a vertex. A mapped file is only used after this check, so a
+// corrupt one cannot make the traversals index outside the arrays.
+bool validCSRGraph(CSRGraph *csr) {
+    int n = csr->numVertices;
+    if (csr->offsets[0] != 0 || csr->offsets[n] != csr->numEdges) return false;
+    for (int v = 0; v < n; v++) {
+        if (csr->offsets[v + 1] < csr->offsets[v]) return false;
+    }
+    for (long long e = 0; e < csr->numEdges; e++) {
+        if (csr->neighbors[e] < 0 || csr->neighbors[e] >= n) return false;
+    }
+    return true;
+}
+
+// Map binary graph file and use its arrays in place (zero copy)
+bool loadCSRGraphBinary(CSRGraph *csr, const char *path) {
+    initCSRGraph(csr);
+    
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Cannot open file %s!\n", path);
+        return false;
+    }
+    
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(GraphFileHeader)) {
+        printf("Invalid graph file %s!\n", path);
+        close(fd);
+        return false;
+    }
+    
+    size_t size = (size_t)info.st_size;
+    void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping stays valid after the descriptor is closed
+    if (mapping == MAP_FAILED) {
+        printf("Cannot map file %s!\n", path);
+        return false;
+    }
+    
+    // Validate header and make sure every array lies inside the file
+    GraphFileHeader *header = (GraphFileHeader*)mapping;
+    bool weighted = (header->flags & GRAPH_FLAG_WEIGHTED) != 0;
+    bool valid = memcmp(header->magic, GRAPH_FILE_MAGIC, sizeof(header->magic)) == 0 &&
+                 header->version == GRAPH_FILE_VERSION &&
+                 header->numVertices >= 0 && header->numVertices < INT_MAX &&
+                 header->numEdges >= 0;
+    if (valid) {
+        // Compare the arc count with the bytes left instead of multiplying it
+        // out, which a corrupt count could overflow
+        size_t remaining = size - sizeof(GraphFileHeader);
+        size_t offsetBytes = ((size_t)header->numVertices + 1) * sizeof(long long);
+        size_t arcBytes = sizeof(int) * (weighted ? 2 : 1);
+        valid = offsetBytes <= remaining &&
+                (size_t)header->numEdges <= (remaining - offsetBytes) / arcBytes &&
+                (size_t)header->numEdges * arcBytes == remaining - offsetBytes;
+    }
+    if (valid) {
+        char *base = (char*)mapping + sizeof(GraphFileHeader);
+        csr->numVertices = (int)header->numVertices;
+        csr->numEdges = header->numEdges;
+        csr->offsets = (long long*)base;
+        csr->neighbors = (int*)(base + (header->numVertices + 1) * sizeof(long long));
+        csr->weights = weighted ? csr->neighbors + header->numEdges : NULL;
+        valid = validCSRGraph(csr);
+    }
+    if (!valid) {
+        printf("Invalid or unsupported graph file %s!\n", path);
+        munmap(mapping, size);
+        initCSRGraph(csr);
+        return false;
+    }
+    
+    csr->mapping = mapping;
+    csr->mappingSize = size;
+    return true;
+}
+
+// Convert text edge list to binary graph file
+bool convertEdgeListToBinary(const char *textPath, const char *binaryPath, int numThreads) {
+    CSRGraph csr;
+    
+    if (!loadEdgeListParallel(&csr, textPath, numThreads, true)) {
+        return false;
+    }
+    
+    double start = getTimeSeconds();
+    bool ok = saveCSRGraphBinary(&csr, binaryPath);
+    if (ok) {
+        printf("Write: %.3f s\n", getTimeSeconds() - start);
+    }
+    freeCSRGraph(&csr);
+    return ok;
+}
+
+// Parallel loop helper
+// Splits [0, n) into one contiguous range per thread and runs body on each.
+
+typedef void (*ParallelBody)(int begin, int end, int thread, void *context);
+
+typedef struct {
+    ParallelBody body;
+    void *context;
+    int begin;
+    int end;
+    int thread;
+} ParallelTask;
+
+void *parallelTaskRunner(void *arg) {
+    ParallelTask *task = (ParallelTask*)arg;
+    task->body(task->begin, task->end, task->thread, task->context);
+    return NULL;
+}
+
+void parallelFor(int n, int numThreads, ParallelBody body, void *context) {
+    pthread_t threads[MAX_THREADS];
+    ParallelTask tasks[MAX_THREADS];
+    
+    if (numThreads < 1) numThreads = 1;
+    if (numThreads > MAX_THREADS) numThreads = MAX_THREADS;
+    
+    for (int t = 0; t < numThreads; t++) {
+        tasks[t].body = body;
+        tasks[t].context = context;
+        tasks[t].begin = (int)((long long)n * t / numThreads);
+        tasks[t].end = (int)((long long)n * (t + 1) / numThreads);
+        tasks[t].thread = t;
+    }
+    
+    // The calling thread runs the first range itself
+    for (int t = 1; t < numThreads; t++) {
+        pthread_create(&threads[t], NULL, parallelTaskRunner, &tasks[t]);
+    }
+    parallelTaskRunner(&tasks[0]);
+    for (int t = 1; t < numThreads; t++) {
+        pthread_join(threads[t], NULL);
+    }
+}
+
+// Connected components
+// Both algorithms label every vertex with the smallest vertex id in its
+// component, so their results can be compared directly.
+
+bool initComponentsResult(ComponentsResult *result, int numVertices) {
+    result->numVertices = numVertices;
+    result->numComponents = 0;
+    result->label = (int*)malloc(numVertices * sizeof(int));
+    result->representatives = NULL;
+    result->sizes = NULL;
+    if (result->label == NULL) {
+        printf("Memory allocation failed!\n");
+        return false;
+    }
+    return true;
+}
+
+void freeComponentsResult(ComponentsResult *result) {
+    free(result->label);
+    free(result->representatives);
+    free(result->sizes);
+    result->label = result->representatives = result->sizes = NULL;
+    result->numComponents = 0;
+}
+
+// Build representative and size lists from the labels
+bool finalizeComponents(ComponentsResult *result) {
+    int n = result->numVertices;
+    int *count = (int*)calloc(n > 0 ? n : 1, sizeof(int));
+    if (count == NULL) {
+        printf("Memory allocation failed!\n");
+        return false;
+    }
+    
+    int components = 0;
+    for (int v = 0; v < n; v++) {
+        if (count[result->label[v]]++ == 0) components++;
+    }
+    
+    free(result->representatives);
+    free(result->sizes);
+    result->representatives = (int*)malloc((components > 0 ? components : 1) * sizeof(int));
+    result->sizes = (int*)malloc((components > 0 ? components : 1) * sizeof(int));
+    if (result->representatives == NULL || result->sizes == NULL) {
+        printf("Memory allocation failed!\n");
+        free(count);
+        return false;
+    }
+    
+    int c = 0;
+    for (int v = 0; v < n; v++) {
+        if (count[v] > 0) {
+            result->representatives[c] = v;
+            result->sizes[c] = count[v];
+            c++;
+        }
+    }
+    result->numComponents = components;
+    free(count);
+    return true;
+}
+
+// Reference: one BFS per unvisited vertex
+bool bfsComponents(CSRGraph *csr, ComponentsResult *result) {
+    int n = csr->numVertices;
+    int *queue = (int*)malloc((n > 0 ? n : 1) * sizeof(int));
+    if (queue == NULL) {
+        printf("Memory allocation failed!\n");
+        return false;
+    }
+    
+    for (int v = 0; v < n; v++) {
+        result->label[v] = -1;
+    }
+    for (int s = 0; s < n; s++) {
+        if (result->label[s] != -1) continue;
+        int head = 0, tail = 0;
+        result->label[s] = s;
+        queue[tail++] = s;
+        while (head < tail) {
+            int u = queue[head++];
+            for (long long e = csr->offsets[u]; e < csr->offsets[u + 1]; e++) {
+                int v = csr->neighbors[e];
+                if (result->label[v] == -1) {
+                    result->label[v] = s;
+                    queue[tail++] = v;
+                }
+            }
+        }
+    }
+    
+    free(queue);
+    return finalizeComponents(result);
+}
+
+// Lock-free union-find
+// parent[] links always point from a larger to a smaller vertex id, so every
+// root is the smallest vertex of its tree. Roots are linked with
+// compare-and-swap and paths are halved with compare-and-swap as well; a
+// failed CAS only means another thread already improved that pointer.
+
+int findRoot(int *parent, int v) {
+    while (1) {
+        int p = __atomic_load_n(&parent[v], __ATOMIC_RELAXED);
+        int gp = __atomic_load_n(&parent[p], __ATOMIC_RELAXED);
+        if (p == gp) return p;
+        // Path halving: point v at its grandparent
+        __atomic_compare_exchange_n(&parent[v], &p, gp, false,
+                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+        v = gp;
+    }
+}
+
+void unionVertices(int *parent, int u, int v) {
+    while (1) {
+        int ru = findRoot(parent, u);
+        int rv = findRoot(parent, v);
+        if (ru == rv) return;
+        int high = ru > rv ? ru : rv;
+        int low = ru > rv ? rv : ru;
+        int expected = high;
+        // Succeeds only if high is still a root
+        if (__atomic_compare_exchange_n(&parent[high], &expected, low, false,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            return;
+        }
+    }
+}
+
+typedef struct {
+    CSRGraph *csr;
+    int *parent;
+    int round;              // neighbor index linked in the sampling phase
+    int skipComponent;      // largest sampled component, -1 for none
+    bool changed[MAX_THREADS];
+} ComponentsContext;
+
+void initParentBody(int begin, int end, int thread, void *context) {
+    ComponentsContext *ctx = (ComponentsContext*)context;
+    (void)thread;
+    for (int v = begin; v < end; v++) {
+        ctx->parent[v] = v;
+    }
+}
+
+void linkNeighborRoundBody(int begin, int end, int thread, void *context) {
+    ComponentsContext *ctx = (ComponentsContext*)context;
+    CSRGraph *csr = ctx->csr;
+    (void)thread;
+    for (int v = begin; v < end; v++) {
+        long long e = csr->offsets[v] + ctx->round;
+        if (e < csr->offsets[v + 1]) {
+            unionVertices(ctx->parent, v, csr->neighbors[e]);
+        }
+    }
+}
+
+void compressBody(int begin, int end, int thread, void *context) {
+    ComponentsContext *ctx = (ComponentsContext*)context;
+    (void)thread;
+    for (int v = begin; v < end; v++) {
+        int root = findRoot(ctx->parent, v);
+        __atomic_store_n(&ctx->parent[v], root, __ATOMIC_RELAXED);
+    }
+}
+
+void linkRemainingBody(int begin, int end, int thread, void *context) {
+    ComponentsContext *ctx = (ComponentsContext*)context;
+    CSRGraph *csr = ctx->csr;
+    (void)thread;
+    for (int v = begin; v < end; v++) {
+        // Vertices already in the giant component are skipped; their edges are
+        // also stored at the other endpoint, which still links them
+        if (findRoot(ctx->parent, v) == ctx->skipComponent) continue;
+        for (long long e = csr->offsets[v] + ctx->round; e < csr->offsets[v + 1]; e++) {
+            unionVertices(ctx->parent, v, csr->neighbors[e]);
+        }
+    }
+}
+
+// Afforest-style connected components with lock-free union-find
+// 1. Link every vertex to its first few neighbors (usually enough to form the
+//    giant component) and compress
+// 2. Sample vertices to find the most common root
+// 3. Link remaining edges, skipping vertices already in that component
+bool unionFindComponents(CSRGraph *csr, ComponentsResult *result, int numThreads) {
+    ComponentsContext ctx;
+    int n = csr->numVertices;
+    
+    ctx.csr = csr;
+    ctx.parent = result->label;
+    ctx.skipComponent = -1;
+    parallelFor(n, numThreads, initParentBody, &ctx);
+    
+    for (ctx.round = 0; ctx.round < CC_NEIGHBOR_ROUNDS; ctx.round++) {
+        parallelFor(n, numThreads, linkNeighborRoundBody, &ctx);
+        parallelFor(n, numThreads, compressBody, &ctx);
+    }
+    
+    // Most frequent root among sampled vertices (sorted sample, longest run)
+    if (n > 0) {
+        int samples[CC_SAMPLE_SIZE];
+        unsigned long long state = 42;
+        for (int i = 0; i < CC_SAMPLE_SIZE; i++) {
+            samples[i] = ctx.parent[nextRandom(&state) % n];
+        }
+        for (int i = 1; i < CC_SAMPLE_SIZE; i++) {
+            int key = samples[i], j = i - 1;
+            while (j >= 0 && samples[j] > key) {
+                samples[j + 1] = samples[j];
+                j--;
+            }
+            samples[j + 1] = key;
+        }
+        int bestRun = 0;
+        for (int i = 0, run = 1; i < CC_SAMPLE_SIZE; i++, run++) {
+            if (i + 1 == CC_SAMPLE_SIZE || samples[i + 1] != samples[i]) {
+                if (run > bestRun) {
+                    bestRun = run;
+                    ctx.skipComponent = samples[i];
+                }
+                run = 0;
+            }
+        }
+    }
+    
+    parallelFor(n, numThreads, linkRemainingBody, &ctx);
+    parallelFor(n, numThreads, compressBody, &ctx);
+    return finalizeComponents(result);
+}
+
+void labelPropagationBody(int begin, int end, int thread, void *context) {
+    ComponentsContext *ctx = (ComponentsContext*)context;
+    CSRGraph *csr = ctx->csr;
+    int *label = ctx->parent;
+    bool changed = false;
+    
+    for (int v = begin; v < end; v++) {
+        int best = __atomic_load_n(&label[v], __ATOMIC_RELAXED);
+        for (long long e = csr->offsets[v]; e < csr->offsets[v + 1]; e++) {
+            int l = __atomic_load_n(&label[csr->neighbors[e]], __ATOMIC_RELAXED);
+            if (l < best) best = l;
+        }
+        // Shortcut: the vertex named by the label may already know a smaller one
+        int jumped = __atomic_load_n(&label[best], __ATOMIC_RELAXED);
+        if (jumped < best) best = jumped;
+        if (best < __atomic_load_n(&label[v], __ATOMIC_RELAXED)) {
+            __atomic_store_n(&label[v], best, __ATOMIC_RELAXED);
+            changed = true;
+        }
+    }
+    ctx->changed[thread] = changed;
+}
+
+// Parallel label propagation: every vertex repeatedly takes the minimum
+// label of its neighborhood until no label changes
+bool labelPropagationComponents(CSRGraph *csr, ComponentsResult *result, int numThreads,
+                                int *iterations) {
+    ComponentsContext ctx;
+    int n = csr->numVertices;
+    
+    if (numThreads < 1) numThreads = 1;
+    if (numThreads > MAX_THREADS) numThreads = MAX_THREADS;
+    ctx.csr = csr;
+    ctx.parent = result->label;
+    parallelFor(n, numThreads, initParentBody, &ctx);
+    
+    *iterations = 0;
+    bool changed = true;
+    while (changed) {
+        parallelFor(n, numThreads, labelPropagationBody, &ctx);
+        (*iterations)++;
+        changed = false;
+        for (int t = 0; t < numThreads; t++) {
+            if (ctx.changed[t]) changed = true;
+        }
+    }
+    return finalizeComponents(result);
+}
+
+// Print component count, largest components and (for small graphs) labels
+void displayComponents(ComponentsResult *result) {
+    int largest = 0;
+    for (int c = 1; c < result->numComponents; c++) {
+        if (result->sizes[c] > result->sizes[largest]) largest = c;
+    }
+    printf("Components: %d\n", result->numComponents);
+    if (result->numComponents > 0) {
+        printf("Largest component: representative %d, size %d\n",
+               result->representatives[largest], result->sizes[largest]);
+    }
+    if (result->numVertices <= MAX_VERTICES) {
+        printf("Representative\tSize\n");
+        for (int c = 0; c < result->numComponents; c++) {
+            printf("%d\t\t%d\n", result->representatives[c], result->sizes[c]);
+        }
+        printf("Vertex labels: ");
+        for (int v = 0; v < result->numVertices; v++) {
+            printf("%d ", result->label[v]);
+        }
+        printf("\n");
+    }
+}
+
+bool sameComponents(ComponentsResult *a, ComponentsResult *b) {
+    if (a->numComponents != b->numComponents) return false;
+    for (int v = 0; v < a->numVertices; v++) {
+        if (a->label[v] != b->label[v]) return false;
+    }
+    return true;
+}
+
+// Compare BFS, union-find and label propagation components on an R-MAT graph
+void benchmarkComponents(int scale, int edgeFactor, int numThreads) {
+    CSRGraph csr;
+    ComponentsResult reference, result;
+    double start;
+    int iterations;
+    
+    printf("\nGenerating R-MAT graph (scale %d, edge factor %d)...\n", scale, edgeFactor);
+    if (!generateRMATGraph(&csr, scale, edgeFactor, 12345)) {
         return;
     }
+    printf("Vertices: %d, Edges: %lld\n", csr.numVertices, csr.numEdges / 2);
     
-    // Since it's undirected, add edge in both directions
-    g->adjMatrix[src][dest] = 1;
-    g->adjMatrix[dest][src] = 1;
+    if (!initComponentsResult(&reference, csr.numVertices)) {
+        freeCSRGraph(&csr);
+        return;
+    }
+    if (!initComponentsResult(&result, csr.numVertices)) {
+        freeComponentsResult(&reference);
+        freeCSRGraph(&csr);
+        return;
+    }
+    
+    start = getTimeSeconds();
+    bfsComponents(&csr, &reference);
+    double bfsTime = getTimeSeconds() - start;
+    printf("\nAlgorithm\t\tTime(s)\t\tComponents\tCheck\n");
+    printf("BFS per component\t%.6f\t%d\t\t-\n", bfsTime, reference.numComponents);
+    
+    start = getTimeSeconds();
+    unionFindComponents(&csr, &result, numThreads);
+    double t = getTimeSeconds() - start;
+    printf("Union-find (%d thr)\t%.6f\t%d\t\t%s\n", numThreads, t, result.numComponents,
+           sameComponents(&reference, &result) ? "OK" : "MISMATCH");
+    
+    start = getTimeSeconds();
+    labelPropagationComponents(&csr, &result, numThreads, &iterations);
+    t = getTimeSeconds() - start;
+    printf("Label prop. (%d thr)\t%.6f\t%d\t\t%s (%d iterations)\n", numThreads, t,
+           result.numComponents, sameComponents(&reference, &result) ? "OK" : "MISMATCH",
+           iterations);
+    
+    displayComponents(&reference);
+    freeComponentsResult(&reference);
+    freeComponentsResult(&result);
+    freeCSRGraph(&csr);
 }
 
-// Display adjacency matrix
-void displayGraph(Graph *g) {
-    printf("\nAdjacency Matrix:\n");
-    printf("   ");
-    for (int i = 0; i < g->numVertices; i++) {
-        printf("%2d ", i);
+// Vertex reordering for locality
+// A permutation order[] (new id -> old id) is computed so that vertices that
+// are visited together get nearby ids. The graph is relabeled once; results
+// computed on the relabeled graph are translated back with the stored maps.
+
+bool initVertexOrdering(VertexOrdering *ordering, int numVertices) {
+    ordering->numVertices = numVertices;
+    ordering->order = (int*)malloc((numVertices > 0 ? numVertices : 1) * sizeof(int));
+    ordering->newId = (int*)malloc((numVertices > 0 ? numVertices : 1) * sizeof(int));
+    if (ordering->order == NULL || ordering->newId == NULL) {
+        printf("Memory allocation failed!\n");
+        freeVertexOrdering(ordering);
+        return false;
+    }
+    return true;
+}
+
+void freeVertexOrdering(VertexOrdering *ordering) {
+    free(ordering->order);
+    free(ordering->newId);
+    ordering->order = ordering->newId = NULL;
+}
+
+// Degree sort: highest degree first (counting sort, stable)
+bool computeDegreeOrder(CSRGraph *csr, VertexOrdering *ordering) {
+    int n = csr->numVertices;
+    int maxDegree = 0;
+    for (int v = 0; v < n; v++) {
+        int d = (int)(csr->offsets[v + 1] - csr->offsets[v]);
+        if (d > maxDegree) maxDegree = d;
     }
-    printf("\n");
     
-    for (int i = 0; i < g->numVertices; i++) {
-        printf("%2d ", i);
-        for (int j = 0; j < g->numVertices; j++) {
-            printf("%2d ", g->adjMatrix[i][j]);
+    // Bucket start positions, bucket 0 holds the highest degree
+    int *start = (int*)calloc(maxDegree + 2, sizeof(int));
+    if (start == NULL) {
+        printf("Memory allocation failed!\n");
+        return false;
+    }
+    for (int v = 0; v < n; v++) {
+        start[maxDegree - (csr->offsets[v + 1] - csr->offsets[v]) + 1]++;
+    }
+    for (int d = 0; d <= maxDegree; d++) {
+        start[d + 1] += start[d];
+    }
+    for (int v = 0; v < n; v++) {
+        ordering->order[start[maxDegree - (csr->offsets[v + 1] - csr->offsets[v])]++] = v;
+    }
+    free(start);
+    return true;
+}
+
+// Append the BFS order from root to order[] starting at position count;
+// byDegree visits neighbors in increasing degree (Cuthill-McKee)
+int appendBFSOrder(CSRGraph *csr, int root, bool *visited, int *order, int count,
+                   bool byDegree) {
+    int head = count;
+    visited[root] = true;
+    order[count++] = root;
+    
+    while (head < count) {
+        int u = order[head++];
+        int first = count;
+        for (long long e = csr->offsets[u]; e < csr->offsets[u + 1]; e++) {
+            int v = csr->neighbors[e];
+            if (!visited[v]) {
+                visited[v] = true;
+                order[count++] = v;
+            }
+        }
+        if (byDegree) {
+            // Insertion sort of the newly added children by degree
+            for (int i = first + 1; i < count; i++) {
+                int key = order[i];
+                long long keyDegree = csr->offsets[key + 1] - csr->offsets[key];
+                int j = i - 1;
+                while (j >= first &&
+                       csr->offsets[order[j] + 1] - csr->offsets[order[j]] > keyDegree) {
+                    order[j + 1] = order[j];
+                    j--;
+                }
+                order[j + 1] = key;
+            }
         }
-        printf("\n");
     }
+    return count;
 }
 
-// Operations for BFS
-void initQueue(Queue *q) {
-    q->front = -1;
-    q->rear = -1;
+// BFS order: components in order of their smallest vertex
+bool computeBFSOrder(CSRGraph *csr, VertexOrdering *ordering) {
+    int n = csr->numVertices;
+    bool *visited = (bool*)calloc(n > 0 ? n : 1, sizeof(bool));
+    if (visited == NULL) {
+        printf("Memory allocation failed!\n");
+        return false;
+    }
+    int count = 0;
+    for (int v = 0; v < n; v++) {
+        if (!visited[v]) {
+            count = appendBFSOrder(csr, v, visited, ordering->order, count, false);
+        }
+    }
+    free(visited);
+    return true;
 }
 
-bool isQueueEmpty(Queue *q) {
-    return q->front == -1;
+// Reverse Cuthill-McKee: BFS from a low degree vertex of each component,
+// children in increasing degree, whole order reversed at the end
+bool computeRCMOrder(CSRGraph *csr, VertexOrdering *ordering) {
+    int n = csr->numVertices;
+    bool *visited = (bool*)calloc(n > 0 ? n : 1, sizeof(bool));
+    VertexOrdering byDegree;
+    if (visited == NULL || !initVertexOrdering(&byDegree, n)) {
+        printf("Memory allocation failed!\n");
+        free(visited);
+        return false;
+    }
+    
+    // Start vertices tried from lowest degree upwards
+    if (!computeDegreeOrder(csr, &byDegree)) {
+        freeVertexOrdering(&byDegree);
+        free(visited);
+        return false;
+    }
+    int count = 0;
+    for (int i = n - 1; i >= 0; i--) {
+        int v = byDegree.order[i];
+        if (!visited[v]) {
+            count = appendBFSOrder(csr, v, visited, ordering->order, count, true);
+        }
+    }
+    
+    for (int i = 0, j = n - 1; i < j; i++, j--) {
+        int temp = ordering->order[i];
+        ordering->order[i] = ordering->order[j];
+        ordering->order[j] = temp;
+    }
+    freeVertexOrdering(&byDegree);
+    free(visited);
+    return true;
 }
 
-void enqueue(Queue *q, int value) {
-    if (q->front == -1) {
-        q->front = 0;
+// Build the relabeled graph: vertex i of out is vertex order[i] of csr.
+// Vertices are scattered into their neighbors' lists in increasing new id,
+// which is the transpose of the graph; for an undirected graph that is the
+// graph itself with every neighbor list already sorted.
+bool relabelGraph(CSRGraph *csr, VertexOrdering *ordering, CSRGraph *out) {
+    int n = csr->numVertices;
+    initCSRGraph(out);
+    
+    for (int i = 0; i < n; i++) {
+        ordering->newId[ordering->order[i]] = i;
     }
-    q->rear++;
-    q->items[q->rear] = value;
+    
+    out->offsets = (long long*)malloc((n + 1) * sizeof(long long));
+    out->neighbors = (int*)malloc((csr->numEdges > 0 ? csr->numEdges : 1) * sizeof(int));
+    long long *pos = (long long*)malloc((n > 0 ? n : 1) * sizeof(long long));
+    if (csr->weights != NULL) {
+        out->weights = (int*)malloc((csr->numEdges > 0 ? csr->numEdges : 1) * sizeof(int));
+    }
+    if (out->offsets == NULL || out->neighbors == NULL || pos == NULL ||
+        (csr->weights != NULL && out->weights == NULL)) {
+        printf("Memory allocation failed!\n");
+        free(pos);
+        freeCSRGraph(out);
+        return false;
+    }
+    
+    out->offsets[0] = 0;
+    for (int i = 0; i < n; i++) {
+        int old = ordering->order[i];
+        pos[i] = out->offsets[i];
+        out->offsets[i + 1] = out->offsets[i] + csr->offsets[old + 1] - csr->offsets[old];
+    }
+    
+    for (int i = 0; i < n; i++) {
+        int old = ordering->order[i];
+        for (long long e = csr->offsets[old]; e < csr->offsets[old + 1]; e++) {
+            long long slot = pos[ordering->newId[csr->neighbors[e]]]++;
+            out->neighbors[slot] = i;
+            if (out->weights != NULL) out->weights[slot] = csr->weights[e];
+        }
+    }
+    
+    free(pos);
+    out->numVertices = n;
+    out->numEdges = csr->numEdges;
+    return true;
 }
 
-int dequeue(Queue *q) {
-    int item = q->items[q->front];
-    q->front++;
-    if (q->front > q->rear) {
-        q->front = q->rear = -1;
+// Translate a BFS result on the relabeled graph back to original ids
+void translateBFSResult(BFSResult *relabeled, VertexOrdering *ordering, BFSResult *original) {
+    for (int i = 0; i < ordering->numVertices; i++) {
+        int old = ordering->order[i];
+        original->depth[old] = relabeled->depth[i];
+        original->parent[old] = relabeled->parent[i] == -1 ? -1 :
+                                ordering->order[relabeled->parent[i]];
     }
-    return item;
+    original->topDownSteps = relabeled->topDownSteps;
+    original->bottomUpSteps = relabeled->bottomUpSteps;
+}
+
+// Write order[] (new id -> original id) as an order file, the companion of
+// a relabeled graph file
+bool saveVertexOrdering(VertexOrdering *ordering, const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        printf("Cannot open file %s for writing!\n", path);
+        return false;
+    }
+    
+    OrderFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ORDER_FILE_MAGIC, sizeof(header.magic));
+    header.version = ORDER_FILE_VERSION;
+    header.numVertices = ordering->numVertices;
+    
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(ordering->order, sizeof(int), ordering->numVertices, file) ==
+                  (size_t)ordering->numVertices;
+    
+    if (fclose(file) != 0) ok = false;
+    if (!ok) {
+        printf("Error writing file %s!\n", path);
+    }
+    return ok;
 }
 
-// Operations for DFS
-void initStack(Stack *s) {
-    s->top = -1;
+// Hardware cache miss counter (Linux perf events); -1 if unavailable
+int openCacheMissCounter() {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
 }
 
-bool isStackEmpty(Stack *s) {
-    return s->top == -1;
+void startCacheMissCounter(int fd) {
+    if (fd < 0) return;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
 }
 
-void push(Stack *s, int value) {
-    s->items[++(s->top)] = value;
+long long stopCacheMissCounter(int fd) {
+    long long count = -1;
+    if (fd < 0) return -1;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(fd, &count, sizeof(count)) != sizeof(count)) return -1;
+    return count;
 }
 
-int pop(Stack *s) {
-    return s->items[(s->top)--];
+void printCacheMisses(long long misses) {
+    if (misses < 0) {
+        printf("n/a\t\t");
+    } else {
+        printf("%-12lld\t", misses);
+    }
 }
 
-// Breadth First Search (BFS)
-void BFS(Graph *g, int startVertex) {
-    if (startVertex >= g->numVertices || startVertex < 0) {
-        printf("Invalid start vertex!\n");
+// Time BFS and DFS on the original graph and after each reordering
+void benchmarkReordering(int scale, int edgeFactor) {
+    CSRGraph csr, relabeled;
+    // Zeroed so that all of them can be freed if only some were allocated
+    BFSResult result = {0}, translated = {0}, reference = {0};
+    DFSResult dfsResult = {0};
+    VertexOrdering ordering = {0};
+    const char *names[] = {"Original", "Degree sort", "BFS order", "RCM"};
+    
+    printf("\nGenerating R-MAT graph (scale %d, edge factor %d)...\n", scale, edgeFactor);
+    if (!generateRMATGraph(&csr, scale, edgeFactor, 12345)) {
         return;
     }
+    int n = csr.numVertices;
+    printf("Vertices: %d, Edges: %lld\n", n, csr.numEdges / 2);
     
-    bool visited[MAX_VERTICES] = {false};
-    Queue q;
-    initQueue(&q);
+    if (!initBFSResult(&result, n) || !initBFSResult(&translated, n) ||
+        !initBFSResult(&reference, n) || !initDFSResult(&dfsResult, n) ||
+        !initVertexOrdering(&ordering, n)) {
+        freeVertexOrdering(&ordering);
+        freeDFSResult(&dfsResult);
+        freeBFSResult(&result);
+        freeBFSResult(&translated);
+        freeBFSResult(&reference);
+        freeCSRGraph(&csr);
+        return;
+    }
     
-    printf("\nBFS Traversal starting from vertex %d: ", startVertex);
+    int counter = openCacheMissCounter();
+    if (counter < 0) {
+        printf("Hardware cache miss counter not available, reporting time only\n");
+    }
     
-    visited[startVertex] = true;
-    enqueue(&q, startVertex);
+    // Source: highest degree vertex in original ids
+    int source = 0;
+    for (int v = 1; v < n; v++) {
+        if (csr.offsets[v + 1] - csr.offsets[v] > csr.offsets[source + 1] - csr.offsets[source]) {
+            source = v;
+        }
+    }
+    bool reached = topDownBFS(&csr, source, &reference);
     
-    while (!isQueueEmpty(&q)) {
-        int currentVertex = dequeue(&q);
-        printf("%d ", currentVertex);
+    printf("\nOrdering\tReorder(s)\tBFS(s)\t\tBFS misses\tDir-opt(s)\tDFS(s)\t\tDFS misses\tCheck\n");
+    for (int method = 0; reached && method < 4; method++) {
+        double start = getTimeSeconds();
+        bool ordered = true;
+        if (method == 0) {
+            for (int i = 0; i < n; i++) ordering.order[i] = i;
+        } else if (method == 1) {
+            ordered = computeDegreeOrder(&csr, &ordering);
+        } else if (method == 2) {
+            ordered = computeBFSOrder(&csr, &ordering);
+        } else {
+            ordered = computeRCMOrder(&csr, &ordering);
+        }
+        if (!ordered || !relabelGraph(&csr, &ordering, &relabeled)) break;
+        double reorderTime = getTimeSeconds() - start;
+        int newSource = ordering.newId[source];
         
-        // Check all adjacent vertices
-        for (int i = 0; i < g->numVertices; i++) {
-            if (g->adjMatrix[currentVertex][i] == 1 && !visited[i]) {
-                visited[i] = true;
-                enqueue(&q, i);
-            }
+        startCacheMissCounter(counter);
+        start = getTimeSeconds();
+        bool traversed = topDownBFS(&relabeled, newSource, &result);
+        double bfsTime = getTimeSeconds() - start;
+        long long bfsMisses = stopCacheMissCounter(counter);
+        if (!traversed) {
+            freeCSRGraph(&relabeled);
+            break;
+        }
+        
+        translateBFSResult(&result, &ordering, &translated);
+        bool ok = true;
+        for (int v = 0; v < n; v++) {
+            if (translated.depth[v] != reference.depth[v]) ok = false;
         }
+        
+        start = getTimeSeconds();
+        if (!directionOptimizingBFS(&relabeled, newSource, &result)) {
+            freeCSRGraph(&relabeled);
+            break;
+        }
+        double doTime = getTimeSeconds() - start;
+        
+        startCacheMissCounter(counter);
+        start = getTimeSeconds();
+        DFSForest(&relabeled, &dfsResult, NULL);
+        double dfsTime = getTimeSeconds() - start;
+        long long dfsMisses = stopCacheMissCounter(counter);
+        
+        printf("%-12s\t%.6f\t%.6f\t", names[method], reorderTime, bfsTime);
+        printCacheMisses(bfsMisses);
+        printf("%.6f\t%.6f\t", doTime, dfsTime);
+        printCacheMisses(dfsMisses);
+        printf("%s\n", ok ? "OK" : "MISMATCH");
+        freeCSRGraph(&relabeled);
     }
-    printf("\n");
+    
+    if (counter >= 0) close(counter);
+    freeVertexOrdering(&ordering);
+    freeDFSResult(&dfsResult);
+    freeBFSResult(&result);
+    freeBFSResult(&translated);
+    freeBFSResult(&reference);
+    freeCSRGraph(&csr);
 }
 
-// Depth First Search (DFS) 
-void DFS(Graph *g, int startVertex) {
-    if (startVertex >= g->numVertices || startVertex < 0) {
-        printf("Invalid start vertex!\n");
-        return;
+// Multi-source BFS with bit-parallel frontiers (MS-BFS)
+// Up to MSBFS_BATCH sources run together. Each vertex keeps a bit mask of the
+// sources that have seen it and of the sources whose frontier it is on, so
+// one scan of a neighbor list advances every source at once. The masks are
+// MSBFS_WORDS 64-bit words whose loops the compiler vectorizes.
+
+bool initMultiSourceBFSResult(MultiSourceBFSResult *result, int numSources, int numVertices) {
+    result->numSources = numSources;
+    result->numVertices = numVertices;
+    result->sources = (int*)malloc((numSources > 0 ? numSources : 1) * sizeof(int));
+    result->distance = (int*)malloc(((size_t)numSources * numVertices > 0 ?
+                                     (size_t)numSources * numVertices : 1) * sizeof(int));
+    if (result->sources == NULL || result->distance == NULL) {
+        printf("Memory allocation failed!\n");
+        freeMultiSourceBFSResult(result);
+        return false;
     }
+    return true;
+}
+
+void freeMultiSourceBFSResult(MultiSourceBFSResult *result) {
+    free(result->sources);
+    free(result->distance);
+    result->sources = result->distance = NULL;
+}
+
+// Distance from source number s to vertex v (-1 if unreachable)
+int multiSourceDistance(MultiSourceBFSResult *result, int s, int v) {
+    return result->distance[(size_t)s * result->numVertices + v];
+}
+
+// Run one batch of at most MSBFS_BATCH sources starting at sources[first]
+void multiSourceBFSBatch(CSRGraph *csr, MultiSourceBFSResult *result, int first, int count,
+                         SourceMask *seen, SourceMask *visit, SourceMask *visitNext) {
+    int n = csr->numVertices;
     
-    bool visited[MAX_VERTICES] = {false};
-    Stack s;
-    initStack(&s);
-    
-    printf("\nDFS Traversal starting from vertex %d: ", startVertex);
-    
-    push(&s, startVertex);
+    memset(seen, 0, n * sizeof(SourceMask));
+    memset(visit, 0, n * sizeof(SourceMask));
+    memset(visitNext, 0, n * sizeof(SourceMask));
+    for (int s = 0; s < count; s++) {
+        int *dist = result->distance + (size_t)(first + s) * n;
+        for (int v = 0; v < n; v++) {
+            dist[v] = -1;
+        }
+        int src = result->sources[first + s];
+        seen[src].word[s / 64] |= 1ULL << (s % 64);
+        visit[src].word[s / 64] |= 1ULL << (s % 64);
+        dist[src] = 0;
+    }
     
-    while (!isStackEmpty(&s)) {
-        int currentVertex = pop(&s);
+    bool active = count > 0;
+    for (int level = 1; active; level++) {
+        active = false;
         
-        if (!visited[currentVertex]) {
-            printf("%d ", currentVertex);
-            visited[currentVertex] = true;
+        // Shared neighbor scan: push each vertex's frontier bits to its neighbors
+        for (int u = 0; u < n; u++) {
+            unsigned long long any = 0;
+            for (int w = 0; w < MSBFS_WORDS; w++) {
+                any |= visit[u].word[w];
+            }
+            if (any == 0) continue;
+            for (long long e = csr->offsets[u]; e < csr->offsets[u + 1]; e++) {
+                int v = csr->neighbors[e];
+                for (int w = 0; w < MSBFS_WORDS; w++) {
+                    visitNext[v].word[w] |= visit[u].word[w];
+                }
+            }
         }
         
-        // Push all adjacent unvisited vertices to stack
-        // Push in reverse order to maintain left-to-right traversal
-        for (int i = g->numVertices - 1; i >= 0; i--) {
-            if (g->adjMatrix[currentVertex][i] == 1 && !visited[i]) {
-                push(&s, i);
+        // Keep only sources that reach v for the first time and record distances
+        for (int v = 0; v < n; v++) {
+            for (int w = 0; w < MSBFS_WORDS; w++) {
+                unsigned long long fresh = visitNext[v].word[w] & ~seen[v].word[w];
+                visitNext[v].word[w] = fresh;
+                if (fresh == 0) continue;
+                seen[v].word[w] |= fresh;
+                active = true;
+                while (fresh) {
+                    int s = w * 64 + __builtin_ctzll(fresh);
+                    result->distance[(size_t)(first + s) * n + v] = level;
+                    fresh &= fresh - 1;
+                }
             }
         }
+        
+        SourceMask *temp = visit;
+        visit = visitNext;
+        visitNext = temp;
+        memset(visitNext, 0, n * sizeof(SourceMask));
     }
-    printf("\n");
 }
 
-// DFS Recursive implementation
-void DFSRecursiveUtil(Graph *g, int vertex, bool visited[]) {
-    visited[vertex] = true;
-    printf("%d ", vertex);
+// BFS distances from every source; sources beyond MSBFS_BATCH run in batches
+bool multiSourceBFS(CSRGraph *csr, const int sources[], int numSources,
+                    MultiSourceBFSResult *result) {
+    int n = csr->numVertices;
+    SourceMask *seen = (SourceMask*)malloc((n > 0 ? n : 1) * sizeof(SourceMask));
+    SourceMask *visit = (SourceMask*)malloc((n > 0 ? n : 1) * sizeof(SourceMask));
+    SourceMask *visitNext = (SourceMask*)malloc((n > 0 ? n : 1) * sizeof(SourceMask));
     
-    // Recur for all adjacent vertices
-    for (int i = 0; i < g->numVertices; i++) {
-        if (g->adjMatrix[vertex][i] == 1 && !visited[i]) {
-            DFSRecursiveUtil(g, i, visited);
+    if (seen == NULL || visit == NULL || visitNext == NULL) {
+        printf("Memory allocation failed!\n");
+        free(seen);
+        free(visit);
+        free(visitNext);
+        return false;
+    }
+    
+    for (int s = 0; s < numSources; s++) {
+        result->sources[s] = sources[s];
+    }
+    for (int first = 0; first < numSources; first += MSBFS_BATCH) {
+        int count = numSources - first < MSBFS_BATCH ? numSources - first : MSBFS_BATCH;
+        multiSourceBFSBatch(csr, result, first, count, seen, visit, visitNext);
+    }
+    
+    free(seen);
+    free(visit);
+    free(visitNext);
+    return true;
+}
+
+// Closeness centrality of source s: (reached - 1) / sum of distances
+double closenessCentrality(MultiSourceBFSResult *result, int s) {
+    long long total = 0;
+    int reached = 0;
+    for (int v = 0; v < result->numVertices; v++) {
+        int d = multiSourceDistance(result, s, v);
+        if (d > 0) {
+            total += d;
+            reached++;
         }
     }
+    return total > 0 ? (double)reached / total : 0.0;
 }
 
-void DFSRecursive(Graph *g, int startVertex) {
-    if (startVertex >= g->numVertices || startVertex < 0) {
-        printf("Invalid start vertex!\n");
+// Print distance table (sources as rows) for small graphs
+void displayMultiSourceBFSResult(MultiSourceBFSResult *result) {
+    printf("Source\\Vertex");
+    for (int v = 0; v < result->numVertices; v++) {
+        printf("%3d", v);
+    }
+    printf("   Closeness\n");
+    for (int s = 0; s < result->numSources; s++) {
+        printf("%-13d", result->sources[s]);
+        for (int v = 0; v < result->numVertices; v++) {
+            int d = multiSourceDistance(result, s, v);
+            if (d == -1) {
+                printf("  -");
+            } else {
+                printf("%3d", d);
+            }
+        }
+        printf("   %.3f\n", closenessCentrality(result, s));
+    }
+}
+
+// Compare independent top-down BFS runs with one multi-source BFS
+void benchmarkMultiSourceBFS(int scale, int edgeFactor, int numSources) {
+    CSRGraph csr;
+    BFSResult single;
+    MultiSourceBFSResult multi;
+    
+    printf("\nGenerating R-MAT graph (scale %d, edge factor %d)...\n", scale, edgeFactor);
+    if (!generateRMATGraph(&csr, scale, edgeFactor, 12345)) {
         return;
     }
+    printf("Vertices: %d, Edges: %lld\n", csr.numVertices, csr.numEdges / 2);
     
-    bool visited[MAX_VERTICES] = {false};
-    printf("\nDFS Traversal (Recursive) starting from vertex %d: ", startVertex);
-    DFSRecursiveUtil(g, startVertex, visited);
-    printf("\n");
+    int *sources = (int*)malloc(numSources * sizeof(int));
+    if (sources == NULL || !initBFSResult(&single, csr.numVertices)) {
+        free(sources);
+        freeCSRGraph(&csr);
+        return;
+    }
+    if (!initMultiSourceBFSResult(&multi, numSources, csr.numVertices)) {
+        free(sources);
+        freeBFSResult(&single);
+        freeCSRGraph(&csr);
+        return;
+    }
+    
+    // Random non-isolated sources
+    unsigned long long state = 2024;
+    for (int s = 0; s < numSources; ) {
+        int v = nextRandom(&state) % csr.numVertices;
+        if (csr.offsets[v + 1] > csr.offsets[v]) sources[s++] = v;
+    }
+    
+    double start = getTimeSeconds();
+    multiSourceBFS(&csr, sources, numSources, &multi);
+    double multiTime = getTimeSeconds() - start;
+    
+    bool ok = true;
+    double singleTime = 0.0;
+    int runs = 0;
+    for (; runs < numSources; runs++) {
+        start = getTimeSeconds();
+        if (!topDownBFS(&csr, sources[runs], &single)) break;
+        singleTime += getTimeSeconds() - start;
+        for (int v = 0; v < csr.numVertices; v++) {
+            if (single.depth[v] != multiSourceDistance(&multi, runs, v)) ok = false;
+        }
+    }
+    
+    if (runs == numSources) {
+        printf("\n%d independent top-down BFS runs: %.6f s\n", numSources, singleTime);
+        printf("Multi-source BFS (%d per batch): %.6f s\n", MSBFS_BATCH, multiTime);
+        printf("Speedup: %.2fx, distances %s\n", singleTime / multiTime, ok ? "match" : "MISMATCH");
+    }
+    
+    free(sources);
+    freeBFSResult(&single);
+    freeMultiSourceBFSResult(&multi);
+    freeCSRGraph(&csr);
 }
 
 // Create example graph
@@ -240,15 +2728,71 @@ int main() {
     DFS(&g, 3);
     DFS(&g, 6);
     
-    // Perform recursive DFS
+    // DFS in recursive visiting order (same engine, no recursion)
     printf("\n DFS Demonstrations (Recursive) \n");
     DFSRecursive(&g, 0);
     DFSRecursive(&g, 3);
     DFSRecursive(&g, 6);
     
+    // Iterative DFS engine with pre-order printing and timestamps
+    printf("\n DFS Engine Demonstration (discovery/finish times) \n");
+    CSRGraph csr;
+    DFSResult dfsResult;
+    DFSCallbacks printCallbacks = {printVisitedVertex, NULL, NULL};
+    if (buildCSRFromGraph(&csr, &g) && initDFSResult(&dfsResult, csr.numVertices)) {
+        printf("DFS Traversal (engine) starting from vertex 0: ");
+        iterativeDFS(&csr, 0, &dfsResult, &printCallbacks);
+        printf("\n");
+        displayDFSResult(&dfsResult);
+        freeDFSResult(&dfsResult);
+    }
+    freeCSRGraph(&csr);
+    demonstrateDeepDFS(1000000);
+    
+    // Connected components of the example graph plus two isolated vertices
+    printf("\n Connected Components Demonstration \n");
+    ComponentsResult components;
+    Graph withIsolated = g;
+    withIsolated.numVertices = 9;
+    for (int i = 0; i < 9; i++) {
+        withIsolated.adjMatrix[i][7] = withIsolated.adjMatrix[7][i] = 0;
+        withIsolated.adjMatrix[i][8] = withIsolated.adjMatrix[8][i] = 0;
+    }
+    addEdge(&withIsolated, 7, 8);
+    if (buildCSRFromGraph(&csr, &withIsolated) &&
+        initComponentsResult(&components, csr.numVertices)) {
+        unionFindComponents(&csr, &components, 2);
+        displayComponents(&components);
+        freeComponentsResult(&components);
+    }
+    freeCSRGraph(&csr);
+    
+    // One multi-source BFS instead of three separate runs
+    printf("\n Multi-Source BFS Demonstration (sources 0, 3, 6 together) \n");
+    int demoSources[] = {0, 3, 6};
+    MultiSourceBFSResult multiResult;
+    if (buildCSRFromGraph(&csr, &g) && initMultiSourceBFSResult(&multiResult, 3, csr.numVertices)) {
+        multiSourceBFS(&csr, demoSources, 3, &multiResult);
+        displayMultiSourceBFSResult(&multiResult);
+        freeMultiSourceBFSResult(&multiResult);
+    }
+    freeCSRGraph(&csr);
+    
+    // Direction-optimizing BFS on the CSR form of the example graph
+    printf("\n Direction-Optimizing BFS Demonstration \n");
+    BFSResult bfsResult;
+    if (buildCSRFromGraph(&csr, &g) && initBFSResult(&bfsResult, csr.numVertices)) {
+        if (directionOptimizingBFS(&csr, 0, &bfsResult)) {
+            displayBFSResult(&bfsResult, csr.numVertices);
+        }
+        freeBFSResult(&bfsResult);
+    }
+    freeCSRGraph(&csr);
+    
     // Interactive mode
     printf("\n Interactive Mode \n");
-    int choice, vertices, src, dest, start;
+    int choice, vertices, src, dest, start, scale, edgeFactor, threads;
+    char path[256], outputPath[256];
     
     while (1) {
         printf("\n1. Create new graph\n");
@@ -257,7 +2801,20 @@ int main() {
         printf("4. BFS traversal\n");
         printf("5. DFS traversal (iterative)\n");
         printf("6. DFS traversal (recursive)\n");
-        printf("7. Exit\n");
+        printf("7. Direction-optimizing BFS (parents and depths)\n");
+        printf("8. Benchmark BFS on R-MAT graph\n");
+        printf("9. Benchmark parallel BFS scaling\n");
+        printf("10. Convert text edge list to binary graph file\n");
+        printf("11. Load binary graph file and run BFS\n");
+        printf("12. Import text edge list (parallel) and report throughput\n");
+        printf("13. Write R-MAT graph as text edge list\n");
+        printf("14. DFS with discovery/finish times\n");
+        printf("15. Connected components\n");
+        printf("16. Benchmark connected components\n");
+        printf("17. Benchmark vertex reordering (RCM / degree / BFS order)\n");
+        printf("18. Reorder binary graph file\n");
+        printf("19. Benchmark multi-source BFS\n");
+        printf("20. Exit\n");
         printf("Enter choice: ");
         
         if (scanf("%d", &choice) != 1) {
@@ -310,6 +2867,242 @@ int main() {
                 break;
                 
             case 7:
+                printf("Enter starting vertex for BFS: ");
+                scanf("%d", &start);
+                if (start >= g.numVertices || start < 0) {
+                    printf("Invalid start vertex!\n");
+                } else if (buildCSRFromGraph(&csr, &g)) {
+                    if (initBFSResult(&bfsResult, csr.numVertices)) {
+                        if (directionOptimizingBFS(&csr, start, &bfsResult)) {
+                            displayBFSResult(&bfsResult, csr.numVertices);
+                        }
+                        freeBFSResult(&bfsResult);
+                    }
+                    freeCSRGraph(&csr);
+                }
+                break;
+                
+            case 8:
+                printf("Enter R-MAT scale (vertices = 2^scale, e.g. 18): ");
+                scanf("%d", &scale);
+                printf("Enter edge factor (e.g. 16): ");
+                scanf("%d", &edgeFactor);
+                if (scale < 1 || scale > 26 || edgeFactor < 1) {
+                    printf("Invalid benchmark parameters!\n");
+                } else {
+                    benchmarkBFS(scale, edgeFactor, 8);
+                }
+                break;
+                
+            case 9:
+                printf("Enter R-MAT scale (vertices = 2^scale, e.g. 20): ");
+                scanf("%d", &scale);
+                printf("Enter edge factor (e.g. 16): ");
+                scanf("%d", &edgeFactor);
+                printf("Enter maximum number of threads (max %d): ", MAX_THREADS);
+                scanf("%d", &threads);
+                if (scale < 1 || scale > 26 || edgeFactor < 1 ||
+                    threads < 1 || threads > MAX_THREADS) {
+                    printf("Invalid benchmark parameters!\n");
+                } else {
+                    benchmarkParallelBFS(scale, edgeFactor, threads);
+                }
+                break;
+                
+            case 10:
+                printf("Enter edge list file: ");
+                scanf("%255s", path);
+                printf("Enter output binary file: ");
+                scanf("%255s", outputPath);
+                printf("Enter number of threads (max %d): ", MAX_THREADS);
+                scanf("%d", &threads);
+                convertEdgeListToBinary(path, outputPath, threads);
+                break;
+                
+            case 11: {
+                printf("Enter binary graph file: ");
+                scanf("%255s", path);
+                double loadStart = getTimeSeconds();
+                if (!loadCSRGraphBinary(&csr, path)) break;
+                printf("Loaded %d vertices, %lld arcs in %.6f s\n", csr.numVertices,
+                       csr.numEdges, getTimeSeconds() - loadStart);
+                printf("Enter starting vertex for BFS: ");
+                scanf("%d", &start);
+                if (start >= csr.numVertices || start < 0) {
+                    printf("Invalid start vertex!\n");
+                } else if (initBFSResult(&bfsResult, csr.numVertices)) {
+                    double bfsStart = getTimeSeconds();
+                    if (!directionOptimizingBFS(&csr, start, &bfsResult)) {
+                        freeBFSResult(&bfsResult);
+                        freeCSRGraph(&csr);
+                        break;
+                    }
+                    double bfsTime = getTimeSeconds() - bfsStart;
+                    int reached = 0, maxDepth = 0;
+                    for (int v = 0; v < csr.numVertices; v++) {
+                        if (bfsResult.depth[v] != -1) reached++;
+                        if (bfsResult.depth[v] > maxDepth) maxDepth = bfsResult.depth[v];
+                    }
+                    printf("Reached %d vertices, max depth %d, BFS time %.6f s\n",
+                           reached, maxDepth, bfsTime);
+                    if (csr.numVertices <= MAX_VERTICES) {
+                        displayBFSResult(&bfsResult, csr.numVertices);
+                    }
+                    freeBFSResult(&bfsResult);
+                }
+                freeCSRGraph(&csr);
+                break;
+            }
+                
+            case 12:
+                printf("Enter edge list file: ");
+                scanf("%255s", path);
+                printf("Enter maximum number of threads (max %d): ", MAX_THREADS);
+                scanf("%d", &threads);
+                if (threads < 1 || threads > MAX_THREADS) {
+                    printf("Invalid number of threads!\n");
+                    break;
+                }
+                for (int t = 1; ; t = t * 2 > threads ? threads : t * 2) {
+                    if (loadEdgeListParallel(&csr, path, t, true)) {
+                        freeCSRGraph(&csr);
+                    }
+                    if (t == threads) break;
+                }
+                break;
+                
+            case 13:
+                printf("Enter R-MAT scale (vertices = 2^scale, e.g. 20): ");
+                scanf("%d", &scale);
+                printf("Enter edge factor (e.g. 16): ");
+                scanf("%d", &edgeFactor);
+                printf("Enter output text file: ");
+                scanf("%255s", path);
+                if (scale < 1 || scale > 26 || edgeFactor < 1) {
+                    printf("Invalid parameters!\n");
+                } else if (generateRMATGraph(&csr, scale, edgeFactor, 12345)) {
+                    if (saveEdgeListText(&csr, path)) {
+                        printf("Wrote %lld edges to %s\n", csr.numEdges / 2, path);
+                    }
+                    freeCSRGraph(&csr);
+                }
+                break;
+                
+            case 14:
+                printf("Enter starting vertex for DFS: ");
+                scanf("%d", &start);
+                if (start >= g.numVertices || start < 0) {
+                    printf("Invalid start vertex!\n");
+                } else if (buildCSRFromGraph(&csr, &g)) {
+                    if (initDFSResult(&dfsResult, csr.numVertices)) {
+                        printf("DFS Traversal (engine) starting from vertex %d: ", start);
+                        iterativeDFS(&csr, start, &dfsResult, &printCallbacks);
+                        printf("\n");
+                        displayDFSResult(&dfsResult);
+                        freeDFSResult(&dfsResult);
+                    }
+                    freeCSRGraph(&csr);
+                }
+                break;
+                
+            case 15:
+                if (buildCSRFromGraph(&csr, &g)) {
+                    if (initComponentsResult(&components, csr.numVertices)) {
+                        unionFindComponents(&csr, &components, 1);
+                        displayComponents(&components);
+                        freeComponentsResult(&components);
+                    }
+                    freeCSRGraph(&csr);
+                }
+                break;
+                
+            case 16:
+                printf("Enter R-MAT scale (vertices = 2^scale, e.g. 24): ");
+                scanf("%d", &scale);
+                printf("Enter edge factor (e.g. 4): ");
+                scanf("%d", &edgeFactor);
+                printf("Enter number of threads (max %d): ", MAX_THREADS);
+                scanf("%d", &threads);
+                if (scale < 1 || scale > 26 || edgeFactor < 1 ||
+                    threads < 1 || threads > MAX_THREADS) {
+                    printf("Invalid benchmark parameters!\n");
+                } else {
+                    benchmarkComponents(scale, edgeFactor, threads);
+                }
+                break;
+                
+            case 17:
+                printf("Enter R-MAT scale (vertices = 2^scale, e.g. 20): ");
+                scanf("%d", &scale);
+                printf("Enter edge factor (e.g. 16): ");
+                scanf("%d", &edgeFactor);
+                if (scale < 1 || scale > 26 || edgeFactor < 1) {
+                    printf("Invalid benchmark parameters!\n");
+                } else {
+                    benchmarkReordering(scale, edgeFactor);
+                }
+                break;
+                
+            case 18: {
+                int method;
+                printf("Enter binary graph file: ");
+                scanf("%255s", path);
+                printf("Enter output binary file: ");
+                scanf("%255s", outputPath);
+                printf("Ordering (1 = degree sort, 2 = BFS order, 3 = RCM): ");
+                scanf("%d", &method);
+                if (method < 1 || method > 3) {
+                    printf("Invalid ordering!\n");
+                    break;
+                }
+                if (!loadCSRGraphBinary(&csr, path)) break;
+                VertexOrdering ordering;
+                CSRGraph relabeled;
+                if (initVertexOrdering(&ordering, csr.numVertices)) {
+                    bool ordered;
+                    if (method == 1) {
+                        ordered = computeDegreeOrder(&csr, &ordering);
+                    } else if (method == 2) {
+                        ordered = computeBFSOrder(&csr, &ordering);
+                    } else {
+                        ordered = computeRCMOrder(&csr, &ordering);
+                    }
+                    if (ordered && relabelGraph(&csr, &ordering, &relabeled)) {
+                        // The permutation goes next to the graph so that
+                        // results on the new ids can be mapped back
+                        char orderPath[sizeof(outputPath) + 8];
+                        snprintf(orderPath, sizeof(orderPath), "%s.order", outputPath);
+                        if (saveCSRGraphBinary(&relabeled, outputPath) &&
+                            saveVertexOrdering(&ordering, orderPath)) {
+                            printf("Reordered graph saved to %s\n", outputPath);
+                            printf("Vertex order (new id -> original id) saved to %s\n", orderPath);
+                        }
+                        freeCSRGraph(&relabeled);
+                    }
+                    freeVertexOrdering(&ordering);
+                }
+                freeCSRGraph(&csr);
+                break;
+            }
+                
+            case 19: {
+                int numSources;
+                printf("Enter R-MAT scale (vertices = 2^scale, e.g. 18): ");
+                scanf("%d", &scale);
+                printf("Enter edge factor (e.g. 16): ");
+                scanf("%d", &edgeFactor);
+                printf("Enter number of sources (e.g. %d): ", MSBFS_BATCH);
+                scanf("%d", &numSources);
+                if (scale < 1 || scale > 26 || edgeFactor < 1 || numSources < 1 ||
+                    (long long)numSources << scale > 1LL << 30) {
+                    printf("Invalid benchmark parameters!\n");
+                } else {
+                    benchmarkMultiSourceBFS(scale, edgeFactor, numSources);
+                }
+                break;
+            }
+                
+            case 20:
                 printf("Exiting...\n");
                 return 0;
                 
@@ -1,32 +1,32 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
-#define MAX_SIZE 100
+// Heap arrays are aligned to a cache line
+#define HEAP_ALIGNMENT 64
 
-// Min Heap structure
-typedef struct {
-    int arr[MAX_SIZE];
-    int size;
-} MinHeap;
-
-// Max Heap structure
-typedef struct {
-    int arr[MAX_SIZE];
-    int size;
-} MaxHeap;
-
-// Helper function to swap two elements
-void swap(int *a, int *b) {
-    int temp = *a;
-    *a = *b;
-    *b = temp;
-}
+// Most threads a concurrent benchmark runs, and heaps per thread in a
+// relaxed MultiQueue
+#define MAX_THREADS 64
+#define MULTIQUEUE_HEAPS_PER_THREAD 2
 
+// Largest heap size whose comparisons are counted in benchmarks (a second,
+// counting run of every variant)
+#define SIFT_COUNT_LIMIT 10000000
 
-// Initialize min heap
-void initMinHeap(MinHeap *heap) {
-    heap->size = 0;
-}
+// extractManyName() quickselects only heaps larger than this many bytes
+// (bottom-up extraction stays in cache below it and wins for every k), and
+// only when at least 1/EXTRACT_SELECT_FRACTION of the heap is taken
+#define EXTRACT_SELECT_BYTES (8 << 20)
+#define EXTRACT_SELECT_FRACTION 20
 
 // Get parent index
 int getParent(int i) {
@@ -43,76 +43,703 @@ int getRightChild(int i) {
     return 2 * i + 2;
 }
 
-// Heapify down for min heap
-void minHeapifyDown(MinHeap *heap, int i) {
-    int smallest = i;
-    int left = getLeftChild(i);
-    int right = getRightChild(i);
-    
-    if (left < heap->size && heap->arr[left] < heap->arr[smallest]) {
-        smallest = left;
-    }
-    
-    if (right < heap->size && heap->arr[right] < heap->arr[smallest]) {
-        smallest = right;
-    }
-    
-    if (smallest != i) {
-        swap(&heap->arr[i], &heap->arr[smallest]);
-        minHeapifyDown(heap, smallest);
-    }
-}
+// Comparators and key extractors for DEFINE_HEAP
+#define LESS_THAN(a, b) ((a) < (b))
+#define GREATER_THAN(a, b) ((a) > (b))
+#define VALUE_KEY(x) (x)
+
+// Child selectors for DEFINE_DARY_HEAP: offset (0..ARITY-1) of the child that
+// comes first among the ARITY children starting at children
+#define SCAN_BEST_CHILD(Name, children) scanBestChild##Name(children)
+#define SIMD_MIN8_CHILD(Name, children) minIndex8(children)
 
-// Heapify up for min heap
-void minHeapifyUp(MinHeap *heap, int i) {
-    if (i && heap->arr[getParent(i)] > heap->arr[i]) {
-        swap(&heap->arr[i], &heap->arr[getParent(i)]);
-        minHeapifyUp(heap, getParent(i));
+// Index (0..7) of the smallest of 8 ints, the first one on ties. values must
+// be 32-byte aligned (a sibling group of an 8-ary int heap is). SSE2 is part
+// of x86-64, so this needs no extra flags; -msse4.1 replaces the
+// compare-and-blend with pminsd and -mavx2 (or -march=native) handles all 8
+// values in one register.
+int minIndex8(const int *values) {
+#if defined(__AVX2__)
+    __m256i v = _mm256_load_si256((const __m256i*)values);
+    __m256i m = _mm256_min_epi32(v, _mm256_permute2x128_si256(v, v, 1));
+    m = _mm256_min_epi32(m, _mm256_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm256_min_epi32(m, _mm256_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+    return __builtin_ctz(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, m))));
+#elif defined(__SSE2__)
+    __m128i a = _mm_load_si128((const __m128i*)values);
+    __m128i b = _mm_load_si128((const __m128i*)(values + 4));
+#if defined(__SSE4_1__)
+    __m128i m = _mm_min_epi32(a, b);
+    m = _mm_min_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm_min_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+#else
+    __m128i lt = _mm_cmplt_epi32(a, b);
+    __m128i m = _mm_or_si128(_mm_and_si128(lt, a), _mm_andnot_si128(lt, b));
+    __m128i s = _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2));
+    lt = _mm_cmplt_epi32(m, s);
+    m = _mm_or_si128(_mm_and_si128(lt, m), _mm_andnot_si128(lt, s));
+    s = _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1));
+    lt = _mm_cmplt_epi32(m, s);
+    m = _mm_or_si128(_mm_and_si128(lt, m), _mm_andnot_si128(lt, s));
+#endif
+    // m holds the minimum in every lane; find its first position
+    int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, m))) |
+               _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(b, m))) << 4;
+    return __builtin_ctz(mask);
+#else
+    int best = 0;
+    for (int c = 1; c < 8; c++) {
+        best = values[c] < values[best] ? c : best;
     }
+    return best;
+#endif
 }
 
-// Build min heap from array
-void buildMinHeap(MinHeap *heap, int arr[], int n) {
-    if (n > MAX_SIZE) {
-        printf("Array size exceeds maximum heap size!\n");
-        return;
-    }
-    
-    heap->size = n;
-    for (int i = 0; i < n; i++) {
-        heap->arr[i] = arr[i];
-    }
-    
-    // Start from last non-leaf node and heapify down
-    for (int i = (n / 2) - 1; i >= 0; i--) {
-        minHeapifyDown(heap, i);
-    }
+// Generic heap engine
+// DEFINE_DARY_HEAP(Name, Type, KEY, BEFORE, ARITY, BEST_CHILD) generates a
+// growable ARITY-ary heap of Type elements called Name, with initName(),
+// insertName(), extractName(), ... KEY(x) extracts the priority of an
+// element (the rest of the element is its payload) and BEFORE(a, b) is true
+// when key a belongs closer to the root than key b: LESS_THAN gives a min
+// heap, GREATER_THAN a max heap. BEST_CHILD picks among a full group of
+// children (SCAN_BEST_CHILD works for every heap). All of them are macros,
+// so each heap gets its own functions with the comparisons inlined. The
+// array grows geometrically; reserveName() and shrinkName() control the
+// capacity explicitly.
+//
+// Children of i are ARITY*i+1 .. ARITY*i+ARITY and the parent is
+// (i-1)/ARITY. The array is HEAP_ALIGNMENT aligned and arr starts ARITY-1
+// slots into it, so every group of siblings starts at a multiple of ARITY
+// slots: when ARITY * sizeof(Type) divides 64, a group shares one cache line.
+#define DEFINE_DARY_HEAP(Name, Type, KEY, BEFORE, ARITY, BEST_CHILD)            \
+typedef struct {                                                                \
+    Type *arr;              /* root at arr[0] */                                \
+    Type *storage;          /* aligned allocation, arr = storage + ARITY-1 */   \
+    int size;                                                                   \
+    int capacity;                                                               \
+} Name;                                                                         \
+                                                                                \
+void init##Name(Name *heap) {                                                   \
+    heap->arr = NULL;                                                           \
+    heap->storage = NULL;                                                       \
+    heap->size = 0;                                                             \
+    heap->capacity = 0;                                                         \
+}                                                                               \
+                                                                                \
+void free##Name(Name *heap) {                                                   \
+    free(heap->storage);                                                        \
+    init##Name(heap);                                                           \
+}                                                                               \
+                                                                                \
+/* Move the elements to a new aligned array of capacity slots */               \
+bool resize##Name(Name *heap, int capacity) {                                   \
+    size_t bytes = (size_t)(capacity + ARITY - 1) * sizeof(Type);               \
+    bytes = (bytes + HEAP_ALIGNMENT - 1) / HEAP_ALIGNMENT * HEAP_ALIGNMENT;     \
+    Type *storage = (Type*)aligned_alloc(HEAP_ALIGNMENT, bytes);                \
+    if (storage == NULL) {                                                      \
+        printf("Memory allocation failed!\n");                                  \
+        return false;                                                           \
+    }                                                                           \
+    if (heap->size > 0) {                                                       \
+        memcpy(storage + ARITY - 1, heap->arr, (size_t)heap->size * sizeof(Type)); \
+    }                                                                           \
+    free(heap->storage);                                                        \
+    heap->storage = storage;                                                    \
+    heap->arr = storage + ARITY - 1;                                            \
+    heap->capacity = capacity;                                                  \
+    return true;                                                                \
+}                                                                               \
+                                                                                \
+/* Make room for at least capacity elements */                                  \
+bool reserve##Name(Name *heap, int capacity) {                                  \
+    if (capacity <= heap->capacity) return true;                                \
+    return resize##Name(heap, capacity);                                        \
+}                                                                               \
+                                                                                \
+/* Give unused capacity back */                                                 \
+void shrink##Name(Name *heap) {                                                 \
+    if (heap->size == 0) {                                                      \
+        free##Name(heap);                                                       \
+        return;                                                                 \
+    }                                                                           \
+    if (heap->size < heap->capacity) resize##Name(heap, heap->size);            \
+}                                                                               \
+                                                                                \
+/* Double the capacity (at least 16) */                                         \
+bool grow##Name(Name *heap) {                                                   \
+    if (heap->capacity > INT_MAX / 2) {                                         \
+        printf("Heap overflow!\n");                                             \
+        return false;                                                           \
+    }                                                                           \
+    return reserve##Name(heap, heap->capacity < 16 ? 16 : 2 * heap->capacity);  \
+}                                                                               \
+                                                                                \
+void swap##Name(Type *a, Type *b) {                                             \
+    Type temp = *a;                                                             \
+    *a = *b;                                                                    \
+    *b = temp;                                                                  \
+}                                                                               \
+                                                                                \
+/* Offset of the child that comes first among ARITY children. The loop has a  \
+   constant trip count and keeps the best key in a local, so the selection    \
+   compiles to conditional moves instead of unpredictable branches. */        \
+int scanBestChild##Name(Type *children) {                                       \
+    int best = 0;                                                               \
+    __typeof__(KEY(children[0])) bestKey = KEY(children[0]);                    \
+    for (int c = 1; c < ARITY; c++) {                                           \
+        __typeof__(bestKey) key = KEY(children[c]);                             \
+        bool better = BEFORE(key, bestKey);                                     \
+        best = better ? c : best;                                               \
+        bestKey = better ? key : bestKey;                                       \
+    }                                                                           \
+    return best;                                                                \
+}                                                                               \
+                                                                                \
+/* Child of i that comes first in a heap of n elements, or -1 if i is a leaf */ \
+int bestChild##Name(const Name *heap, int n, int i) {                           \
+    int first = ARITY * i + 1;                                                  \
+    if (first + ARITY <= n) {                                                   \
+        return first + BEST_CHILD(Name, &heap->arr[first]);                     \
+    }                                                                           \
+    if (first >= n) return -1;                                                  \
+    /* Last, incomplete group */                                                \
+    int best = first;                                                           \
+    for (int c = first + 1; c < n; c++) {                                       \
+        if (BEFORE(KEY(heap->arr[c]), KEY(heap->arr[best]))) best = c;          \
+    }                                                                           \
+    return best;                                                                \
+}                                                                               \
+                                                                                \
+/* Move element i down until it is before all its children. The element is   \
+   held in a local while children that come before it move up into the hole, \
+   and is written once at its final slot: one write per level instead of the \
+   three of a swap, and no recursion. */                                      \
+void siftDown##Name(Name *heap, int i) {                                        \
+    Type value = heap->arr[i];                                                  \
+    int n = heap->size;                                                         \
+                                                                                \
+    while (1) {                                                                 \
+        int child = bestChild##Name(heap, n, i);                                \
+        if (child < 0 || !BEFORE(KEY(heap->arr[child]), KEY(value))) break;     \
+        heap->arr[i] = heap->arr[child];                                        \
+        i = child;                                                              \
+    }                                                                           \
+    heap->arr[i] = value;                                                       \
+}                                                                               \
+                                                                                \
+/* Move element i up until its parent is not after it (same hole technique) */ \
+void siftUp##Name(Name *heap, int i) {                                          \
+    Type value = heap->arr[i];                                                  \
+                                                                                \
+    while (i > 0) {                                                             \
+        int parent = (i - 1) / ARITY;                                           \
+        if (!BEFORE(KEY(value), KEY(heap->arr[parent]))) break;                 \
+        heap->arr[i] = heap->arr[parent];                                       \
+        i = parent;                                                             \
+    }                                                                           \
+    heap->arr[i] = value;                                                       \
+}                                                                               \
+                                                                                \
+/* Original recursive swap-based sifts, kept as the benchmark baseline */      \
+void siftDownSwap##Name(Name *heap, int i) {                                    \
+    int best = i;                                                               \
+    int first = ARITY * i + 1;                                                  \
+                                                                                \
+    for (int c = first; c < first + ARITY && c < heap->size; c++) {             \
+        if (BEFORE(KEY(heap->arr[c]), KEY(heap->arr[best]))) best = c;          \
+    }                                                                           \
+    if (best != i) {                                                            \
+        swap##Name(&heap->arr[i], &heap->arr[best]);                            \
+        siftDownSwap##Name(heap, best);                                         \
+    }                                                                           \
+}                                                                               \
+                                                                                \
+void siftUpSwap##Name(Name *heap, int i) {                                      \
+    if (i && BEFORE(KEY(heap->arr[i]), KEY(heap->arr[(i - 1) / ARITY]))) {      \
+        swap##Name(&heap->arr[i], &heap->arr[(i - 1) / ARITY]);                 \
+        siftUpSwap##Name(heap, (i - 1) / ARITY);                                \
+    }                                                                           \
+}                                                                               \
+                                                                                \
+/* Restore the heap order after slots first..size-1 were filled with new     \
+   elements. Only their ancestors can be out of order: sift those down,      \
+   deepest first, one range of parents at a time. Each range is the parents \
+   of the one before, so the work is O(count + log n * log count) for       \
+   count new slots, and O(n) with first = 0 (Floyd's heap construction). */  \
+void repair##Name(Name *heap, int first) {                                      \
+    int n = heap->size;                                                         \
+    if (first >= n) return;                                                     \
+    int lo = first > 0 ? (first - 1) / ARITY : 0;                               \
+    int hi = n > 1 ? (n - 2) / ARITY : 0;                                       \
+                                                                                \
+    while (1) {                                                                 \
+        for (int i = hi; i >= lo; i--) {                                        \
+            siftDown##Name(heap, i);                                            \
+        }                                                                       \
+        if (lo == 0) break;                                                     \
+        /* Parents of lo..hi, minus those already done in this range */         \
+        int parentHi = (hi - 1) / ARITY;                                        \
+        hi = parentHi < lo ? parentHi : lo - 1;                                 \
+        lo = (lo - 1) / ARITY;                                                  \
+    }                                                                           \
+}                                                                               \
+                                                                                \
+/* Replace the contents with items[0..n-1], bottom-up in O(n) */                \
+bool build##Name(Name *heap, const Type *items, int n) {                        \
+    if (!reserve##Name(heap, n)) return false;                                  \
+    if (n > 0) memcpy(heap->arr, items, (size_t)n * sizeof(Type));              \
+    heap->size = n;                                                             \
+    repair##Name(heap, 0);                                                      \
+    return true;                                                                \
+}                                                                               \
+                                                                                \
+/* Add items[0..count-1]. They are appended in one copy; a batch shorter     \
+   than the height of the tree is sifted up item by item (O(count log n)),  \
+   a longer one is fixed by repairName(), which for a batch as large as    \
+   the heap amounts to rebuilding it in O(n). */                              \
+bool insertMany##Name(Name *heap, const Type *items, int count) {               \
+    if (count <= 0) return true;                                                \
+    if (count > INT_MAX - heap->size) {                                         \
+        printf("Heap overflow!\n");                                             \
+        return false;                                                           \
+    }                                                                           \
+    int first = heap->size;                                                     \
+    int needed = first + count;                                                 \
+    if (needed > heap->capacity) {                                              \
+        int capacity = heap->capacity < 16 ? 16 : heap->capacity;               \
+        while (capacity < needed) {                                             \
+            capacity = capacity > INT_MAX / 2 ? needed : 2 * capacity;          \
+        }                                                                       \
+        if (!reserve##Name(heap, capacity)) return false;                       \
+    }                                                                           \
+    memcpy(heap->arr + first, items, (size_t)count * sizeof(Type));            \
+    heap->size = needed;                                                        \
+                                                                                \
+    int height = 0;                                                             \
+    for (int m = first; m > 0; m /= ARITY) height++;                            \
+    if (count < height) {                                                       \
+        for (int i = first; i < needed; i++) siftUp##Name(heap, i);             \
+    } else {                                                                    \
+        repair##Name(heap, first);                                              \
+    }                                                                           \
+    return true;                                                                \
+}                                                                               \
+                                                                                \
+bool insert##Name(Name *heap, Type value) {                                     \
+    if (heap->size == heap->capacity && !grow##Name(heap)) return false;        \
+    heap->arr[heap->size] = value;                                              \
+    heap->size++;                                                               \
+    siftUp##Name(heap, heap->size - 1);                                         \
+    return true;                                                                \
+}                                                                               \
+                                                                                \
+/* Remove the root into *out; false if the heap is empty */                     \
+bool extract##Name(Name *heap, Type *out) {                                     \
+    if (heap->size <= 0) return false;                                          \
+    *out = heap->arr[0];                                                        \
+    heap->arr[0] = heap->arr[heap->size - 1];                                   \
+    heap->size--;                                                               \
+    siftDown##Name(heap, 0);                                                    \
+    return true;                                                                \
+}                                                                               \
+                                                                                \
+/* Put value in place of the root and sift it down: one sift instead of the \
+   two of extract + insert. The old root goes to *out; false if empty. */    \
+bool replaceTop##Name(Name *heap, Type value, Type *out) {                      \
+    if (heap->size <= 0) return false;                                          \
+    *out = heap->arr[0];                                                        \
+    heap->arr[0] = value;                                                       \
+    siftDown##Name(heap, 0);                                                    \
+    return true;                                                                \
+}                                                                               \
+                                                                                \
+/* Floyd's bottom-up extraction: the hole left by the root walks down to a    \
+   leaf along the preferred children (no comparison with the element being   \
+   placed), then the last element is sifted up from there. The last element  \
+   usually belongs near the bottom, so the sift-up is short. */              \
+bool extractBottomUp##Name(Name *heap, Type *out) {                             \
+    if (heap->size <= 0) return false;                                          \
+    *out = heap->arr[0];                                                        \
+    heap->size--;                                                               \
+    if (heap->size == 0) return true;                                           \
+                                                                                \
+    int n = heap->size;                                                         \
+    Type value = heap->arr[n];                                                  \
+    int i = 0;                                                                  \
+    while (1) {                                                                 \
+        int child = bestChild##Name(heap, n, i);                                \
+        if (child < 0) break;                                                   \
+        heap->arr[i] = heap->arr[child];                                        \
+        i = child;                                                              \
+    }                                                                           \
+    while (i > 0) {                                                             \
+        int parent = (i - 1) / ARITY;                                           \
+        if (!BEFORE(KEY(value), KEY(heap->arr[parent]))) break;                 \
+        heap->arr[i] = heap->arr[parent];                                       \
+        i = parent;                                                             \
+    }                                                                           \
+    heap->arr[i] = value;                                                       \
+    return true;                                                                \
+}                                                                               \
+                                                                                \
+/* Root element, or NULL if the heap is empty */                                \
+Type *peek##Name(Name *heap) {                                                  \
+    return heap->size > 0 ? &heap->arr[0] : NULL;                               \
+}                                                                               \
+                                                                                \
+/* Quickselect: rearrange a[0..n-1] so that a[0..k-1] are the k elements     \
+   that come first, with the k-th of them at a[k-1] and the others in no    \
+   particular order, in O(n) on average */                                  \
+void selectFirst##Name(Type *a, int n, int k) {                                 \
+    int lo = 0, hi = n - 1;                                                     \
+                                                                                \
+    while (lo < hi) {                                                           \
+        /* Median of three as pivot, which also bounds both scans below */      \
+        int mid = lo + (hi - lo) / 2;                                           \
+        if (BEFORE(KEY(a[mid]), KEY(a[lo]))) swap##Name(&a[mid], &a[lo]);       \
+        if (BEFORE(KEY(a[hi]), KEY(a[lo]))) swap##Name(&a[hi], &a[lo]);         \
+        if (BEFORE(KEY(a[hi]), KEY(a[mid]))) swap##Name(&a[hi], &a[mid]);       \
+        __typeof__(KEY(a[mid])) pivot = KEY(a[mid]);                            \
+                                                                                \
+        int i = lo, j = hi;                                                     \
+        while (i <= j) {                                                        \
+            while (BEFORE(KEY(a[i]), pivot)) i++;                               \
+            while (BEFORE(pivot, KEY(a[j]))) j--;                               \
+            if (i <= j) {                                                       \
+                swap##Name(&a[i], &a[j]);                                       \
+                i++;                                                            \
+                j--;                                                            \
+            }                                                                   \
+        }                                                                       \
+        /* a[lo..j] are not after the pivot, a[i..hi] not before it, and      \
+           anything in between equals it */                                   \
+        if (k - 1 <= j) {                                                       \
+            hi = j;                                                             \
+        } else if (k - 1 >= i) {                                                \
+            lo = i;                                                             \
+        } else {                                                                \
+            break;                                                              \
+        }                                                                       \
+    }                                                                           \
+}                                                                               \
+                                                                                \
+/* Sift a[i] down in a heap of n elements whose root is the element that   \
+   comes last. a[] is any caller array, not the aligned heap storage, so    \
+   the children are compared with a plain scan instead of BEST_CHILD. */    \
+void siftDownLast##Name(Type *a, int n, int i) {                                \
+    Type value = a[i];                                                          \
+                                                                                \
+    while (1) {                                                                 \
+        int first = ARITY * i + 1;                                              \
+        if (first >= n) break;                                                  \
+        int last = first;                                                       \
+        for (int c = first + 1; c < first + ARITY && c < n; c++) {              \
+            if (BEFORE(KEY(a[last]), KEY(a[c]))) last = c;                      \
+        }                                                                       \
+        if (!BEFORE(KEY(value), KEY(a[last]))) break;                           \
+        a[i] = a[last];                                                         \
+        i = last;                                                               \
+    }                                                                           \
+    a[i] = value;                                                               \
+}                                                                               \
+                                                                                \
+/* Heapsort a[0..n-1] in place into BEFORE order: each root taken from the   \
+   heap is the last remaining element and goes to the slot it gives up */   \
+void heapSort##Name(Type *a, int n) {                                           \
+    for (int i = (n - 2) / ARITY; i >= 0; i--) siftDownLast##Name(a, n, i);     \
+    for (int end = n - 1; end > 0; end--) {                                     \
+        swap##Name(&a[0], &a[end]);                                             \
+        siftDownLast##Name(a, end, 0);                                          \
+    }                                                                           \
+}                                                                               \
+                                                                                \
+/* Remove the k first elements (all of them if k >= size) into out[0..k-1],  \
+   in order, and return how many were removed. They are taken with k        \
+   bottom-up extractions, O(k log n), unless the heap is too large for the  \
+   cache and k is a sizable fraction of it: then quickselecting them in     \
+   O(n), rebuilding the rest in O(n) and heapsorting the k selected ones    \
+   in O(k log k) touches memory far less randomly. */                       \
+int extractMany##Name(Name *heap, Type *out, int k) {                           \
+    int n = heap->size;                                                         \
+    if (k > n) k = n;                                                           \
+    if (k <= 0) return 0;                                                       \
+                                                                                \
+    if ((size_t)n * sizeof(Type) <= EXTRACT_SELECT_BYTES ||                     \
+        k < n / EXTRACT_SELECT_FRACTION) {                                      \
+        for (int i = 0; i < k; i++) extractBottomUp##Name(heap, &out[i]);       \
+        return k;                                                               \
+    }                                                                           \
+                                                                                \
+    selectFirst##Name(heap->arr, n, k);                                         \
+    memcpy(out, heap->arr, (size_t)k * sizeof(Type));                           \
+    memmove(heap->arr, heap->arr + k, (size_t)(n - k) * sizeof(Type));         \
+    heap->size = n - k;                                                         \
+    repair##Name(heap, 0);                                                      \
+                                                                                \
+    heapSort##Name(out, k);                                                     \
+    return k;                                                                   \
+}                                                                               \
+                                                                                \
+/* Move every element of other into heap and leave other empty. The smaller  \
+   heap is appended to the larger one (the two are swapped if needed), so   \
+   the cost is that of insertManyName() for the smaller side. On failure    \
+   both heaps keep their elements (possibly swapped). */                    \
+bool meld##Name(Name *heap, Name *other) {                                      \
+    if (other->size > heap->size) {                                             \
+        Name temp = *heap;                                                      \
+        *heap = *other;                                                         \
+        *other = temp;                                                          \
+    }                                                                           \
+    if (!insertMany##Name(heap, other->arr, other->size)) return false;         \
+    free##Name(other);                                                          \
+    return true;                                                                \
 }
 
-// Insert into min heap
-void insertMinHeap(MinHeap *heap, int value) {
-    if (heap->size >= MAX_SIZE) {
-        printf("Heap overflow!\n");
-        return;
-    }
-    
-    heap->arr[heap->size] = value;
-    heap->size++;
-    minHeapifyUp(heap, heap->size - 1);
+// Binary heap: the layout printHeapTree() and getLeftChild() describe
+#define DEFINE_HEAP(Name, Type, KEY, BEFORE) \
+    DEFINE_DARY_HEAP(Name, Type, KEY, BEFORE, 2, SCAN_BEST_CHILD)
+
+// Indexed heap engine
+// DEFINE_INDEXED_HEAP(Name, KeyType, BEFORE, ARITY) generates an ARITY-ary
+// heap of (key, handle) entries where handles are small non-negative ints
+// (job ids, vertex numbers). position[handle] is the slot of the handle's
+// entry, or -1 if it is not in the heap, so an entry can be found in O(1)
+// and its key changed or the entry removed in O(log n). Every write of an
+// entry into the array goes through placeName(), so the sifts keep the
+// position map up to date as they move entries.
+#define DEFINE_INDEXED_HEAP(Name, KeyType, BEFORE, ARITY)                       \
+typedef struct {                                                                \
+    KeyType key;                                                                \
+    int handle;                                                                 \
+} Name##Entry;                                                                  \
+                                                                                \
+typedef struct {                                                                \
+    Name##Entry *arr;                                                           \
+    int *position;          /* slot of each handle, -1 if not in the heap */    \
+    int size;                                                                   \
+    int numHandles;         /* handles 0..numHandles-1 fit, and as many slots */ \
+} Name;                                                                         \
+                                                                                \
+void init##Name(Name *heap) {                                                   \
+    heap->arr = NULL;                                                           \
+    heap->position = NULL;                                                      \
+    heap->size = 0;                                                             \
+    heap->numHandles = 0;                                                       \
+}                                                                               \
+                                                                                \
+void free##Name(Name *heap) {                                                   \
+    free(heap->arr);                                                            \
+    free(heap->position);                                                       \
+    init##Name(heap);                                                           \
+}                                                                               \
+                                                                                \
+/* Make handles 0..numHandles-1 usable; each handle is in the heap at most    \
+   once, so the entry array needs the same number of slots */                 \
+bool reserveHandles##Name(Name *heap, int numHandles) {                         \
+    if (numHandles <= heap->numHandles) return true;                            \
+    int *position = (int*)realloc(heap->position, (size_t)numHandles * sizeof(int)); \
+    if (position == NULL) {                                                     \
+        printf("Memory allocation failed!\n");                                  \
+        return false;                                                           \
+    }                                                                           \
+    heap->position = position;                                                  \
+    Name##Entry *arr = (Name##Entry*)realloc(heap->arr,                         \
+                                             (size_t)numHandles * sizeof(Name##Entry)); \
+    if (arr == NULL) {                                                          \
+        printf("Memory allocation failed!\n");                                  \
+        return false;                                                           \
+    }                                                                           \
+    heap->arr = arr;                                                            \
+    for (int h = heap->numHandles; h < numHandles; h++) {                       \
+        position[h] = -1;                                                       \
+    }                                                                           \
+    heap->numHandles = numHandles;                                              \
+    return true;                                                                \
+}                                                                               \
+                                                                                \
+/* Write entry into slot i and record the slot in the position map */         \
+void place##Name(Name *heap, int i, Name##Entry entry) {                        \
+    heap->arr[i] = entry;                                                       \
+    heap->position[entry.handle] = i;                                           \
+}                                                                               \
+                                                                                \
+void siftUp##Name(Name *heap, int i) {                                          \
+    Name##Entry entry = heap->arr[i];                                           \
+                                                                                \
+    while (i > 0) {                                                             \
+        int parent = (i - 1) / ARITY;                                           \
+        if (!BEFORE(entry.key, heap->arr[parent].key)) break;                   \
+        place##Name(heap, i, heap->arr[parent]);                                \
+        i = parent;                                                             \
+    }                                                                           \
+    place##Name(heap, i, entry);                                                \
+}                                                                               \
+                                                                                \
+void siftDown##Name(Name *heap, int i) {                                        \
+    Name##Entry entry = heap->arr[i];                                           \
+    int n = heap->size;                                                         \
+                                                                                \
+    while (1) {                                                                 \
+        int first = ARITY * i + 1;                                              \
+        if (first >= n) break;                                                  \
+        int last = first + ARITY < n ? first + ARITY : n;                       \
+        int best = first;                                                       \
+        for (int c = first + 1; c < last; c++) {                                \
+            best = BEFORE(heap->arr[c].key, heap->arr[best].key) ? c : best;    \
+        }                                                                       \
+        if (!BEFORE(heap->arr[best].key, entry.key)) break;                     \
+        place##Name(heap, i, heap->arr[best]);                                  \
+        i = best;                                                               \
+    }                                                                           \
+    place##Name(heap, i, entry);                                                \
+}                                                                               \
+                                                                                \
+/* O(1) */                                                                      \
+bool contains##Name(const Name *heap, int handle) {                             \
+    return handle >= 0 && handle < heap->numHandles && heap->position[handle] != -1; \
+}                                                                               \
+                                                                                \
+/* Key of a handle in the heap (check containsName() first) */                  \
+KeyType keyOf##Name(const Name *heap, int handle) {                             \
+    return heap->arr[heap->position[handle]].key;                               \
+}                                                                               \
+                                                                                \
+/* Root entry without removing it; false if the heap is empty. O(1) */          \
+bool peek##Name(const Name *heap, int *handle, KeyType *key) {                  \
+    if (heap->size == 0) return false;                                          \
+    *handle = heap->arr[0].handle;                                              \
+    *key = heap->arr[0].key;                                                    \
+    return true;                                                                \
+}                                                                               \
+                                                                                \
+/* Add a handle that is not in the heap yet */                                  \
+bool push##Name(Name *heap, int handle, KeyType key) {                          \
+    if (handle < 0 || contains##Name(heap, handle)) return false;               \
+    if (handle >= heap->numHandles) {                                           \
+        int numHandles = heap->numHandles < 16 ? 16 : heap->numHandles;         \
+        while (numHandles <= handle) {                                          \
+            if (numHandles > INT_MAX / 2) {                                     \
+                printf("Heap overflow!\n");                                     \
+                return false;                                                   \
+            }                                                                   \
+            numHandles *= 2;                                                    \
+        }                                                                       \
+        if (!reserveHandles##Name(heap, numHandles)) return false;              \
+    }                                                                           \
+    Name##Entry entry = {key, handle};                                          \
+    place##Name(heap, heap->size, entry);                                       \
+    heap->size++;                                                               \
+    siftUp##Name(heap, heap->size - 1);                                         \
+    return true;                                                                \
+}                                                                               \
+                                                                                \
+/* Give a handle in the heap a new key, moving it up or down */                 \
+bool changeKey##Name(Name *heap, int handle, KeyType key) {                     \
+    if (!contains##Name(heap, handle)) return false;                            \
+    int i = heap->position[handle];                                             \
+    KeyType old = heap->arr[i].key;                                             \
+    heap->arr[i].key = key;                                                     \
+    if (BEFORE(key, old)) {                                                     \
+        siftUp##Name(heap, i);                                                  \
+    } else {                                                                    \
+        siftDown##Name(heap, i);                                                \
+    }                                                                           \
+    return true;                                                                \
+}                                                                               \
+                                                                                \
+/* Move a handle towards the root (smaller key in a min heap); false if the   \
+   new key would move it the other way */                                     \
+bool decreaseKey##Name(Name *heap, int handle, KeyType key) {                   \
+    if (!contains##Name(heap, handle) || BEFORE(keyOf##Name(heap, handle), key)) { \
+        return false;                                                           \
+    }                                                                           \
+    int i = heap->position[handle];                                             \
+    heap->arr[i].key = key;                                                     \
+    siftUp##Name(heap, i);                                                      \
+    return true;                                                                \
+}                                                                               \
+                                                                                \
+/* Move a handle away from the root; false if the new key would move it up */  \
+bool increaseKey##Name(Name *heap, int handle, KeyType key) {                   \
+    if (!contains##Name(heap, handle) || BEFORE(key, keyOf##Name(heap, handle))) { \
+        return false;                                                           \
+    }                                                                           \
+    int i = heap->position[handle];                                             \
+    heap->arr[i].key = key;                                                     \
+    siftDown##Name(heap, i);                                                    \
+    return true;                                                                \
+}                                                                               \
+                                                                                \
+/* Remove any handle: the last entry fills its slot and moves up or down */    \
+bool remove##Name(Name *heap, int handle) {                                     \
+    if (!contains##Name(heap, handle)) return false;                            \
+    int i = heap->position[handle];                                             \
+    KeyType removed = heap->arr[i].key;                                         \
+    heap->position[handle] = -1;                                                \
+    heap->size--;                                                               \
+    if (i == heap->size) return true;                                           \
+                                                                                \
+    place##Name(heap, i, heap->arr[heap->size]);                                \
+    if (BEFORE(heap->arr[i].key, removed)) {                                    \
+        siftUp##Name(heap, i);                                                  \
+    } else {                                                                    \
+        siftDown##Name(heap, i);                                                \
+    }                                                                           \
+    return true;                                                                \
+}                                                                               \
+                                                                                \
+/* Remove the root; false if the heap is empty */                               \
+bool extract##Name(Name *heap, int *handle, KeyType *key) {                     \
+    if (!peek##Name(heap, handle, key)) return false;                           \
+    heap->position[*handle] = -1;                                               \
+    heap->size--;                                                               \
+    if (heap->size > 0) {                                                       \
+        place##Name(heap, 0, heap->arr[heap->size]);                            \
+        siftDown##Name(heap, 0);                                                \
+    }                                                                           \
+    return true;                                                                \
+}                                                                               \
+                                                                                \
+/* Heap property and position map agree with the array */                      \
+bool validate##Name(const Name *heap) {                                         \
+    int present = 0;                                                            \
+    for (int i = 0; i < heap->size; i++) {                                      \
+        if (heap->position[heap->arr[i].handle] != i) return false;             \
+        if (i > 0 && BEFORE(heap->arr[i].key, heap->arr[(i - 1) / ARITY].key)) { \
+            return false;                                                       \
+        }                                                                       \
+    }                                                                           \
+    for (int h = 0; h < heap->numHandles; h++) {                                \
+        if (heap->position[h] != -1) present++;                                 \
+    }                                                                           \
+    return present == heap->size;                                               \
 }
 
+// Min heap and max heap of ints
+DEFINE_HEAP(MinHeap, int, VALUE_KEY, LESS_THAN)
+DEFINE_HEAP(MaxHeap, int, VALUE_KEY, GREATER_THAN)
+
+// Job queue: earliest timestamp first, job id carried as payload. Four
+// 16-byte jobs fill a cache line, so the queue is 4-ary.
+typedef struct {
+    long long timestamp;
+    int jobId;
+} Job;
+
+#define JOB_TIMESTAMP(job) ((job).timestamp)
+
+DEFINE_DARY_HEAP(JobQueue, Job, JOB_TIMESTAMP, LESS_THAN, 4, SCAN_BEST_CHILD)
+
+// Priorities of jobs identified by id, changeable while queued
+DEFINE_INDEXED_HEAP(IndexedMinHeap, int, LESS_THAN, 4)
+
 // Extract minimum
 int extractMin(MinHeap *heap) {
-    if (heap->size <= 0) {
+    int min;
+    if (!extractMinHeap(heap, &min)) {
         printf("Heap is empty!\n");
         return -1;
     }
-    
-    int min = heap->arr[0];
-    heap->arr[0] = heap->arr[heap->size - 1];
-    heap->size--;
-    minHeapifyDown(heap, 0);
-    
     return min;
 }
 
@@ -127,118 +754,1154 @@ void displayMinHeap(MinHeap *heap) {
 }
 
 
-// Initialize max heap
-void initMaxHeap(MaxHeap *heap) {
-    heap->size = 0;
+// Extract maximum
+int extractMax(MaxHeap *heap) {
+    int max;
+    if (!extractMaxHeap(heap, &max)) {
+        printf("Heap is empty!\n");
+        return -1;
+    }
+    return max;
+}
+
+// Display max heap
+void displayMaxHeap(MaxHeap *heap) {
+    printf("Max Heap: [");
+    for (int i = 0; i < heap->size; i++) {
+        printf("%d", heap->arr[i]);
+        if (i < heap->size - 1) printf(", ");
+    }
+    printf("]\n");
+}
+
+// Display indexed heap as job:priority pairs in array order
+void displayIndexedMinHeap(IndexedMinHeap *heap) {
+    printf("Indexed Min Heap: [");
+    for (int i = 0; i < heap->size; i++) {
+        printf("job %d: %d", heap->arr[i].handle, heap->arr[i].key);
+        if (i < heap->size - 1) printf(", ");
+    }
+    printf("]\n");
+}
+
+
+void printHeapTree(int arr[], int n, int i, int level) {
+    if (i < n) {
+        printHeapTree(arr, n, getRightChild(i), level + 1);
+        
+        for (int j = 0; j < level; j++) {
+            printf("    ");
+        }
+        printf("%d\n", arr[i]);
+        
+        printHeapTree(arr, n, getLeftChild(i), level + 1);
+    }
+}
+
+void visualizeMinHeap(MinHeap *heap) {
+    printf("\nMin Heap Tree Structure:\n");
+    printHeapTree(heap->arr, heap->size, 0, 0);
+}
+
+void visualizeMaxHeap(MaxHeap *heap) {
+    printf("\nMax Heap Tree Structure:\n");
+    printHeapTree(heap->arr, heap->size, 0, 0);
+}
+
+// Streaming top-k: the k largest values seen so far in a min heap of size
+// k. Its root is the k-th largest, so a new value matters only if it is
+// larger than the root, and then it replaces the root (replaceTopMinHeap).
+// Memory stays at k values however long the stream is.
+typedef struct {
+    MinHeap heap;
+    int k;
+    long long seen;         // values offered so far
+} TopK;
+
+// Values checked per block by addManyTopK() before looking at any one of them
+#define TOPK_BLOCK 16
+
+bool initTopK(TopK *topK, int k) {
+    initMinHeap(&topK->heap);
+    topK->k = k;
+    topK->seen = 0;
+    if (k < 1) {
+        printf("Invalid k!\n");
+        return false;
+    }
+    return reserveMinHeap(&topK->heap, k);
+}
+
+void freeTopK(TopK *topK) {
+    freeMinHeap(&topK->heap);
+}
+
+void addTopK(TopK *topK, int value) {
+    topK->seen++;
+    if (topK->heap.size < topK->k) {
+        insertMinHeap(&topK->heap, value);
+    } else if (value > topK->heap.arr[0]) {
+        int dropped;
+        replaceTopMinHeap(&topK->heap, value, &dropped);
+    }
+}
+
+// Offer values[0..n-1]. Once the heap is full almost every value is below
+// the k-th largest, so the values are checked a block at a time against a
+// copy of the root held in a local (the check vectorizes) and a block is
+// only walked value by value when something in it beats the root.
+void addManyTopK(TopK *topK, const int *values, int n) {
+    int i = 0;
+    while (i < n && topK->heap.size < topK->k) {
+        addTopK(topK, values[i++]);
+    }
+    topK->seen += n - i;
+    if (i == n) return;
+    
+    int threshold = topK->heap.arr[0];
+    for (; i < n; i += TOPK_BLOCK) {
+        int end = i + TOPK_BLOCK < n ? i + TOPK_BLOCK : n;
+        if (end - i == TOPK_BLOCK) {
+            const int *block = values + i;
+            int above = 0;
+            for (int j = 0; j < TOPK_BLOCK; j++) above |= block[j] > threshold;
+            if (!above) continue;
+        }
+        for (int j = i; j < end; j++) {
+            if (values[j] > threshold) {
+                int dropped;
+                replaceTopMinHeap(&topK->heap, values[j], &dropped);
+                threshold = topK->heap.arr[0];
+            }
+        }
+    }
+}
+
+// k-th largest value so far (the smallest of the top k); false while fewer
+// than k values were seen
+bool kthLargestTopK(const TopK *topK, int *value) {
+    if (topK->heap.size < topK->k) return false;
+    *value = topK->heap.arr[0];
+    return true;
+}
+
+// Copy the current top values into out[] from largest to smallest; returns
+// how many (k, or fewer while the stream is shorter than k)
+int sortedTopK(const TopK *topK, int *out) {
+    MinHeap copy;
+    initMinHeap(&copy);
+    if (!buildMinHeap(&copy, topK->heap.arr, topK->heap.size)) return 0;
+    int count = extractManyMinHeap(&copy, out, copy.size);
+    for (int i = 0, j = count - 1; i < j; i++, j--) {
+        int temp = out[i];
+        out[i] = out[j];
+        out[j] = temp;
+    }
+    freeMinHeap(&copy);
+    return count;
+}
+
+// k-th largest of values[0..n-1] for a batch that is already in memory:
+// quickselect in place, O(n) on average and no extra memory. Afterwards
+// values[0..k-1] are the k largest. Requires 1 <= k <= n.
+int kthLargest(int *values, int n, int k) {
+    selectFirstMaxHeap(values, n, k);
+    return values[k - 1];
+}
+
+// Running median: the smaller half of the values in a max heap and the
+// larger half in a min heap, the max heap holding the extra value when the
+// count is odd. The median is read from the two roots.
+typedef struct {
+    MaxHeap lower;
+    MinHeap upper;
+} RunningMedian;
+
+void initRunningMedian(RunningMedian *median) {
+    initMaxHeap(&median->lower);
+    initMinHeap(&median->upper);
+}
+
+void freeRunningMedian(RunningMedian *median) {
+    freeMaxHeap(&median->lower);
+    freeMinHeap(&median->upper);
+}
+
+// Add a value. When it lands on the side that is already full, it goes in
+// through replaceTop and the displaced root crosses to the other side, so
+// every value costs one sift per heap at most.
+bool addRunningMedian(RunningMedian *median, int value) {
+    int moved = 0;
+    
+    if (median->lower.size > median->upper.size) {
+        // The value ends up counted in upper
+        if (value < median->lower.arr[0]) {
+            replaceTopMaxHeap(&median->lower, value, &moved);
+            return insertMinHeap(&median->upper, moved);
+        }
+        return insertMinHeap(&median->upper, value);
+    }
+    // Equal sizes: the value ends up counted in lower
+    if (median->upper.size > 0 && value > median->upper.arr[0]) {
+        replaceTopMinHeap(&median->upper, value, &moved);
+        return insertMaxHeap(&median->lower, moved);
+    }
+    return insertMaxHeap(&median->lower, value);
+}
+
+// Median of the values so far (mean of the middle two for an even count);
+// false if there are none
+bool getRunningMedian(const RunningMedian *median, double *value) {
+    if (median->lower.size == 0) return false;
+    if (median->lower.size > median->upper.size) {
+        *value = median->lower.arr[0];
+    } else {
+        *value = ((double)median->lower.arr[0] + median->upper.arr[0]) / 2.0;
+    }
+    return true;
+}
+
+double getTimeSeconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Pseudo random generator (xorshift64*) with caller-owned state
+unsigned int nextRandom(unsigned long long *state) {
+    unsigned long long x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return (unsigned int)((x * 2685821657736338717ULL) >> 32);
 }
 
-// Heapify down for max heap
-void maxHeapifyDown(MaxHeap *heap, int i) {
-    int largest = i;
-    int left = getLeftChild(i);
-    int right = getRightChild(i);
+// Push jobs with random timestamps, then pop them all in timestamp order
+void benchmarkJobQueue(int numJobs) {
+    JobQueue queue;
+    unsigned long long state = 88172645463325252ULL;
+    initJobQueue(&queue);
     
-    if (left < heap->size && heap->arr[left] > heap->arr[largest]) {
-        largest = left;
+    double start = getTimeSeconds();
+    for (int i = 0; i < numJobs; i++) {
+        Job job;
+        job.timestamp = ((long long)nextRandom(&state) << 16) | (nextRandom(&state) & 0xFFFF);
+        job.jobId = i;
+        if (!insertJobQueue(&queue, job)) {
+            freeJobQueue(&queue);
+            return;
+        }
     }
+    double pushTime = getTimeSeconds() - start;
+    int capacity = queue.capacity;
     
-    if (right < heap->size && heap->arr[right] > heap->arr[largest]) {
-        largest = right;
+    start = getTimeSeconds();
+    Job job;
+    long long previous = -1;
+    bool ordered = true;
+    while (extractJobQueue(&queue, &job)) {
+        if (job.timestamp < previous) ordered = false;
+        previous = job.timestamp;
     }
+    double popTime = getTimeSeconds() - start;
+    shrinkJobQueue(&queue);
     
-    if (largest != i) {
-        swap(&heap->arr[i], &heap->arr[largest]);
-        maxHeapifyDown(heap, largest);
+    printf("\n%d jobs (%zu bytes each), capacity grew to %d\n", numJobs, sizeof(Job), capacity);
+    printf("Push: %.3f s (%.1f ns/job)\n", pushTime, 1e9 * pushTime / numJobs);
+    printf("Pop:  %.3f s (%.1f ns/job)\n", popTime, 1e9 * popTime / numJobs);
+    printf("Jobs popped in timestamp order: %s\n", ordered ? "OK" : "FAILED");
+    printf("Capacity after popping all and shrinking: %d\n", queue.capacity);
+    freeJobQueue(&queue);
+}
+
+// Concurrent job queue (MultiQueue). Instead of one heap behind one lock,
+// a relaxed queue has MULTIQUEUE_HEAPS_PER_THREAD heaps per thread, each
+// with its own lock. A push goes to a random heap; a pop looks at the roots
+// of two random heaps and takes the earlier one. Threads rarely meet on the
+// same lock, and when they do they try other heaps instead of waiting. The
+// price is order: a pop returns a job close to, but not always, the
+// earliest one (the rank error). A strict queue has a single heap, so pops
+// come out in exact timestamp order and every operation takes the one lock.
+typedef enum {
+    MULTIQUEUE_RELAXED,
+    MULTIQUEUE_STRICT
+} MultiQueueMode;
+
+#define EMPTY_TIMESTAMP LLONG_MAX
+
+// One heap of a MultiQueue, on cache lines of its own so that threads
+// working on neighboring heaps do not invalidate each other's lines. top is
+// polled by every popping thread while the lock holder writes the lock word
+// and the heap fields, so it gets a line of its own as well.
+typedef struct {
+    pthread_mutex_t lock;
+    JobQueue heap;
+    // root timestamp or EMPTY_TIMESTAMP, read without the lock
+    long long top __attribute__((aligned(HEAP_ALIGNMENT)));
+} __attribute__((aligned(HEAP_ALIGNMENT))) MultiQueueHeap;
+
+typedef struct {
+    MultiQueueHeap *heaps;
+    int numHeaps;
+    MultiQueueMode mode;
+    long long *popLog;      // if set, timestamps in the order pops took effect
+    int popLogSize;         // next slot of popLog, claimed under the heap's lock
+} MultiQueue;
+
+bool initMultiQueue(MultiQueue *queue, int numThreads, MultiQueueMode mode) {
+    if (numThreads < 1) numThreads = 1;
+    if (numThreads > MAX_THREADS) numThreads = MAX_THREADS;
+    queue->mode = mode;
+    queue->popLog = NULL;
+    queue->popLogSize = 0;
+    queue->numHeaps = mode == MULTIQUEUE_STRICT ? 1 : MULTIQUEUE_HEAPS_PER_THREAD * numThreads;
+    queue->heaps = (MultiQueueHeap*)aligned_alloc(HEAP_ALIGNMENT,
+                                                  queue->numHeaps * sizeof(MultiQueueHeap));
+    if (queue->heaps == NULL) {
+        printf("Memory allocation failed!\n");
+        return false;
+    }
+    for (int h = 0; h < queue->numHeaps; h++) {
+        pthread_mutex_init(&queue->heaps[h].lock, NULL);
+        initJobQueue(&queue->heaps[h].heap);
+        queue->heaps[h].top = EMPTY_TIMESTAMP;
     }
+    return true;
 }
 
-// Heapify up for max heap
-void maxHeapifyUp(MaxHeap *heap, int i) {
-    if (i && heap->arr[getParent(i)] < heap->arr[i]) {
-        swap(&heap->arr[i], &heap->arr[getParent(i)]);
-        maxHeapifyUp(heap, getParent(i));
+void freeMultiQueue(MultiQueue *queue) {
+    for (int h = 0; h < queue->numHeaps; h++) {
+        pthread_mutex_destroy(&queue->heaps[h].lock);
+        freeJobQueue(&queue->heaps[h].heap);
     }
+    free(queue->heaps);
+    queue->heaps = NULL;
+    queue->numHeaps = 0;
 }
 
-// Build max heap from array
-void buildMaxHeap(MaxHeap *heap, int arr[], int n) {
-    if (n > MAX_SIZE) {
-        printf("Array size exceeds maximum heap size!\n");
-        return;
+// Publish the root of a heap whose lock the caller holds
+void updateMultiQueueTop(MultiQueueHeap *heap) {
+    Job *root = peekJobQueue(&heap->heap);
+    __atomic_store_n(&heap->top, root != NULL ? root->timestamp : EMPTY_TIMESTAMP,
+                     __ATOMIC_RELAXED);
+}
+
+// Extract from a heap whose lock the caller holds, then release the lock
+bool takeFromMultiQueueHeap(MultiQueue *queue, MultiQueueHeap *heap, Job *out) {
+    bool ok = extractJobQueue(&heap->heap, out);
+    if (ok && queue->popLog != NULL) {
+        int slot = __atomic_fetch_add(&queue->popLogSize, 1, __ATOMIC_RELAXED);
+        queue->popLog[slot] = out->timestamp;
+    }
+    updateMultiQueueTop(heap);
+    pthread_mutex_unlock(&heap->lock);
+    return ok;
+}
+
+// Lock one heap: the strict queue waits for its only lock, a relaxed one
+// tries random heaps until it finds a free lock. After a busy lock the
+// thread yields: the holder may have been descheduled mid-operation (more
+// threads than cores), and while it is, its heap's jobs fall behind.
+MultiQueueHeap *lockMultiQueueHeap(MultiQueue *queue, unsigned long long *state) {
+    if (queue->numHeaps == 1) {
+        pthread_mutex_lock(&queue->heaps[0].lock);
+        return &queue->heaps[0];
+    }
+    while (1) {
+        MultiQueueHeap *heap = &queue->heaps[nextRandom(state) % queue->numHeaps];
+        if (pthread_mutex_trylock(&heap->lock) == 0) return heap;
+        sched_yield();
+    }
+}
+
+// Add a job; state is the calling thread's random generator
+bool pushMultiQueue(MultiQueue *queue, Job job, unsigned long long *state) {
+    MultiQueueHeap *heap = lockMultiQueueHeap(queue, state);
+    bool ok = insertJobQueue(&heap->heap, job);
+    updateMultiQueueTop(heap);
+    pthread_mutex_unlock(&heap->lock);
+    return ok;
+}
+
+// Remove a job into *out: the earliest one in strict mode, the earlier of
+// two random heaps' roots in relaxed mode. Returns false only after every
+// heap was seen empty.
+bool popMultiQueue(MultiQueue *queue, Job *out, unsigned long long *state) {
+    if (queue->mode == MULTIQUEUE_STRICT) {
+        return takeFromMultiQueueHeap(queue, lockMultiQueueHeap(queue, state), out);
     }
     
-    heap->size = n;
-    for (int i = 0; i < n; i++) {
-        heap->arr[i] = arr[i];
+    while (1) {
+        int a = nextRandom(state) % queue->numHeaps;
+        int b = nextRandom(state) % queue->numHeaps;
+        long long topA = __atomic_load_n(&queue->heaps[a].top, __ATOMIC_RELAXED);
+        long long topB = __atomic_load_n(&queue->heaps[b].top, __ATOMIC_RELAXED);
+        int chosen = topB < topA ? b : a;
+        
+        if (topA == EMPTY_TIMESTAMP && topB == EMPTY_TIMESTAMP) {
+            // Both looked empty: look for any non-empty heap before giving up
+            chosen = -1;
+            for (int h = 0; h < queue->numHeaps && chosen < 0; h++) {
+                int candidate = (a + h) % queue->numHeaps;
+                if (__atomic_load_n(&queue->heaps[candidate].top, __ATOMIC_RELAXED) != EMPTY_TIMESTAMP) {
+                    chosen = candidate;
+                }
+            }
+            if (chosen < 0) return false;
+        }
+        
+        MultiQueueHeap *heap = &queue->heaps[chosen];
+        if (pthread_mutex_trylock(&heap->lock) != 0) {
+            sched_yield();
+            continue;
+        }
+        // Another thread may have emptied it since the root was read
+        if (takeFromMultiQueueHeap(queue, heap, out)) return true;
+    }
+}
+
+// Comparison counter of CountedMinHeap
+long long heapComparisons = 0;
+#define COUNTED_LESS_THAN(a, b) (heapComparisons++, (a) < (b))
+
+DEFINE_HEAP(CountedMinHeap, int, VALUE_KEY, COUNTED_LESS_THAN)
+
+// Sift implementations compared by benchmarkSiftVariants()
+typedef enum {
+    SIFT_SWAP,          // recursive, three-write swap per level (original)
+    SIFT_HOLE,          // iterative hole-based sift-up and sift-down
+    SIFT_BOTTOM_UP      // hole-based sift-up, Floyd bottom-up extraction
+} SiftVariant;
+
+typedef struct {
+    double pushTime;
+    double popTime;
+    long long pushComparisons;
+    long long popComparisons;
+    bool ordered;           // values came out in non-decreasing order
+} SiftRun;
+
+// Insert values[0..n-1] into an empty int min heap with room for n, then
+// extract them all, with the given variant (the array is written directly,
+// so only the sifts differ)
+#define DEFINE_SIFT_RUN(Name)                                                   \
+SiftRun runSiftVariant##Name(Name *heap, const int *values, int n, SiftVariant variant) { \
+    SiftRun run;                                                                \
+    long long comparisons = heapComparisons;                                    \
+    heap->size = 0;                                                             \
+                                                                                \
+    double start = getTimeSeconds();                                            \
+    for (int i = 0; i < n; i++) {                                               \
+        heap->arr[heap->size++] = values[i];                                    \
+        if (variant == SIFT_SWAP) {                                             \
+            siftUpSwap##Name(heap, heap->size - 1);                             \
+        } else {                                                                \
+            siftUp##Name(heap, heap->size - 1);                                 \
+        }                                                                       \
+    }                                                                           \
+    run.pushTime = getTimeSeconds() - start;                                    \
+    run.pushComparisons = heapComparisons - comparisons;                        \
+                                                                                \
+    comparisons = heapComparisons;                                              \
+    run.ordered = true;                                                         \
+    int previous = INT_MIN, value = 0;                                          \
+    start = getTimeSeconds();                                                   \
+    for (int i = 0; i < n; i++) {                                               \
+        if (variant == SIFT_SWAP) {                                             \
+            value = heap->arr[0];                                               \
+            heap->arr[0] = heap->arr[--heap->size];                             \
+            siftDownSwap##Name(heap, 0);                                        \
+        } else if (variant == SIFT_HOLE) {                                      \
+            extract##Name(heap, &value);                                        \
+        } else {                                                                \
+            extractBottomUp##Name(heap, &value);                                \
+        }                                                                       \
+        if (value < previous) run.ordered = false;                              \
+        previous = value;                                                       \
+    }                                                                           \
+    run.popTime = getTimeSeconds() - start;                                     \
+    run.popComparisons = heapComparisons - comparisons;                         \
+    return run;                                                                 \
+}
+
+DEFINE_SIFT_RUN(MinHeap)
+DEFINE_SIFT_RUN(CountedMinHeap)
+
+// d-ary int min heaps compared by benchmarkHeapArity()
+DEFINE_DARY_HEAP(MinHeap4, int, VALUE_KEY, LESS_THAN, 4, SCAN_BEST_CHILD)
+DEFINE_DARY_HEAP(MinHeap8, int, VALUE_KEY, LESS_THAN, 8, SCAN_BEST_CHILD)
+DEFINE_DARY_HEAP(MinHeap8Simd, int, VALUE_KEY, LESS_THAN, 8, SIMD_MIN8_CHILD)
+
+DEFINE_SIFT_RUN(MinHeap4)
+DEFINE_SIFT_RUN(MinHeap8)
+DEFINE_SIFT_RUN(MinHeap8Simd)
+
+// Time and comparisons per push/pop of each sift variant for heap sizes
+// 1K, 10K, ... up to maxSize
+void benchmarkSiftVariants(int maxSize) {
+    const char *names[] = {"swap (recursive)", "hole", "hole + bottom-up"};
+    MinHeap heap;
+    CountedMinHeap counted;
+    unsigned long long state = 88172645463325252ULL;
+    
+    initMinHeap(&heap);
+    initCountedMinHeap(&counted);
+    int *values = (int*)malloc((size_t)maxSize * sizeof(int));
+    if (values == NULL || !reserveMinHeap(&heap, maxSize) ||
+        !reserveCountedMinHeap(&counted, maxSize < SIFT_COUNT_LIMIT ? maxSize : SIFT_COUNT_LIMIT)) {
+        printf("Memory allocation failed!\n");
+        free(values);
+        freeMinHeap(&heap);
+        freeCountedMinHeap(&counted);
+        return;
+    }
+    for (int i = 0; i < maxSize; i++) {
+        values[i] = (int)(nextRandom(&state) >> 1);
     }
     
-    // Start from last non-leaf node and heapify down
-    for (int i = (n / 2) - 1; i >= 0; i--) {
-        maxHeapifyDown(heap, i);
+    printf("\n%-12s %-18s %10s %10s %10s %10s\n", "Size", "Variant", "Push ns", "Pop ns",
+           "Push cmp", "Pop cmp");
+    for (long long size = 1000; size <= maxSize; size *= 10) {
+        int n = (int)size;
+        // Best of several runs where they are cheap, to filter out noise
+        int repeats = n <= 1000000 ? 5 : 1;
+        for (int v = SIFT_SWAP; v <= SIFT_BOTTOM_UP; v++) {
+            SiftRun run = runSiftVariantMinHeap(&heap, values, n, (SiftVariant)v);
+            for (int r = 1; r < repeats; r++) {
+                SiftRun again = runSiftVariantMinHeap(&heap, values, n, (SiftVariant)v);
+                if (again.pushTime < run.pushTime) run.pushTime = again.pushTime;
+                if (again.popTime < run.popTime) run.popTime = again.popTime;
+                run.ordered = run.ordered && again.ordered;
+            }
+            printf("%-12d %-18s %10.1f %10.1f", n, names[v], 1e9 * run.pushTime / n,
+                   1e9 * run.popTime / n);
+            if (n <= SIFT_COUNT_LIMIT) {
+                SiftRun count = runSiftVariantCountedMinHeap(&counted, values, n, (SiftVariant)v);
+                run.ordered = run.ordered && count.ordered;
+                printf(" %10.2f %10.2f", (double)count.pushComparisons / n,
+                       (double)count.popComparisons / n);
+            } else {
+                printf(" %10s %10s", "-", "-");
+            }
+            printf("%s\n", run.ordered ? "" : "  FAILED");
+        }
     }
+    printf("Times and comparisons are per element\n");
+    
+    free(values);
+    freeMinHeap(&heap);
+    freeCountedMinHeap(&counted);
 }
 
-// Insert into max heap
-void insertMaxHeap(MaxHeap *heap, int value) {
-    if (heap->size >= MAX_SIZE) {
-        printf("Heap overflow!\n");
+// Push/pop time of binary, 4-ary, 8-ary and 8-ary SIMD min heaps (hole-based
+// sifts) for heap sizes 1K, 10K, ... up to maxSize
+void benchmarkHeapArity(int maxSize) {
+    const char *names[] = {"binary", "4-ary", "8-ary", "8-ary SIMD"};
+    MinHeap heap2;
+    MinHeap4 heap4;
+    MinHeap8 heap8;
+    MinHeap8Simd heap8Simd;
+    unsigned long long state = 88172645463325252ULL;
+    
+    initMinHeap(&heap2);
+    initMinHeap4(&heap4);
+    initMinHeap8(&heap8);
+    initMinHeap8Simd(&heap8Simd);
+    int *values = (int*)malloc((size_t)maxSize * sizeof(int));
+    if (values == NULL || !reserveMinHeap(&heap2, maxSize) || !reserveMinHeap4(&heap4, maxSize) ||
+        !reserveMinHeap8(&heap8, maxSize) || !reserveMinHeap8Simd(&heap8Simd, maxSize)) {
+        printf("Memory allocation failed!\n");
+        free(values);
+        freeMinHeap(&heap2);
+        freeMinHeap4(&heap4);
+        freeMinHeap8(&heap8);
+        freeMinHeap8Simd(&heap8Simd);
         return;
     }
+    for (int i = 0; i < maxSize; i++) {
+        values[i] = (int)(nextRandom(&state) >> 1);
+    }
     
-    heap->arr[heap->size] = value;
-    heap->size++;
-    maxHeapifyUp(heap, heap->size - 1);
+    printf("\n%-12s %-12s %10s %10s %10s %12s\n", "Size", "Heap", "Size MB", "Push ns",
+           "Pop ns", "Pop speedup");
+    for (long long size = 1000; size <= maxSize; size *= 10) {
+        int n = (int)size;
+        int repeats = n <= 1000000 ? 5 : 1;
+        double binaryPop = 0.0;
+        
+        for (int h = 0; h < 4; h++) {
+            SiftRun best;
+            for (int r = 0; r < repeats; r++) {
+                SiftRun run;
+                if (h == 0) {
+                    run = runSiftVariantMinHeap(&heap2, values, n, SIFT_HOLE);
+                } else if (h == 1) {
+                    run = runSiftVariantMinHeap4(&heap4, values, n, SIFT_HOLE);
+                } else if (h == 2) {
+                    run = runSiftVariantMinHeap8(&heap8, values, n, SIFT_HOLE);
+                } else {
+                    run = runSiftVariantMinHeap8Simd(&heap8Simd, values, n, SIFT_HOLE);
+                }
+                if (r == 0) {
+                    best = run;
+                } else {
+                    if (run.pushTime < best.pushTime) best.pushTime = run.pushTime;
+                    if (run.popTime < best.popTime) best.popTime = run.popTime;
+                    best.ordered = best.ordered && run.ordered;
+                }
+            }
+            if (h == 0) binaryPop = best.popTime;
+            printf("%-12d %-12s %10.1f %10.1f %10.1f %11.2fx%s\n", n, names[h],
+                   n * sizeof(int) / 1048576.0, 1e9 * best.pushTime / n, 1e9 * best.popTime / n,
+                   binaryPop / best.popTime, best.ordered ? "" : "  FAILED");
+        }
+    }
+    printf("Times are per element; speedup is relative to the binary heap\n");
+    
+    free(values);
+    freeMinHeap(&heap2);
+    freeMinHeap4(&heap4);
+    freeMinHeap8(&heap8);
+    freeMinHeap8Simd(&heap8Simd);
 }
 
-// Extract maximum
-int extractMax(MaxHeap *heap) {
-    if (heap->size <= 0) {
-        printf("Heap is empty!\n");
-        return -1;
+// Random operations on an indexed heap, checked against plain arrays of
+// keys (the expected root is found by a linear scan), then the time of push,
+// decrease-key and extract with numHandles handles
+void testIndexedHeap(int numOps, int numHandles) {
+    IndexedMinHeap heap;
+    int *refKey = (int*)malloc((size_t)numHandles * sizeof(int));
+    bool *refPresent = (bool*)calloc((size_t)numHandles, sizeof(bool));
+    unsigned long long state = 88172645463325252ULL;
+    long long failures = 0;
+    int refSize = 0;
+    
+    initIndexedMinHeap(&heap);
+    if (refKey == NULL || refPresent == NULL) {
+        printf("Memory allocation failed!\n");
+        free(refKey);
+        free(refPresent);
+        return;
     }
     
-    int max = heap->arr[0];
-    heap->arr[0] = heap->arr[heap->size - 1];
-    heap->size--;
-    maxHeapifyDown(heap, 0);
+    for (int op = 0; op < numOps; op++) {
+        int handle = nextRandom(&state) % 1000;
+        int key = nextRandom(&state) % 10000;
+        int kind = nextRandom(&state) % 100;
+        bool ok;
+        
+        if (kind < 35) {
+            ok = pushIndexedMinHeap(&heap, handle, key) == !refPresent[handle];
+            if (!refPresent[handle]) {
+                refPresent[handle] = true;
+                refKey[handle] = key;
+                refSize++;
+            }
+        } else if (kind < 55) {
+            ok = changeKeyIndexedMinHeap(&heap, handle, key) == refPresent[handle];
+            if (refPresent[handle]) refKey[handle] = key;
+        } else if (kind < 70) {
+            bool expected = refPresent[handle] && key <= refKey[handle];
+            ok = decreaseKeyIndexedMinHeap(&heap, handle, key) == expected;
+            if (expected) refKey[handle] = key;
+        } else if (kind < 80) {
+            bool expected = refPresent[handle] && key >= refKey[handle];
+            ok = increaseKeyIndexedMinHeap(&heap, handle, key) == expected;
+            if (expected) refKey[handle] = key;
+        } else if (kind < 90) {
+            ok = removeIndexedMinHeap(&heap, handle) == refPresent[handle];
+            if (refPresent[handle]) {
+                refPresent[handle] = false;
+                refSize--;
+            }
+        } else {
+            int minKey = INT_MAX;
+            for (int h = 0; h < 1000; h++) {
+                if (refPresent[h] && refKey[h] < minKey) minKey = refKey[h];
+            }
+            int gotHandle, gotKey;
+            if (extractIndexedMinHeap(&heap, &gotHandle, &gotKey)) {
+                ok = refSize > 0 && gotKey == minKey && refPresent[gotHandle] &&
+                     refKey[gotHandle] == gotKey;
+                refPresent[gotHandle] = false;
+                refSize--;
+            } else {
+                ok = refSize == 0;
+            }
+        }
+        
+        if (!ok || heap.size != refSize ||
+            containsIndexedMinHeap(&heap, handle) != refPresent[handle] ||
+            (op % 100 == 0 && !validateIndexedMinHeap(&heap))) {
+            failures++;
+        }
+    }
+    printf("\n%d random operations on 1000 handles\n", numOps);
+    printf("Mismatches against reference: %lld (%s)\n", failures, failures == 0 ? "OK" : "FAILED");
+    freeIndexedMinHeap(&heap);
     
-    return max;
+    // Dijkstra-like workload: every handle pushed, lowered once, extracted
+    initIndexedMinHeap(&heap);
+    if (!reserveHandlesIndexedMinHeap(&heap, numHandles)) {
+        free(refKey);
+        free(refPresent);
+        return;
+    }
+    double start = getTimeSeconds();
+    for (int h = 0; h < numHandles; h++) {
+        refKey[h] = (int)(nextRandom(&state) >> 1);
+        pushIndexedMinHeap(&heap, h, refKey[h]);
+    }
+    double pushTime = getTimeSeconds() - start;
+    
+    start = getTimeSeconds();
+    for (int i = 0; i < numHandles; i++) {
+        int h = nextRandom(&state) % numHandles;
+        refKey[h] /= 2;
+        decreaseKeyIndexedMinHeap(&heap, h, refKey[h]);
+    }
+    double decreaseTime = getTimeSeconds() - start;
+    
+    start = getTimeSeconds();
+    int handle, key, previous = INT_MIN;
+    bool ordered = true;
+    while (extractIndexedMinHeap(&heap, &handle, &key)) {
+        if (key < previous || key != refKey[handle]) ordered = false;
+        previous = key;
+    }
+    double popTime = getTimeSeconds() - start;
+    
+    printf("\n%d handles (4-ary indexed heap)\n", numHandles);
+    printf("Push:         %.1f ns/op\n", 1e9 * pushTime / numHandles);
+    printf("Decrease-key: %.1f ns/op\n", 1e9 * decreaseTime / numHandles);
+    printf("Extract:      %.1f ns/op\n", 1e9 * popTime / numHandles);
+    printf("Extracted in key order with final keys: %s\n", ordered ? "OK" : "FAILED");
+    
+    freeIndexedMinHeap(&heap);
+    free(refKey);
+    free(refPresent);
 }
 
-// Display max heap
-void displayMaxHeap(MaxHeap *heap) {
-    printf("Max Heap: [");
-    for (int i = 0; i < heap->size; i++) {
-        printf("%d", heap->arr[i]);
-        if (i < heap->size - 1) printf(", ");
+// True if no element of a binary min heap is smaller than its parent
+bool isMinHeap(const MinHeap *heap) {
+    for (int i = 1; i < heap->size; i++) {
+        if (heap->arr[i] < heap->arr[getParent(i)]) return false;
     }
-    printf("]\n");
+    return true;
 }
 
+void printBatchRow(const char *operation, double oneByOne, double batch, bool ok) {
+    printf("%-30s %12.2f %10.2f %8.1fx  %s\n", operation, 1e3 * oneByOne, 1e3 * batch,
+           oneByOne / batch, ok ? "OK" : "FAILED");
+}
 
-void printHeapTree(int arr[], int n, int i, int level) {
-    if (i < n) {
-        printHeapTree(arr, n, getRightChild(i), level + 1);
+// Bulk insert, top-k extraction and meld against the one-at-a-time loops
+// they replace, on a min heap of n random ints
+void benchmarkBatchOperations(int n) {
+    MinHeap heap, other;
+    unsigned long long state = 88172645463325252ULL;
+    char label[64];
+    
+    initMinHeap(&heap);
+    initMinHeap(&other);
+    int *values = (int*)malloc(2 * (size_t)n * sizeof(int));
+    int *expected = (int*)malloc((size_t)n * sizeof(int));
+    int *out = (int*)malloc((size_t)n * sizeof(int));
+    if (values == NULL || expected == NULL || out == NULL ||
+        !reserveMinHeap(&heap, 2 * n) || !reserveMinHeap(&other, n)) {
+        printf("Memory allocation failed!\n");
+        free(values);
+        free(expected);
+        free(out);
+        freeMinHeap(&heap);
+        freeMinHeap(&other);
+        return;
+    }
+    for (int i = 0; i < 2 * n; i++) {
+        values[i] = (int)(nextRandom(&state) >> 1);
+    }
+    // Touch both output arrays so that neither timing pays for page faults
+    memset(expected, 0, (size_t)n * sizeof(int));
+    memset(out, 0, (size_t)n * sizeof(int));
+    
+    printf("\nMin heap of %d random ints\n", n);
+    printf("%-30s %12s %10s %9s\n", "Operation", "One-by-one ms", "Batch ms", "Speedup");
+    
+    // Batches of random values, and one that sifts every value to the root
+    int batches[] = {n / 1000 > 0 ? n / 1000 : 1, n / 10, n, n / 10};
+    for (int b = 0; b < 4; b++) {
+        int count = batches[b];
+        int *batch = values + n;
+        bool descending = b == 3;
+        if (descending) {
+            for (int i = 0; i < count; i++) batch[i] = -i;
+        }
         
-        for (int j = 0; j < level; j++) {
-            printf("    ");
+        buildMinHeap(&heap, values, n);
+        double start = getTimeSeconds();
+        for (int i = 0; i < count; i++) insertMinHeap(&heap, batch[i]);
+        double oneByOne = getTimeSeconds() - start;
+        
+        buildMinHeap(&heap, values, n);
+        start = getTimeSeconds();
+        insertManyMinHeap(&heap, batch, count);
+        double bulk = getTimeSeconds() - start;
+        
+        snprintf(label, sizeof(label), "Insert %d%s", count, descending ? " descending" : "");
+        printBatchRow(label, oneByOne, bulk, heap.size == n + count && isMinHeap(&heap));
+    }
+    for (int i = 0; i < n; i++) {
+        values[n + i] = (int)(nextRandom(&state) >> 1);
+    }
+    
+    int ks[] = {10, n / 100, n / 10, n / 2};
+    for (int t = 0; t < 4; t++) {
+        int k = ks[t] < n ? ks[t] : n;
+        
+        buildMinHeap(&heap, values, n);
+        double start = getTimeSeconds();
+        for (int i = 0; i < k; i++) extractMinHeap(&heap, &expected[i]);
+        double oneByOne = getTimeSeconds() - start;
+        
+        buildMinHeap(&heap, values, n);
+        start = getTimeSeconds();
+        int got = extractManyMinHeap(&heap, out, k);
+        double batch = getTimeSeconds() - start;
+        
+        bool ok = got == k && heap.size == n - k && isMinHeap(&heap) &&
+                  memcmp(expected, out, (size_t)k * sizeof(int)) == 0;
+        snprintf(label, sizeof(label), "Extract %d smallest", k);
+        printBatchRow(label, oneByOne, batch, ok);
+    }
+    
+    // Meld a heap of n / 10 into one of n
+    int small = n / 10 > 0 ? n / 10 : 1;
+    buildMinHeap(&heap, values, n);
+    buildMinHeap(&other, values + n, small);
+    double start = getTimeSeconds();
+    int value;
+    while (extractMinHeap(&other, &value)) insertMinHeap(&heap, value);
+    double oneByOne = getTimeSeconds() - start;
+    
+    buildMinHeap(&heap, values, n);
+    buildMinHeap(&other, values + n, small);
+    start = getTimeSeconds();
+    meldMinHeap(&heap, &other);
+    double melded = getTimeSeconds() - start;
+    snprintf(label, sizeof(label), "Meld %d into %d", small, n);
+    printBatchRow(label, oneByOne, melded, heap.size == n + small && other.size == 0 && isMinHeap(&heap));
+    
+    free(values);
+    free(expected);
+    free(out);
+    freeMinHeap(&heap);
+    freeMinHeap(&other);
+}
+
+// Shared state of a MultiQueue benchmark run
+typedef struct {
+    MultiQueue *queue;
+    bool drain;             // pop until empty (rank error) instead of pop + push pairs
+    int opsPerThread;       // pop + push pairs per thread
+} MultiQueueContext;
+
+typedef struct {
+    MultiQueueContext *context;
+    unsigned long long state;
+    bool failed;
+} MultiQueueWorker;
+
+// Throughput run: pop a job and push it back with a later timestamp, as a
+// discrete-event simulation does. Drain run: pop everything (the queue's
+// pop log records the order).
+void *multiQueueWorker(void *arg) {
+    MultiQueueWorker *worker = (MultiQueueWorker*)arg;
+    MultiQueueContext *ctx = worker->context;
+    Job job;
+    
+    if (ctx->drain) {
+        while (popMultiQueue(ctx->queue, &job, &worker->state)) {}
+        return NULL;
+    }
+    for (int i = 0; i < ctx->opsPerThread; i++) {
+        if (!popMultiQueue(ctx->queue, &job, &worker->state)) {
+            worker->failed = true;
+            break;
         }
-        printf("%d\n", arr[i]);
+        job.timestamp += 1 + nextRandom(&worker->state) % 1024;
+        if (!pushMultiQueue(ctx->queue, job, &worker->state)) {
+            worker->failed = true;
+            break;
+        }
+    }
+    return NULL;
+}
+
+// Run numThreads workers (the calling thread is worker 0); returns seconds.
+// If a thread cannot be created, the ones already started still finish and
+// are joined, and *failed is set: the row would not measure numThreads.
+double runMultiQueueWorkers(MultiQueueContext *ctx, int numThreads, bool *failed) {
+    pthread_t threads[MAX_THREADS];
+    MultiQueueWorker workers[MAX_THREADS];
+    
+    for (int t = 0; t < numThreads; t++) {
+        workers[t].context = ctx;
+        workers[t].state = 88172645463325252ULL + 7919ULL * t;
+        workers[t].failed = false;
+    }
+    double start = getTimeSeconds();
+    int running = 1;
+    while (running < numThreads &&
+           pthread_create(&threads[running], NULL, multiQueueWorker, &workers[running]) == 0) {
+        running++;
+    }
+    if (running < numThreads) {
+        printf("Could only start %d of %d threads\n", running, numThreads);
+        *failed = true;
+    }
+    multiQueueWorker(&workers[0]);
+    for (int t = 1; t < running; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    double elapsed = getTimeSeconds() - start;
+    
+    for (int t = 0; t < running; t++) {
+        if (workers[t].failed) *failed = true;
+    }
+    return elapsed;
+}
+
+// Rank errors of a pop order of the timestamps 0..n-1. The rank of a pop is
+// the number of earlier timestamps still queued: timestamp minus how many
+// earlier ones were popped before it, counted with a Fenwick tree. Returns
+// false unless every timestamp was popped exactly once.
+bool multiQueueRankError(const long long *order, int n, double *meanRank, long long *maxRank) {
+    int *tree = (int*)calloc((size_t)n + 1, sizeof(int));
+    bool *seen = (bool*)calloc((size_t)n, sizeof(bool));
+    bool ok = tree != NULL && seen != NULL;
+    long long total = 0;
+    
+    *maxRank = 0;
+    for (int p = 0; p < n && ok; p++) {
+        long long t = order[p];
+        if (t < 0 || t >= n || seen[t]) {
+            ok = false;
+            break;
+        }
+        seen[t] = true;
+        int poppedBefore = 0;
+        for (int i = t; i > 0; i -= i & -i) poppedBefore += tree[i];
+        for (int i = t + 1; i <= n; i += i & -i) tree[i]++;
         
-        printHeapTree(arr, n, getLeftChild(i), level + 1);
+        long long rank = t - poppedBefore;
+        total += rank;
+        if (rank > *maxRank) *maxRank = rank;
     }
+    *meanRank = n > 0 ? (double)total / n : 0.0;
+    free(tree);
+    free(seen);
+    return ok;
 }
 
-void visualizeMinHeap(MinHeap *heap) {
-    printf("\nMin Heap Tree Structure:\n");
-    printHeapTree(heap->arr, heap->size, 0, 0);
+// Throughput of pop + push pairs and rank error of pops, for the strict
+// (one locked heap) and relaxed MultiQueue with 1, 2, 4, ... 64 threads
+void benchmarkMultiQueue(int numJobs) {
+    const char *modeNames[] = {"relaxed", "strict"};
+    MultiQueueMode modes[] = {MULTIQUEUE_STRICT, MULTIQUEUE_RELAXED};
+    unsigned long long state = 88172645463325252ULL;
+    int *timestamps = (int*)malloc((size_t)numJobs * sizeof(int));
+    long long *order = (long long*)malloc((size_t)numJobs * sizeof(long long));
+    
+    if (timestamps == NULL || order == NULL) {
+        printf("Memory allocation failed!\n");
+        free(timestamps);
+        free(order);
+        return;
+    }
+    // Timestamps 0..numJobs-1 in random order
+    for (int i = 0; i < numJobs; i++) timestamps[i] = i;
+    for (int i = numJobs - 1; i > 0; i--) {
+        int j = nextRandom(&state) % (i + 1);
+        int temp = timestamps[i];
+        timestamps[i] = timestamps[j];
+        timestamps[j] = temp;
+    }
+    
+    printf("\n%d jobs\n", numJobs);
+    printf("%-8s %8s %7s %12s %12s %10s\n", "Mode", "Threads", "Heaps", "Mops/s", "Mean rank", "Max rank");
+    for (int m = 0; m < 2; m++) {
+        for (int numThreads = 1; numThreads <= MAX_THREADS; numThreads *= 2) {
+            MultiQueue queue;
+            MultiQueueContext ctx;
+            bool failed = false;
+            
+            // Throughput: numJobs queued, every thread pops and pushes back
+            if (!initMultiQueue(&queue, numThreads, modes[m])) break;
+            for (int i = 0; i < numJobs && !failed; i++) {
+                Job job = {timestamps[i], i};
+                failed = !pushMultiQueue(&queue, job, &state);
+            }
+            ctx.queue = &queue;
+            ctx.drain = false;
+            ctx.opsPerThread = numJobs / numThreads;
+            double elapsed = runMultiQueueWorkers(&ctx, numThreads, &failed);
+            double mops = 2.0 * ctx.opsPerThread * numThreads / elapsed / 1e6;
+            int numHeaps = queue.numHeaps;
+            freeMultiQueue(&queue);
+            
+            // Rank error: the same jobs queued again, all threads drain
+            if (!initMultiQueue(&queue, numThreads, modes[m])) break;
+            for (int i = 0; i < numJobs && !failed; i++) {
+                Job job = {timestamps[i], i};
+                failed = !pushMultiQueue(&queue, job, &state);
+            }
+            queue.popLog = order;
+            ctx.drain = true;
+            runMultiQueueWorkers(&ctx, numThreads, &failed);
+            int popped = queue.popLogSize;
+            freeMultiQueue(&queue);
+            
+            double meanRank;
+            long long maxRank;
+            if (popped != numJobs || !multiQueueRankError(order, numJobs, &meanRank, &maxRank)) {
+                failed = true;
+            }
+            if (failed) {
+                printf("%-8s %8d %7d  FAILED\n", modeNames[modes[m]], numThreads, numHeaps);
+                continue;
+            }
+            printf("%-8s %8d %7d %12.2f %12.2f %10lld\n", modeNames[modes[m]], numThreads,
+                   numHeaps, mops, meanRank, maxRank);
+        }
+    }
+    printf("Rank: earlier jobs still queued when a job was popped (0 = exact order)\n");
+    
+    free(timestamps);
+    free(order);
 }
 
-void visualizeMaxHeap(MaxHeap *heap) {
-    printf("\nMax Heap Tree Structure:\n");
-    printHeapTree(heap->arr, heap->size, 0, 0);
+void printStreamingRow(const char *method, double seconds, int n, const char *memory, bool ok) {
+    printf("%-34s %10.2f %12.1f %14s  %s\n", method, 1e3 * seconds, n / seconds / 1e6, memory,
+           ok ? "OK" : "FAILED");
 }
 
+// Top-k of n random ints four ways: the streaming operator block by block
+// and value by value, in-place quickselect, and every value in a MaxHeap
+// followed by k extractions. Then a running median of the same values,
+// checked against quickselect at a few prefix lengths.
+void benchmarkStreaming(int n, int k) {
+    unsigned long long state = 88172645463325252ULL;
+    int *values = (int*)malloc((size_t)n * sizeof(int));
+    int *work = (int*)malloc((size_t)n * sizeof(int));
+    int *expected = (int*)malloc((size_t)k * sizeof(int));
+    int *got = (int*)malloc((size_t)k * sizeof(int));
+    char memory[32];
+    TopK topK;
+    MaxHeap all;
+    
+    initMaxHeap(&all);
+    if (values == NULL || work == NULL || expected == NULL || got == NULL || !initTopK(&topK, k)) {
+        printf("Memory allocation failed!\n");
+        free(values);
+        free(work);
+        free(expected);
+        free(got);
+        return;
+    }
+    for (int i = 0; i < n; i++) {
+        values[i] = (int)nextRandom(&state);
+    }
+    
+    printf("\nTop %d of %d random ints\n", k, n);
+    printf("%-34s %10s %12s %14s\n", "Method", "Time ms", "M values/s", "Extra memory");
+    snprintf(memory, sizeof(memory), "%d values", k);
+    
+    // Reference: insert everything, extract k
+    double start = getTimeSeconds();
+    bool ok = reserveMaxHeap(&all, 16);
+    for (int i = 0; i < n && ok; i++) ok = insertMaxHeap(&all, values[i]);
+    for (int i = 0; i < k && ok; i++) extractMaxHeap(&all, &expected[i]);
+    double elapsed = getTimeSeconds() - start;
+    freeMaxHeap(&all);
+    if (!ok) {
+        freeTopK(&topK);
+        free(values);
+        free(work);
+        free(expected);
+        free(got);
+        return;
+    }
+    char allMemory[32];
+    snprintf(allMemory, sizeof(allMemory), "%d values", n);
+    printStreamingRow("MaxHeap of everything, extract k", elapsed, n, allMemory, true);
+    
+    start = getTimeSeconds();
+    for (int i = 0; i < n; i++) addTopK(&topK, values[i]);
+    elapsed = getTimeSeconds() - start;
+    int count = sortedTopK(&topK, got);
+    ok = count == k && memcmp(expected, got, (size_t)k * sizeof(int)) == 0;
+    printStreamingRow("Top-k heap, addTopK per value", elapsed, n, memory, ok);
+    freeTopK(&topK);
+    
+    initTopK(&topK, k);
+    start = getTimeSeconds();
+    addManyTopK(&topK, values, n);
+    elapsed = getTimeSeconds() - start;
+    count = sortedTopK(&topK, got);
+    int kth;
+    ok = count == k && memcmp(expected, got, (size_t)k * sizeof(int)) == 0 &&
+         kthLargestTopK(&topK, &kth) && kth == expected[k - 1] && topK.seen == n;
+    printStreamingRow("Top-k heap, addManyTopK blocks", elapsed, n, memory, ok);
+    freeTopK(&topK);
+    
+    memcpy(work, values, (size_t)n * sizeof(int));
+    start = getTimeSeconds();
+    kth = kthLargest(work, n, k);
+    elapsed = getTimeSeconds() - start;
+    MaxHeap selected;
+    initMaxHeap(&selected);
+    ok = kth == expected[k - 1] && buildMaxHeap(&selected, work, k) &&
+         extractManyMaxHeap(&selected, got, k) == k &&
+         memcmp(expected, got, (size_t)k * sizeof(int)) == 0;
+    freeMaxHeap(&selected);
+    printStreamingRow("Quickselect in place (batch)", elapsed, n, "none", ok);
+    
+    // Running median, with the medians at a few prefix lengths kept for the check
+    int checkpoints[] = {1, 2, 3, 1000, 1001, n / 2, n};
+    double medians[7];
+    RunningMedian median;
+    initRunningMedian(&median);
+    start = getTimeSeconds();
+    ok = true;
+    for (int i = 0; i < n && ok; i++) {
+        ok = addRunningMedian(&median, values[i]);
+        for (int c = 0; c < 7; c++) {
+            if (checkpoints[c] == i + 1) getRunningMedian(&median, &medians[c]);
+        }
+    }
+    elapsed = getTimeSeconds() - start;
+    freeRunningMedian(&median);
+    
+    for (int c = 0; c < 7 && ok; c++) {
+        int m = checkpoints[c];
+        if (m < 1 || m > n) continue;
+        memcpy(work, values, (size_t)m * sizeof(int));
+        double expectedMedian = kthLargest(work, m, (m + 1) / 2);
+        if (m % 2 == 0) {
+            memcpy(work, values, (size_t)m * sizeof(int));
+            expectedMedian = (expectedMedian + kthLargest(work, m, m / 2 + 1)) / 2.0;
+        }
+        if (medians[c] != expectedMedian) ok = false;
+    }
+    snprintf(allMemory, sizeof(allMemory), "%d values", n);
+    printStreamingRow("Running median (two heaps)", elapsed, n, allMemory, ok);
+    
+    free(values);
+    free(work);
+    free(expected);
+    free(got);
+}
 
 int main() {
     printf("=== Min Heap and Max Heap Implementation ===\n\n");
@@ -298,6 +1961,8 @@ int main() {
     // Interactive mode
     printf("\n--- Interactive Mode ---\n");
     int choice, value;
+    IndexedMinHeap indexedHeap;
+    initIndexedMinHeap(&indexedHeap);
     
     while (1) {
         printf("\n1. Insert into Min Heap\n");
@@ -308,7 +1973,20 @@ int main() {
         printf("6. Display Max Heap\n");
         printf("7. Build new Min Heap from array\n");
         printf("8. Build new Max Heap from array\n");
-        printf("9. Exit\n");
+        printf("9. Benchmark job queue (timestamped jobs)\n");
+        printf("10. Benchmark sift variants (swap, hole, bottom-up)\n");
+        printf("11. Benchmark d-ary heaps (binary, 4-ary, 8-ary, 8-ary SIMD)\n");
+        printf("12. Set job priority in indexed heap (insert or change)\n");
+        printf("13. Remove job from indexed heap\n");
+        printf("14. Extract from indexed heap\n");
+        printf("15. Self-check and benchmark indexed heap\n");
+        printf("16. Insert batch into Min Heap\n");
+        printf("17. Extract k smallest from Min Heap\n");
+        printf("18. Benchmark batch insert, top-k and meld\n");
+        printf("19. Benchmark concurrent job queue (MultiQueue)\n");
+        printf("20. Stream values (running median and top-k)\n");
+        printf("21. Benchmark streaming top-k and running median\n");
+        printf("22. Exit\n");
         printf("Enter choice: ");
         
         if (scanf("%d", &choice) != 1) {
@@ -362,8 +2040,8 @@ int main() {
                 printf("Enter number of elements: ");
                 int count;
                 scanf("%d", &count);
-                if (count > MAX_SIZE) {
-                    printf("Too many elements!\n");
+                if (count < 1) {
+                    printf("Invalid number of elements!\n");
                     break;
                 }
                 int *newData = (int*)malloc(count * sizeof(int));
@@ -371,7 +2049,6 @@ int main() {
                 for (int i = 0; i < count; i++) {
                     scanf("%d", &newData[i]);
                 }
-                initMinHeap(&minHeap);
                 buildMinHeap(&minHeap, newData, count);
                 displayMinHeap(&minHeap);
                 free(newData);
@@ -382,8 +2059,8 @@ int main() {
                 printf("Enter number of elements: ");
                 int count;
                 scanf("%d", &count);
-                if (count > MAX_SIZE) {
-                    printf("Too many elements!\n");
+                if (count < 1) {
+                    printf("Invalid number of elements!\n");
                     break;
                 }
                 int *newData = (int*)malloc(count * sizeof(int));
@@ -391,7 +2068,6 @@ int main() {
                 for (int i = 0; i < count; i++) {
                     scanf("%d", &newData[i]);
                 }
-                initMaxHeap(&maxHeap);
                 buildMaxHeap(&maxHeap, newData, count);
                 displayMaxHeap(&maxHeap);
                 free(newData);
@@ -399,6 +2075,195 @@ int main() {
             }
                 
             case 9:
+                printf("Enter number of jobs (e.g. 1000000): ");
+                scanf("%d", &value);
+                if (value < 1) {
+                    printf("Invalid number of jobs!\n");
+                } else {
+                    benchmarkJobQueue(value);
+                }
+                break;
+                
+            case 10:
+                printf("Enter largest heap size (e.g. 10000000): ");
+                scanf("%d", &value);
+                if (value < 1000) {
+                    printf("Heap size must be at least 1000!\n");
+                } else {
+                    benchmarkSiftVariants(value);
+                }
+                break;
+                
+            case 11:
+                printf("Enter largest heap size (e.g. 10000000): ");
+                scanf("%d", &value);
+                if (value < 1000) {
+                    printf("Heap size must be at least 1000!\n");
+                } else {
+                    benchmarkHeapArity(value);
+                }
+                break;
+                
+            case 12: {
+                int job;
+                printf("Enter job id and priority: ");
+                scanf("%d %d", &job, &value);
+                if (job < 0) {
+                    printf("Invalid job id!\n");
+                    break;
+                }
+                if (containsIndexedMinHeap(&indexedHeap, job)) {
+                    printf("Job %d: priority %d -> %d\n", job,
+                           keyOfIndexedMinHeap(&indexedHeap, job), value);
+                    changeKeyIndexedMinHeap(&indexedHeap, job, value);
+                } else {
+                    pushIndexedMinHeap(&indexedHeap, job, value);
+                }
+                displayIndexedMinHeap(&indexedHeap);
+                break;
+            }
+                
+            case 13: {
+                int job;
+                printf("Enter job id: ");
+                scanf("%d", &job);
+                if (removeIndexedMinHeap(&indexedHeap, job)) {
+                    displayIndexedMinHeap(&indexedHeap);
+                } else {
+                    printf("Job %d is not in the heap!\n", job);
+                }
+                break;
+            }
+                
+            case 14: {
+                int job;
+                if (extractIndexedMinHeap(&indexedHeap, &job, &value)) {
+                    printf("Extracted job %d (priority %d)\n", job, value);
+                    displayIndexedMinHeap(&indexedHeap);
+                } else {
+                    printf("Heap is empty!\n");
+                }
+                break;
+            }
+                
+            case 15:
+                testIndexedHeap(1000000, 1000000);
+                break;
+                
+            case 16: {
+                printf("Enter number of elements: ");
+                int count;
+                scanf("%d", &count);
+                if (count < 1) {
+                    printf("Invalid number of elements!\n");
+                    break;
+                }
+                int *newData = (int*)malloc(count * sizeof(int));
+                printf("Enter %d elements: ", count);
+                for (int i = 0; i < count; i++) {
+                    scanf("%d", &newData[i]);
+                }
+                insertManyMinHeap(&minHeap, newData, count);
+                displayMinHeap(&minHeap);
+                free(newData);
+                break;
+            }
+                
+            case 17: {
+                printf("Enter k: ");
+                scanf("%d", &value);
+                if (value < 1) {
+                    printf("Invalid k!\n");
+                    break;
+                }
+                // Only the elements present can be extracted
+                if (value > minHeap.size) value = minHeap.size;
+                int *smallest = (int*)malloc((value > 0 ? value : 1) * sizeof(int));
+                if (smallest == NULL) {
+                    printf("Memory allocation failed!\n");
+                    break;
+                }
+                int count = extractManyMinHeap(&minHeap, smallest, value);
+                printf("Extracted %d smallest: [", count);
+                for (int i = 0; i < count; i++) {
+                    printf("%d%s", smallest[i], i < count - 1 ? ", " : "");
+                }
+                printf("]\n");
+                displayMinHeap(&minHeap);
+                free(smallest);
+                break;
+            }
+                
+            case 18:
+                printf("Enter heap size (e.g. 1000000): ");
+                scanf("%d", &value);
+                if (value < 100) {
+                    printf("Invalid heap size!\n");
+                } else {
+                    benchmarkBatchOperations(value);
+                }
+                break;
+                
+            case 19:
+                printf("Enter number of jobs (e.g. 1000000): ");
+                scanf("%d", &value);
+                if (value < 1) {
+                    printf("Invalid number of jobs!\n");
+                } else {
+                    benchmarkMultiQueue(value);
+                }
+                break;
+                
+            case 20: {
+                int k, count;
+                printf("Enter k and number of values: ");
+                scanf("%d %d", &k, &count);
+                if (k < 1 || count < 1) {
+                    printf("Invalid input!\n");
+                    break;
+                }
+                TopK topK;
+                RunningMedian median;
+                if (!initTopK(&topK, k)) break;
+                initRunningMedian(&median);
+                printf("Enter %d values: ", count);
+                for (int i = 0; i < count; i++) {
+                    double current;
+                    scanf("%d", &value);
+                    addTopK(&topK, value);
+                    addRunningMedian(&median, value);
+                    getRunningMedian(&median, &current);
+                    printf("After %d: median %.1f\n", i + 1, current);
+                }
+                int *largest = (int*)malloc(k * sizeof(int));
+                int found = sortedTopK(&topK, largest);
+                printf("Top %d: [", found);
+                for (int i = 0; i < found; i++) {
+                    printf("%d%s", largest[i], i < found - 1 ? ", " : "");
+                }
+                printf("]\n");
+                free(largest);
+                freeTopK(&topK);
+                freeRunningMedian(&median);
+                break;
+            }
+                
+            case 21: {
+                int k;
+                printf("Enter number of values and k (e.g. 100000000 100): ");
+                scanf("%d %d", &value, &k);
+                if (value < 1 || k < 1 || k > value) {
+                    printf("Invalid input!\n");
+                } else {
+                    benchmarkStreaming(value, k);
+                }
+                break;
+            }
+                
+            case 22:
+                freeIndexedMinHeap(&indexedHeap);
+                freeMinHeap(&minHeap);
+                freeMaxHeap(&maxHeap);
                 printf("Exiting...\n");
                 return 0;
                 
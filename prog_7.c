@@ -2,155 +2,4364 @@
 #include <stdlib.h>
 #include <limits.h>
 #include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
 
 #define MAX_VERTICES 20
-#define INF INT_MAX
+
+// Unreachable distance of the CSR graph algorithms, whose distances are long
+// long: a path of int weights over int vertices cannot overflow them
+#define INF LLONG_MAX
+
+// Weight and distance types of the adjacency matrix Dijkstra, selected with
+// -DDIJKSTRA_WEIGHT_TYPE=n:
+//   1  int weights, int distances (compact; sums saturate at INT_MAX)
+//   2  int weights, long long distances (default; no path can overflow)
+//   3  float weights, double distances
+// The *_PRI and *_SCN strings are the printf/scanf conversions of each type.
+#ifndef DIJKSTRA_WEIGHT_TYPE
+#define DIJKSTRA_WEIGHT_TYPE 2
+#endif
+
+#if DIJKSTRA_WEIGHT_TYPE == 1
+typedef int Weight;
+typedef int Distance;
+#define DISTANCE_INF INT_MAX
+#define WEIGHT_PRI "d"
+#define WEIGHT_SCN "d"
+#define DISTANCE_PRI "d"
+#elif DIJKSTRA_WEIGHT_TYPE == 2
+typedef int Weight;
+typedef long long Distance;
+#define DISTANCE_INF LLONG_MAX
+#define WEIGHT_PRI "d"
+#define WEIGHT_SCN "d"
+#define DISTANCE_PRI "lld"
+#elif DIJKSTRA_WEIGHT_TYPE == 3
+typedef float Weight;
+typedef double Distance;
+#define DISTANCE_INF HUGE_VAL
+#define WEIGHT_PRI "g"
+#define WEIGHT_SCN "f"
+#define DISTANCE_PRI "g"
+#else
+#error "DIJKSTRA_WEIGHT_TYPE must be 1, 2 or 3"
+#endif
+
+// Binary graph file format (shared with prog_5)
+#define GRAPH_FILE_MAGIC "DSAGRAPH"
+#define GRAPH_FILE_VERSION 1
+#define GRAPH_FLAG_WEIGHTED 1
+
+// Vertex order file written by prog_5 next to a reordered graph
+#define ORDER_FILE_MAGIC "DSAORDER"
+#define ORDER_FILE_VERSION 1
+
+// Largest graph the O(V²) baseline is run on in benchmarks
+#define LINEAR_SCAN_LIMIT 20000
+
+// Integer priority queues: radix heap buckets for 64-bit keys, and the
+// largest maximum edge weight Dial's algorithm allocates buckets for
+#define RADIX_BUCKETS 65
+#define DIAL_MAX_WEIGHT (1 << 20)
+
+// Upper limit on worker threads
+#define MAX_THREADS 64
+
+// Block size of the blocked Floyd-Warshall (three 128 x 128 int tiles, 192 KB, fit in L2)
+#define FW_BLOCK 128
+
+// Row piece of the Floyd-Warshall inner loop (16 ints: one cache line, two AVX2 or four SSE2 vectors)
+#define FW_RELAX_WIDTH 16
+
+// Contraction hierarchy index file
+#define CH_FILE_MAGIC "DSACHIDX"
+#define CH_FILE_VERSION 3
+
+// Vertices a witness search may settle before giving up (a shortcut is then
+// added, which is always correct, only possibly unnecessary)
+#define CH_WITNESS_SETTLE_LIMIT 500
+
+// Per-step tracing of Dijkstra, compiled out unless built with -DDIJKSTRA_TRACE=1
+#ifndef DIJKSTRA_TRACE
+#define DIJKSTRA_TRACE 0
+#endif
 
 typedef struct {
     int numVertices;
-    int adjMatrix[MAX_VERTICES][MAX_VERTICES];
+    Weight adjMatrix[MAX_VERTICES][MAX_VERTICES];
 } Graph;
 
+// Counters recorded by every Dijkstra variant
+typedef struct {
+    long long pushes;               // entries inserted into the priority queue
+    long long pops;                 // entries removed, including stale ones
+    long long decreaseKeys;         // in-place key updates (indexed heap only)
+    long long relaxations;          // edges examined
+    long long successfulRelaxations; // relaxations that lowered a distance
+    long long settled;              // vertices whose distance became final
+    double wallTime;                // seconds spent in the algorithm
+} DijkstraStats;
+
 typedef struct {
-    int distance[MAX_VERTICES];
+    Distance distance[MAX_VERTICES];    // DISTANCE_INF if unreachable
     int parent[MAX_VERTICES];
     bool visited[MAX_VERTICES];
+    DijkstraStats stats;
 } DijkstraResult;
 
-void initGraph(Graph *g, int vertices) {
-    g->numVertices = vertices;
+// Compressed sparse row graph
+typedef struct {
+    int numVertices;
+    long long numEdges;     // directed arcs, each undirected edge is stored twice
+    long long *offsets;     // neighbors of v are neighbors[offsets[v] .. offsets[v+1]-1]
+    int *neighbors;
+    int *weights;           // parallel to neighbors
+    void *mapping;          // start of mmap'ed file, NULL when arrays are malloc'ed
+    size_t mappingSize;
+    int *unitWeights;       // malloc'ed weights of 1 for a mapped unweighted file
+} CSRGraph;
+
+// On-disk graph file header, followed by
+//   long long offsets[numVertices + 1]
+//   int neighbors[numEdges]
+//   int weights[numEdges]     (only if GRAPH_FLAG_WEIGHTED)
+// Values are in host (little-endian) byte order.
+typedef struct {
+    char magic[8];          // GRAPH_FILE_MAGIC
+    unsigned int version;   // GRAPH_FILE_VERSION
+    unsigned int flags;
+    long long numVertices;
+    long long numEdges;     // directed arcs
+} GraphFileHeader;
+
+// Order file header, followed by int order[numVertices] (order[new id] =
+// original id)
+typedef struct {
+    char magic[8];          // ORDER_FILE_MAGIC
+    unsigned int version;   // ORDER_FILE_VERSION
+    int numVertices;
+} OrderFileHeader;
+
+// Shortest path tree for graphs of any size
+typedef struct {
+    int numVertices;
+    long long *distance;    // INF if unreachable
+    int *parent;            // -1 for the source and unreachable vertices
+    DijkstraStats stats;
+} ShortestPathResult;
+
+// Indexed d-ary min heap of vertices supporting decrease-key
+typedef struct {
+    int *vertex;            // heap slots
+    long long *key;         // key of each slot
+    int *position;          // slot of each vertex, -1 if not in the heap
+    int size;
+    int arity;
+} IndexedHeap;
+
+// Entry of the lazy-deletion heap
+typedef struct {
+    long long key;
+    int vertex;
+} HeapEntry;
+
+typedef struct {
+    HeapEntry *entries;
+    long long size;
+    long long capacity;
+} LazyHeap;
+
+// Growable list of queue entries
+typedef struct {
+    HeapEntry *entries;
+    int size;
+    int capacity;
+} Bucket;
+
+// Monotone radix heap for non-negative integer keys
+typedef struct {
+    Bucket buckets[RADIX_BUCKETS];
+    unsigned long long last; // last popped key
+    long long size;
+} RadixHeap;
+
+// Dial's circular bucket queue
+typedef struct {
+    Bucket *buckets;
+    int numBuckets;         // maximum edge weight + 1
+    long long current;      // key of the bucket being emptied
+    long long size;
+} DialQueue;
+
+// Reusable workspace for single source-target queries
+// Side 0 searches forward from the source, side 1 backward from the target.
+// Only entries recorded in touched[] are reset before the next query, so a
+// query costs time proportional to the vertices it reaches, not to V.
+typedef struct {
+    int numVertices;
+    long long *distance[2]; // INF if not reached from that side
+    int *parent[2];         // forward: previous vertex, backward: next vertex
+    int *touched[2];        // vertices whose distance was set, per side
+    int numTouched[2];
+    IndexedHeap heap[2];
+    int source;
+    int target;
+    int meeting;            // vertex where the best path joins both sides, -1 if none
+    long long pathDistance; // INF if the target is unreachable
+    DijkstraStats stats;
+} PathQuery;
+
+// Admissible lower bound on the distance from vertex to target used by A*
+typedef struct Heuristic Heuristic;
+typedef long long (*HeuristicFn)(const Heuristic *heuristic, int vertex, int target);
+
+struct Heuristic {
+    HeuristicFn estimate;
+    const char *name;
+    const double *x;            // vertex coordinates (geometric heuristics)
+    const double *y;
+    double scale;               // weight per unit of coordinate distance, never overestimating
+    int numVertices;
+    int numLandmarks;
+    int *landmarks;
+    long long *landmarkDistance; // distance from landmark i to v at [i * numVertices + v]
+};
+
+// Arc of the graph being contracted; middle is the vertex a shortcut bypasses, -1 otherwise
+typedef struct {
+    int vertex;
+    int middle;
+    long long weight;       // shortcuts add up weights, so they may exceed int
+} CHArc;
+
+typedef struct {
+    CHArc *arcs;
+    int size;
+    int capacity;
+} CHArcList;
+
+// Working state of the contraction
+typedef struct {
+    int numVertices;
+    CHArcList *adjacency;   // a contracted vertex keeps its list, its neighbors drop their arc to it
+    bool *contracted;
+    int *deletedNeighbors;  // contracted neighbors, part of the priority
+    long long *distance;    // witness search, INF when untouched
+    int *touched;
+    int numTouched;
+    IndexedHeap heap;
+} CHBuilder;
+
+// Contraction hierarchy
+// Every vertex keeps only its arcs (original edges and shortcuts) to vertices
+// contracted after it. The graph is undirected, so both directions of a
+// query search these upward arcs.
+typedef struct {
+    int numVertices;
+    long long numArcs;
+    long long numShortcuts;
+    long long graphArcs;    // arcs and csrGraphChecksum() of the graph it was built from
+    unsigned long long graphChecksum;
+    long long *offsets;     // upward arcs of v are [offsets[v], offsets[v+1])
+    long long *weight;
+    int *rank;              // position of each vertex in the contraction order
+    int *target;
+    int *middle;            // bypassed vertex of a shortcut, -1 for original edges
+    void *mapping;          // start of mmap'ed index file, NULL when arrays are malloc'ed
+    size_t mappingSize;
+} ContractionHierarchy;
+
+// Index file header, followed by
+//   long long offsets[numVertices + 1]
+//   long long weight[numArcs]
+//   int rank[numVertices]
+//   int target[numArcs], middle[numArcs]
+// The 64-bit arrays come first so they stay aligned in the mapping.
+typedef struct {
+    char magic[8];          // CH_FILE_MAGIC
+    unsigned int version;   // CH_FILE_VERSION
+    unsigned int reserved;
+    long long numVertices;
+    long long numArcs;
+    long long numShortcuts;
+    long long graphArcs;    // fingerprint of the graph, checked on load
+    unsigned long long graphChecksum;
+} CHFileHeader;
+
+// Shared state of a many-to-many run; sources are claimed one at a time
+typedef struct {
+    CSRGraph *csr;
+    const int *sources;
+    int numSources;
+    const int *targets;
+    int numTargets;
+    const bool *isTarget;   // vertex is one of the targets
+    int numDistinctTargets;
+    long long *matrix;      // numSources x numTargets, row-major
+    int nextSource;         // next source index, claimed with __atomic_fetch_add
+} ManyToManyContext;
+
+typedef struct {
+    ManyToManyContext *context;
+    PathQuery query;        // reused for every source this thread claims
+    long long settled;
+} ManyToManyWorker;
+
+// Shared state of parallel delta-stepping
+typedef struct {
+    CSRGraph *csr;
+    long long *distance;            // lowered with compare-and-swap
+    int *lastBucket;                // bucket in which a vertex was last removed
+    int delta;
+    int numThreads;                 // threads actually started
+    bool started;                   // start gate, set once numThreads and barrier are final
+    HeapEntry *frontier;            // (distance when queued, vertex) of the current bucket
+    long long frontierSize;
+    long long frontierCapacity;
+    long long binCount[MAX_THREADS]; // entries each thread holds for the bucket being gathered
+    int binMin[MAX_THREADS];        // lowest non-empty bucket of each thread
+    bool failed;
+    pthread_barrier_t barrier;
+} DeltaSteppingContext;
+
+typedef struct {
+    DeltaSteppingContext *ctx;
+    int id;
+    Bucket *bins;                   // thread-local buckets, bins[b] holds distances in [b*delta, (b+1)*delta)
+    int numBins;
+    int *removed;                   // vertices removed from the current bucket, for heavy edges
+    int numRemoved;
+    int removedCapacity;
+    DijkstraStats stats;
+} DeltaSteppingWorker;
+
+// Shortest paths from one source, repaired after every edge change
+typedef struct {
+    Graph *graph;
+    int source;
+    DijkstraResult result;
+    bool queued[MAX_VERTICES]; // repair queue
+    int affected;           // vertices whose distance changed in the last update
+} DynamicSSSP;
+
+// Priority queue used by dijkstraSparse()
+typedef enum {
+    QUEUE_BINARY_HEAP,
+    QUEUE_FOUR_ARY_HEAP,
+    QUEUE_LAZY_HEAP,
+    QUEUE_RADIX_HEAP,
+    QUEUE_DIAL
+} QueueType;
+
+void freeShortestPathResult(ShortestPathResult *result);
+void freeIndexedHeap(IndexedHeap *heap);
+void freePathQuery(PathQuery *query);
+void freeHeuristic(Heuristic *heuristic);
+void freeCHBuilder(CHBuilder *builder);
+void freeContractionHierarchy(ContractionHierarchy *ch);
+double getTimeSeconds();
+void displayDijkstraStats(DijkstraStats *stats);
+
+#if DIJKSTRA_TRACE
+typedef enum {
+    TRACE_EVENT_SETTLE,     // vertex removed from the queue with its final distance
+    TRACE_EVENT_RELAX       // distance of vertex lowered via another vertex
+} TraceEvent;
+
+typedef void (*DijkstraTraceFn)(TraceEvent event, long long step, int vertex,
+                                double distance, int via);
+
+// Default hook, prints the same lines the algorithm used to print itself
+void printDijkstraTrace(TraceEvent event, long long step, int vertex, double distance, int via) {
+    if (event == TRACE_EVENT_SETTLE) {
+        printf("Step %lld: Visiting vertex %d (distance: %.15g)\n", step, vertex,
+               distance >= INF ? -1 : distance);
+    } else {
+        printf("  -> Updated distance to vertex %d: %.15g (via %d)\n", vertex, distance, via);
+    }
+}
+
+DijkstraTraceFn dijkstraTraceHook = printDijkstraTrace;
+
+#define TRACE_SETTLE(step, vertex, distance) \
+    do { if (dijkstraTraceHook != NULL) \
+        dijkstraTraceHook(TRACE_EVENT_SETTLE, (step), (vertex), (distance), -1); } while (0)
+#define TRACE_RELAX(vertex, distance, via) \
+    do { if (dijkstraTraceHook != NULL) \
+        dijkstraTraceHook(TRACE_EVENT_RELAX, 0, (vertex), (distance), (via)); } while (0)
+#else
+#define TRACE_SETTLE(step, vertex, distance) ((void)0)
+#define TRACE_RELAX(vertex, distance, via) ((void)0)
+#endif
+
+void initGraph(Graph *g, int vertices) {
+    g->numVertices = vertices;
+    
+    for (int i = 0; i < vertices; i++) {
+        for (int j = 0; j < vertices; j++) {
+            g->adjMatrix[i][j] = 0;
+        }
+    }
+}
+
+void addEdge(Graph *g, int src, int dest, Weight weight) {
+    if (src >= g->numVertices || dest >= g->numVertices || src < 0 || dest < 0) {
+        printf("Invalid vertices!\n");
+        return;
+    }
+    
+    if (weight < 0) {
+        printf("Dijkstra's algorithm doesn't work with negative weights!\n");
+        return;
+    }
+    
+    g->adjMatrix[src][dest] = weight;
+    g->adjMatrix[dest][src] = weight; // For undirected graph
+}
+
+void displayGraph(Graph *g) {
+    printf("\nAdjacency Matrix (Weighted):\n");
+    printf("     ");
+    for (int i = 0; i < g->numVertices; i++) {
+        printf("%3d ", i);
+    }
+    printf("\n");
+    
+    for (int i = 0; i < g->numVertices; i++) {
+        printf("%3d  ", i);
+        for (int j = 0; j < g->numVertices; j++) {
+            if (g->adjMatrix[i][j] == 0 && i != j) {
+                printf("  - ");
+            } else {
+                printf("%3" WEIGHT_PRI " ", g->adjMatrix[i][j]);
+            }
+        }
+        printf("\n");
+    }
+}
+
+// distance + weight that cannot overflow: DISTANCE_INF stays infinite and a
+// sum too large for Distance becomes DISTANCE_INF instead of wrapping around
+Distance addDistance(Distance distance, Weight weight) {
+#if DIJKSTRA_WEIGHT_TYPE == 3
+    return distance + weight;
+#else
+    if (distance == DISTANCE_INF || weight > DISTANCE_INF - distance) return DISTANCE_INF;
+    return distance + weight;
+#endif
+}
+
+int findMinDistance(DijkstraResult *result, int numVertices) {
+    Distance min = DISTANCE_INF;
+    int minIndex = -1;
+    
+    for (int v = 0; v < numVertices; v++) {
+        if (!result->visited[v] && result->distance[v] < min) {
+            min = result->distance[v];
+            minIndex = v;
+        }
+    }
+    
+    return minIndex;
+}
+
+void dijkstra(Graph *g, int source, DijkstraResult *result) {
+    if (source >= g->numVertices || source < 0) {
+        printf("Invalid source vertex!\n");
+        return;
+    }
+    
+    for (int i = 0; i < g->numVertices; i++) {
+        result->distance[i] = DISTANCE_INF;
+        result->parent[i] = -1;
+        result->visited[i] = false;
+    }
+    
+    double start = getTimeSeconds();
+    DijkstraStats stats = {0};
+    result->distance[source] = 0;
+    
+    for (int count = 0; count < g->numVertices - 1; count++) {
+        int u = findMinDistance(result, g->numVertices);
+        
+        if (u == -1) break; // No more reachable vertices
+        
+        result->visited[u] = true;
+        stats.pops++;
+        stats.settled++;
+        TRACE_SETTLE(count + 1, u, result->distance[u]);
+        
+        // Update distance values of adjacent vertices
+        for (int v = 0; v < g->numVertices; v++) {
+            // Update distance[v] if:
+            // - v is not visited
+            // - there is an edge from u to v
+            // - total weight from source to v through u is less than current distance[v]
+            if (result->visited[v] || g->adjMatrix[u][v] == 0) continue;
+            stats.relaxations++;
+            Distance candidate = addDistance(result->distance[u], g->adjMatrix[u][v]);
+            if (candidate < result->distance[v]) {
+                
+                result->distance[v] = candidate;
+                result->parent[v] = u;
+                stats.successfulRelaxations++;
+                TRACE_RELAX(v, result->distance[v], u);
+            }
+        }
+    }
+    
+    stats.wallTime = getTimeSeconds() - start;
+    result->stats = stats;
+}
+
+// Write the path ending at dest into path[] in source-to-dest order by
+// following parent links; returns its length. No recursion, so paths of any
+// length work; path must have room for the number of vertices.
+int reconstructPath(const int *parent, int dest, int *path) {
+    int length = 0;
+    for (int v = dest; v != -1; v = parent[v]) {
+        length++;
+    }
+    
+    int i = length;
+    for (int v = dest; v != -1; v = parent[v]) {
+        path[--i] = v;
+    }
+    return length;
+}
+
+void printPathArray(const int *path, int length) {
+    for (int i = 0; i < length; i++) {
+        printf(i == 0 ? "%d" : " -> %d", path[i]);
+    }
+}
+
+// Print path from source to destination
+void printPath(DijkstraResult *result, int dest) {
+    int path[MAX_VERTICES];
+    printPathArray(path, reconstructPath(result->parent, dest, path));
+}
+
+// Display results
+void displayResults(DijkstraResult *result, int source, int numVertices) {
+    printf("Destination\tDistance\tPath\n");
+    
+    for (int i = 0; i < numVertices; i++) {
+        printf("%d\t\t", i);
+        
+        if (result->distance[i] == DISTANCE_INF) {
+            printf("INF\t\tNo path\n");
+        } else {
+            printf("%" DISTANCE_PRI "\t\t", result->distance[i]);
+            printPath(result, i);
+            printf("\n");
+        }
+    }
+    displayDijkstraStats(&result->stats);
+}
+
+// Binary graph files (same format as prog_5)
+// Loading maps the file and points the CSR arrays into the mapping, so a
+// graph of any size is available without parsing.
+
+void initCSRGraph(CSRGraph *csr) {
+    csr->numVertices = 0;
+    csr->numEdges = 0;
+    csr->offsets = NULL;
+    csr->neighbors = NULL;
+    csr->weights = NULL;
+    csr->mapping = NULL;
+    csr->mappingSize = 0;
+    csr->unitWeights = NULL;
+}
+
+void freeCSRGraph(CSRGraph *csr) {
+    if (csr->mapping != NULL) {
+        munmap(csr->mapping, csr->mappingSize);
+        free(csr->unitWeights);
+    } else {
+        free(csr->offsets);
+        free(csr->neighbors);
+        free(csr->weights);
+    }
+    initCSRGraph(csr);
+}
+
+// Convert adjacency matrix graph to weighted CSR
+bool buildCSRFromGraph(CSRGraph *csr, Graph *g) {
+    initCSRGraph(csr);
+    int n = g->numVertices;
+    long long arcs = 0;
+    
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            if (g->adjMatrix[i][j] != 0) arcs++;
+        }
+    }
+    
+    csr->offsets = (long long*)malloc((n + 1) * sizeof(long long));
+    csr->neighbors = (int*)malloc((arcs > 0 ? arcs : 1) * sizeof(int));
+    csr->weights = (int*)malloc((arcs > 0 ? arcs : 1) * sizeof(int));
+    if (csr->offsets == NULL || csr->neighbors == NULL || csr->weights == NULL) {
+        printf("Memory allocation failed!\n");
+        freeCSRGraph(csr);
+        return false;
+    }
+    
+    long long k = 0;
+    for (int i = 0; i < n; i++) {
+        csr->offsets[i] = k;
+        for (int j = 0; j < n; j++) {
+            if (g->adjMatrix[i][j] != 0) {
+#if DIJKSTRA_WEIGHT_TYPE == 3
+                if (g->adjMatrix[i][j] != (int)g->adjMatrix[i][j]) {
+                    printf("Sparse graphs need integer weights (edge %d -- %d)!\n", i, j);
+                    freeCSRGraph(csr);
+                    return false;
+                }
+#endif
+                csr->neighbors[k] = j;
+                csr->weights[k] = g->adjMatrix[i][j];
+                k++;
+            }
+        }
+    }
+    csr->offsets[n] = k;
+    csr->numVertices = n;
+    csr->numEdges = arcs;
+    return true;
+}
+
+// Copy a small CSR graph into the adjacency matrix
+bool loadGraphFromCSR(Graph *g, CSRGraph *csr) {
+    if (csr->numVertices > MAX_VERTICES) {
+        printf("Graph has %d vertices, adjacency matrix holds at most %d!\n",
+               csr->numVertices, MAX_VERTICES);
+        return false;
+    }
+    
+    initGraph(g, csr->numVertices);
+    for (int u = 0; u < csr->numVertices; u++) {
+        for (long long e = csr->offsets[u]; e < csr->offsets[u + 1]; e++) {
+            g->adjMatrix[u][csr->neighbors[e]] = csr->weights != NULL ? csr->weights[e] : 1;
+        }
+    }
+    return true;
+}
+
+// Graph the sparse menu options run on: the mapped file if one is loaded,
+// otherwise a CSR copy of the adjacency matrix built into scratch (which
+// the caller frees either way). NULL if the copy cannot be built.
+CSRGraph *currentSparseGraph(CSRGraph *loaded, Graph *g, CSRGraph *scratch) {
+    initCSRGraph(scratch);
+    if (loaded->mapping != NULL) return loaded;
+    return buildCSRFromGraph(scratch, g) ? scratch : NULL;
+}
+
+// Write CSR graph to binary file
+bool saveCSRGraphBinary(CSRGraph *csr, const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        printf("Cannot open file %s for writing!\n", path);
+        return false;
+    }
+    
+    GraphFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, GRAPH_FILE_MAGIC, sizeof(header.magic));
+    header.version = GRAPH_FILE_VERSION;
+    header.flags = csr->weights != NULL ? GRAPH_FLAG_WEIGHTED : 0;
+    header.numVertices = csr->numVertices;
+    header.numEdges = csr->numEdges;
+    
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(csr->offsets, sizeof(long long), csr->numVertices + 1, file) ==
+                  (size_t)csr->numVertices + 1 &&
+              fwrite(csr->neighbors, sizeof(int), csr->numEdges, file) == (size_t)csr->numEdges;
+    if (ok && csr->weights != NULL) {
+        ok = fwrite(csr->weights, sizeof(int), csr->numEdges, file) == (size_t)csr->numEdges;
+    }
+    
+    if (fclose(file) != 0) ok = false;
+    if (!ok) {
+        printf("Error writing file %s!\n", path);
+    }
+    return ok;
+}
+
+// Offsets start at 0, never decrease and end at numEdges, every neighbor is
+// a vertex and every weight is non-negative (Dijkstra relies on it). A
+// mapped file is only used after this check, so a corrupt one cannot make
+// the algorithms index outside the arrays.
+bool validCSRGraph(CSRGraph *csr) {
+    int n = csr->numVertices;
+    if (csr->offsets[0] != 0 || csr->offsets[n] != csr->numEdges) return false;
+    for (int v = 0; v < n; v++) {
+        if (csr->offsets[v + 1] < csr->offsets[v]) return false;
+    }
+    for (long long e = 0; e < csr->numEdges; e++) {
+        if (csr->neighbors[e] < 0 || csr->neighbors[e] >= n) return false;
+        if (csr->weights != NULL && csr->weights[e] < 0) return false;
+    }
+    return true;
+}
+
+// Map binary graph file and use its arrays in place (zero copy)
+bool loadCSRGraphBinary(CSRGraph *csr, const char *path) {
+    initCSRGraph(csr);
+    
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Cannot open file %s!\n", path);
+        return false;
+    }
+    
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(GraphFileHeader)) {
+        printf("Invalid graph file %s!\n", path);
+        close(fd);
+        return false;
+    }
+    
+    size_t size = (size_t)info.st_size;
+    void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        printf("Cannot map file %s!\n", path);
+        return false;
+    }
+    
+    GraphFileHeader *header = (GraphFileHeader*)mapping;
+    bool weighted = (header->flags & GRAPH_FLAG_WEIGHTED) != 0;
+    bool valid = memcmp(header->magic, GRAPH_FILE_MAGIC, sizeof(header->magic)) == 0 &&
+                 header->version == GRAPH_FILE_VERSION &&
+                 header->numVertices >= 0 && header->numVertices < INT_MAX &&
+                 header->numEdges >= 0;
+    if (valid) {
+        // Compare the arc count with the bytes left instead of multiplying it
+        // out, which a corrupt count could overflow
+        size_t remaining = size - sizeof(GraphFileHeader);
+        size_t offsetBytes = ((size_t)header->numVertices + 1) * sizeof(long long);
+        size_t arcBytes = sizeof(int) * (weighted ? 2 : 1);
+        valid = offsetBytes <= remaining &&
+                (size_t)header->numEdges <= (remaining - offsetBytes) / arcBytes &&
+                (size_t)header->numEdges * arcBytes == remaining - offsetBytes;
+    }
+    if (valid) {
+        char *base = (char*)mapping + sizeof(GraphFileHeader);
+        csr->numVertices = (int)header->numVertices;
+        csr->numEdges = header->numEdges;
+        csr->offsets = (long long*)base;
+        csr->neighbors = (int*)(base + (header->numVertices + 1) * sizeof(long long));
+        csr->weights = weighted ? csr->neighbors + header->numEdges : NULL;
+        valid = validCSRGraph(csr);
+    }
+    if (!valid) {
+        printf("Invalid or unsupported graph file %s!\n", path);
+        munmap(mapping, size);
+        initCSRGraph(csr);
+        return false;
+    }
+    
+    csr->mapping = mapping;
+    csr->mappingSize = size;
+    
+    // The kernels all read weights[]: an unweighted file (e.g. one written by
+    // Program 5) gets weight 1 on every arc, so distances count hops
+    if (csr->weights == NULL) {
+        csr->unitWeights = (int*)malloc((csr->numEdges > 0 ? csr->numEdges : 1) * sizeof(int));
+        if (csr->unitWeights == NULL) {
+            printf("Memory allocation failed!\n");
+            freeCSRGraph(csr);
+            return false;
+        }
+        for (long long e = 0; e < csr->numEdges; e++) {
+            csr->unitWeights[e] = 1;
+        }
+        csr->weights = csr->unitWeights;
+    }
+    return true;
+}
+
+// Sparse Dijkstra with priority queues
+// The matrix version above picks the next vertex with a linear scan and
+// relaxes a whole matrix row, O(V²) no matter how few edges exist. The
+// versions below run on the CSR graph and take the next vertex from a heap,
+// O((V + E) log V).
+
+// Get current wall clock time in seconds
+double getTimeSeconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Pseudo random generator (xorshift64*) with caller-owned state
+unsigned int nextRandom(unsigned long long *state) {
+    unsigned long long x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return (unsigned int)((x * 2685821657736338717ULL) >> 32);
+}
+
+// Build undirected weighted CSR graph from an edge list
+bool buildCSRFromEdges(CSRGraph *csr, int numVertices, const int src[],
+                       const int dest[], const int weight[], long long numEdges) {
+    initCSRGraph(csr);
+    csr->offsets = (long long*)calloc(numVertices + 1, sizeof(long long));
+    csr->neighbors = (int*)malloc((numEdges > 0 ? 2 * numEdges : 1) * sizeof(int));
+    csr->weights = (int*)malloc((numEdges > 0 ? 2 * numEdges : 1) * sizeof(int));
+    long long *pos = (long long*)malloc((numVertices > 0 ? numVertices : 1) * sizeof(long long));
+    if (csr->offsets == NULL || csr->neighbors == NULL || csr->weights == NULL || pos == NULL) {
+        printf("Memory allocation failed!\n");
+        free(pos);
+        freeCSRGraph(csr);
+        return false;
+    }
+    
+    for (long long e = 0; e < numEdges; e++) {
+        csr->offsets[src[e] + 1]++;
+        csr->offsets[dest[e] + 1]++;
+    }
+    for (int v = 0; v < numVertices; v++) {
+        csr->offsets[v + 1] += csr->offsets[v];
+        pos[v] = csr->offsets[v];
+    }
+    for (long long e = 0; e < numEdges; e++) {
+        csr->weights[pos[src[e]]] = weight[e];
+        csr->neighbors[pos[src[e]]++] = dest[e];
+        csr->weights[pos[dest[e]]] = weight[e];
+        csr->neighbors[pos[dest[e]]++] = src[e];
+    }
+    
+    free(pos);
+    csr->numVertices = numVertices;
+    csr->numEdges = 2 * numEdges;
+    return true;
+}
+
+// Generate a rows x cols grid (road network like) with weights 1..maxWeight
+bool generateGridGraph(CSRGraph *csr, int rows, int cols, int maxWeight,
+                       unsigned long long seed) {
+    int n = rows * cols;
+    long long m = (long long)rows * (cols - 1) + (long long)(rows - 1) * cols;
+    int *src = (int*)malloc((m > 0 ? m : 1) * sizeof(int));
+    int *dest = (int*)malloc((m > 0 ? m : 1) * sizeof(int));
+    int *weight = (int*)malloc((m > 0 ? m : 1) * sizeof(int));
+    unsigned long long state = seed ? seed : 1;
+    
+    if (src == NULL || dest == NULL || weight == NULL) {
+        printf("Memory allocation failed!\n");
+        free(src);
+        free(dest);
+        free(weight);
+        initCSRGraph(csr);
+        return false;
+    }
+    
+    long long k = 0;
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            int v = r * cols + c;
+            if (c + 1 < cols) {
+                src[k] = v;
+                dest[k] = v + 1;
+                weight[k++] = 1 + nextRandom(&state) % maxWeight;
+            }
+            if (r + 1 < rows) {
+                src[k] = v;
+                dest[k] = v + cols;
+                weight[k++] = 1 + nextRandom(&state) % maxWeight;
+            }
+        }
+    }
+    
+    bool ok = buildCSRFromEdges(csr, n, src, dest, weight, m);
+    free(src);
+    free(dest);
+    free(weight);
+    return ok;
+}
+
+// distance + weight for the CSR algorithms, saturating like addDistance():
+// INF stays infinite and a sum past LLONG_MAX becomes INF
+long long addPathLength(long long distance, int weight) {
+    if (distance == INF || weight > INF - distance) return INF;
+    return distance + weight;
+}
+
+bool initShortestPathResult(ShortestPathResult *result, int numVertices) {
+    result->numVertices = numVertices;
+    memset(&result->stats, 0, sizeof(DijkstraStats));
+    result->distance = (long long*)malloc((numVertices > 0 ? numVertices : 1) * sizeof(long long));
+    result->parent = (int*)malloc((numVertices > 0 ? numVertices : 1) * sizeof(int));
+    if (result->distance == NULL || result->parent == NULL) {
+        printf("Memory allocation failed!\n");
+        freeShortestPathResult(result);
+        return false;
+    }
+    return true;
+}
+
+void freeShortestPathResult(ShortestPathResult *result) {
+    free(result->distance);
+    free(result->parent);
+    result->distance = NULL;
+    result->parent = NULL;
+}
+
+void resetShortestPathResult(ShortestPathResult *result) {
+    for (int v = 0; v < result->numVertices; v++) {
+        result->distance[v] = INF;
+        result->parent[v] = -1;
+    }
+    memset(&result->stats, 0, sizeof(DijkstraStats));
+}
+
+// Indexed d-ary min heap
+// position[v] tracks the slot of every vertex in the heap, so a vertex whose
+// distance improves is moved up in place (decrease-key) instead of being
+// inserted again. Sifting moves a hole and writes the entry once at the end.
+
+bool initIndexedHeap(IndexedHeap *heap, int numVertices, int arity) {
+    heap->size = 0;
+    heap->arity = arity < 2 ? 2 : arity;
+    heap->vertex = (int*)malloc((numVertices > 0 ? numVertices : 1) * sizeof(int));
+    heap->key = (long long*)malloc((numVertices > 0 ? numVertices : 1) * sizeof(long long));
+    heap->position = (int*)malloc((numVertices > 0 ? numVertices : 1) * sizeof(int));
+    if (heap->vertex == NULL || heap->key == NULL || heap->position == NULL) {
+        printf("Memory allocation failed!\n");
+        freeIndexedHeap(heap);
+        return false;
+    }
+    for (int v = 0; v < numVertices; v++) {
+        heap->position[v] = -1;
+    }
+    return true;
+}
+
+void freeIndexedHeap(IndexedHeap *heap) {
+    free(heap->vertex);
+    free(heap->key);
+    free(heap->position);
+    heap->vertex = heap->position = NULL;
+    heap->key = NULL;
+    heap->size = 0;
+}
+
+void indexedHeapSiftUp(IndexedHeap *heap, int i) {
+    int v = heap->vertex[i];
+    long long key = heap->key[i];
+    
+    while (i > 0) {
+        int parent = (i - 1) / heap->arity;
+        if (heap->key[parent] <= key) break;
+        heap->vertex[i] = heap->vertex[parent];
+        heap->key[i] = heap->key[parent];
+        heap->position[heap->vertex[i]] = i;
+        i = parent;
+    }
+    heap->vertex[i] = v;
+    heap->key[i] = key;
+    heap->position[v] = i;
+}
+
+void indexedHeapSiftDown(IndexedHeap *heap, int i) {
+    int v = heap->vertex[i];
+    long long key = heap->key[i];
+    
+    while (1) {
+        int first = i * heap->arity + 1;
+        if (first >= heap->size) break;
+        int last = first + heap->arity < heap->size ? first + heap->arity : heap->size;
+        int smallest = first;
+        for (int c = first + 1; c < last; c++) {
+            if (heap->key[c] < heap->key[smallest]) smallest = c;
+        }
+        if (heap->key[smallest] >= key) break;
+        heap->vertex[i] = heap->vertex[smallest];
+        heap->key[i] = heap->key[smallest];
+        heap->position[heap->vertex[i]] = i;
+        i = smallest;
+    }
+    heap->vertex[i] = v;
+    heap->key[i] = key;
+    heap->position[v] = i;
+}
+
+// Insert v, or lower its key if it is already in the heap
+void indexedHeapPushOrDecrease(IndexedHeap *heap, int v, long long key) {
+    int i = heap->position[v];
+    if (i == -1) {
+        i = heap->size++;
+        heap->vertex[i] = v;
+    }
+    heap->key[i] = key;
+    indexedHeapSiftUp(heap, i);
+}
+
+int indexedHeapPopMin(IndexedHeap *heap) {
+    int min = heap->vertex[0];
+    heap->position[min] = -1;
+    heap->size--;
+    if (heap->size > 0) {
+        heap->vertex[0] = heap->vertex[heap->size];
+        heap->key[0] = heap->key[heap->size];
+        indexedHeapSiftDown(heap, 0);
+    }
+    return min;
+}
+
+// Binary heap of (key, vertex) entries without decrease-key
+// An improved distance is pushed as a new entry; older entries for the same
+// vertex become stale and are skipped when popped.
+
+bool initLazyHeap(LazyHeap *heap, long long capacity) {
+    heap->size = 0;
+    heap->capacity = capacity > 16 ? capacity : 16;
+    heap->entries = (HeapEntry*)malloc(heap->capacity * sizeof(HeapEntry));
+    if (heap->entries == NULL) {
+        printf("Memory allocation failed!\n");
+        return false;
+    }
+    return true;
+}
+
+void freeLazyHeap(LazyHeap *heap) {
+    free(heap->entries);
+    heap->entries = NULL;
+    heap->size = heap->capacity = 0;
+}
+
+bool lazyHeapPush(LazyHeap *heap, long long key, int vertex) {
+    if (heap->size == heap->capacity) {
+        HeapEntry *grown = (HeapEntry*)realloc(heap->entries,
+                                                2 * heap->capacity * sizeof(HeapEntry));
+        if (grown == NULL) {
+            printf("Heap overflow!\n");
+            return false;
+        }
+        heap->entries = grown;
+        heap->capacity *= 2;
+    }
+    
+    long long i = heap->size++;
+    while (i > 0 && heap->entries[(i - 1) / 2].key > key) {
+        heap->entries[i] = heap->entries[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap->entries[i].key = key;
+    heap->entries[i].vertex = vertex;
+    return true;
+}
+
+HeapEntry lazyHeapPop(LazyHeap *heap) {
+    HeapEntry min = heap->entries[0];
+    HeapEntry last = heap->entries[--heap->size];
+    long long i = 0;
+    
+    while (1) {
+        long long child = 2 * i + 1;
+        if (child >= heap->size) break;
+        if (child + 1 < heap->size && heap->entries[child + 1].key < heap->entries[child].key) {
+            child++;
+        }
+        if (heap->entries[child].key >= last.key) break;
+        heap->entries[i] = heap->entries[child];
+        i = child;
+    }
+    if (heap->size > 0) heap->entries[i] = last;
+    return min;
+}
+
+// Dijkstra with an indexed d-ary heap and decrease-key (arity 2 or 4 typical)
+bool dijkstraIndexedHeap(CSRGraph *csr, int source, ShortestPathResult *result, int arity) {
+    IndexedHeap heap;
+    if (!initIndexedHeap(&heap, csr->numVertices, arity)) return false;
+    
+    double start = getTimeSeconds();
+    DijkstraStats stats = {0};
+    resetShortestPathResult(result);
+    result->distance[source] = 0;
+    indexedHeapPushOrDecrease(&heap, source, 0);
+    stats.pushes++;
+    
+    while (heap.size > 0) {
+        int u = indexedHeapPopMin(&heap);
+        long long du = result->distance[u];
+        stats.pops++;
+        stats.settled++;
+        TRACE_SETTLE(stats.settled, u, du);
+        
+        for (long long e = csr->offsets[u]; e < csr->offsets[u + 1]; e++) {
+            int v = csr->neighbors[e];
+            long long candidate = addPathLength(du, csr->weights[e]);
+            stats.relaxations++;
+            if (candidate < result->distance[v]) {
+                result->distance[v] = candidate;
+                result->parent[v] = u;
+                stats.successfulRelaxations++;
+                if (heap.position[v] == -1) {
+                    stats.pushes++;
+                } else {
+                    stats.decreaseKeys++;
+                }
+                TRACE_RELAX(v, candidate, u);
+                indexedHeapPushOrDecrease(&heap, v, candidate);
+            }
+        }
+    }
+    
+    stats.wallTime = getTimeSeconds() - start;
+    result->stats = stats;
+    freeIndexedHeap(&heap);
+    return true;
+}
+
+// Dijkstra with a lazy-deletion binary heap
+bool dijkstraLazyHeap(CSRGraph *csr, int source, ShortestPathResult *result) {
+    LazyHeap heap;
+    if (!initLazyHeap(&heap, csr->numVertices)) return false;
+    
+    double start = getTimeSeconds();
+    DijkstraStats stats = {0};
+    resetShortestPathResult(result);
+    result->distance[source] = 0;
+    lazyHeapPush(&heap, 0, source);
+    stats.pushes++;
+    
+    while (heap.size > 0) {
+        HeapEntry top = lazyHeapPop(&heap);
+        int u = top.vertex;
+        stats.pops++;
+        if (top.key > result->distance[u]) continue; // stale entry
+        stats.settled++;
+        TRACE_SETTLE(stats.settled, u, top.key);
+        
+        for (long long e = csr->offsets[u]; e < csr->offsets[u + 1]; e++) {
+            int v = csr->neighbors[e];
+            long long candidate = addPathLength(top.key, csr->weights[e]);
+            stats.relaxations++;
+            if (candidate < result->distance[v]) {
+                result->distance[v] = candidate;
+                result->parent[v] = u;
+                stats.successfulRelaxations++;
+                stats.pushes++;
+                TRACE_RELAX(v, candidate, u);
+                if (!lazyHeapPush(&heap, candidate, v)) {
+                    freeLazyHeap(&heap);
+                    return false;
+                }
+            }
+        }
+    }
+    
+    stats.wallTime = getTimeSeconds() - start;
+    result->stats = stats;
+    freeLazyHeap(&heap);
+    return true;
+}
+
+// Existing O(V²) selection (as in findMinDistance()) on the CSR graph, for comparison
+bool dijkstraLinearScan(CSRGraph *csr, int source, ShortestPathResult *result) {
+    int n = csr->numVertices;
+    bool *settled = (bool*)calloc(n > 0 ? n : 1, sizeof(bool));
+    if (settled == NULL) {
+        printf("Memory allocation failed!\n");
+        return false;
+    }
+    
+    double start = getTimeSeconds();
+    DijkstraStats stats = {0};
+    resetShortestPathResult(result);
+    result->distance[source] = 0;
+    
+    while (1) {
+        int u = -1;
+        for (int v = 0; v < n; v++) {
+            if (!settled[v] && result->distance[v] != INF &&
+                (u == -1 || result->distance[v] < result->distance[u])) {
+                u = v;
+            }
+        }
+        if (u == -1) break;
+        settled[u] = true;
+        stats.pops++;
+        stats.settled++;
+        TRACE_SETTLE(stats.settled, u, result->distance[u]);
+        
+        for (long long e = csr->offsets[u]; e < csr->offsets[u + 1]; e++) {
+            int v = csr->neighbors[e];
+            if (settled[v]) continue;
+            stats.relaxations++;
+            long long candidate = addPathLength(result->distance[u], csr->weights[e]);
+            if (candidate < result->distance[v]) {
+                result->distance[v] = candidate;
+                result->parent[v] = u;
+                stats.successfulRelaxations++;
+                TRACE_RELAX(v, result->distance[v], u);
+            }
+        }
+    }
+    
+    stats.wallTime = getTimeSeconds() - start;
+    result->stats = stats;
+    free(settled);
+    return true;
+}
+
+void displayDijkstraStats(DijkstraStats *stats) {
+    printf("Pushes: %lld, Pops: %lld, Decrease-keys: %lld\n",
+           stats->pushes, stats->pops, stats->decreaseKeys);
+    printf("Relaxations: %lld (%lld successful), Settled vertices: %lld\n",
+           stats->relaxations, stats->successfulRelaxations, stats->settled);
+    printf("Time: %.6f seconds\n", stats->wallTime);
+}
+
+// Append one row of counters to a CSV file, writing the header for a new file
+bool exportDijkstraStatsCSV(const char *path, const char *label, DijkstraStats *stats) {
+    FILE *file = fopen(path, "a");
+    if (file == NULL) {
+        printf("Cannot open %s!\n", path);
+        return false;
+    }
+    
+    if (ftell(file) == 0) {
+        fprintf(file, "label,pushes,pops,decrease_keys,relaxations,"
+                      "successful_relaxations,settled,wall_time\n");
+    }
+    fprintf(file, "%s,%lld,%lld,%lld,%lld,%lld,%lld,%.9f\n", label,
+            stats->pushes, stats->pops, stats->decreaseKeys, stats->relaxations,
+            stats->successfulRelaxations, stats->settled, stats->wallTime);
+    
+    bool ok = !ferror(file);
+    if (fclose(file) != 0) ok = false;
+    if (!ok) printf("Error writing %s!\n", path);
+    return ok;
+}
+
+// Print path from source to destination; path is scratch space for numVertices entries
+void printShortestPath(ShortestPathResult *result, int dest, int *path) {
+    printPathArray(path, reconstructPath(result->parent, dest, path));
+}
+
+// Display all distances and paths from the source
+void displayShortestPaths(ShortestPathResult *result) {
+    int *path = (int*)malloc((result->numVertices > 0 ? result->numVertices : 1) * sizeof(int));
+    if (path == NULL) {
+        printf("Memory allocation failed!\n");
+        return;
+    }
+    
+    printf("Destination\tDistance\tPath\n");
+    
+    for (int i = 0; i < result->numVertices; i++) {
+        printf("%d\t\t", i);
+        
+        if (result->distance[i] == INF) {
+            printf("INF\t\tNo path\n");
+        } else {
+            printf("%lld\t\t", result->distance[i]);
+            printShortestPath(result, i, path);
+            printf("\n");
+        }
+    }
+    displayDijkstraStats(&result->stats);
+    free(path);
+}
+
+// Full table for small graphs; reach and eccentricity only for large ones
+void displayShortestPathSummary(ShortestPathResult *result) {
+    if (result->numVertices <= MAX_VERTICES) {
+        displayShortestPaths(result);
+        return;
+    }
+    int reached = 0;
+    long long farthest = 0;
+    for (int v = 0; v < result->numVertices; v++) {
+        if (result->distance[v] == INF) continue;
+        reached++;
+        if (result->distance[v] > farthest) farthest = result->distance[v];
+    }
+    printf("Reached %d of %d vertices, farthest at distance %lld\n", reached,
+           result->numVertices, farthest);
+    displayDijkstraStats(&result->stats);
+}
+
+bool sameDistances(ShortestPathResult *a, ShortestPathResult *b) {
+    for (int v = 0; v < a->numVertices; v++) {
+        if (a->distance[v] != b->distance[v]) return false;
+    }
+    return true;
+}
+
+// Compare Dijkstra variants on a grid graph from several random sources
+void benchmarkDijkstra(int rows, int cols, int maxWeight, int numSources) {
+    CSRGraph csr;
+    ShortestPathResult reference, result;
+    const char *names[] = {"Linear scan (O(V^2))", "Indexed binary heap",
+                           "Indexed 4-ary heap", "Lazy binary heap"};
+    double total[4] = {0.0, 0.0, 0.0, 0.0};
+    bool ok[4] = {true, true, true, true};
+    
+    printf("\nGenerating %d x %d grid graph (weights 1..%d)...\n", rows, cols, maxWeight);
+    if (!generateGridGraph(&csr, rows, cols, maxWeight, 4242)) {
+        return;
+    }
+    printf("Vertices: %d, Edges: %lld\n", csr.numVertices, csr.numEdges / 2);
+    
+    if (!initShortestPathResult(&reference, csr.numVertices)) {
+        freeCSRGraph(&csr);
+        return;
+    }
+    if (!initShortestPathResult(&result, csr.numVertices)) {
+        freeShortestPathResult(&reference);
+        freeCSRGraph(&csr);
+        return;
+    }
+    
+    // The quadratic baseline is only run where it finishes in reasonable time
+    bool runLinear = csr.numVertices <= LINEAR_SCAN_LIMIT;
+    unsigned long long state = 777;
+    for (int s = 0; s < numSources; s++) {
+        int source = nextRandom(&state) % csr.numVertices;
+        
+        double start = getTimeSeconds();
+        dijkstraIndexedHeap(&csr, source, &reference, 2);
+        total[1] += getTimeSeconds() - start;
+        
+        for (int method = 0; method < 4; method++) {
+            if (method == 1 || (method == 0 && !runLinear)) continue;
+            start = getTimeSeconds();
+            if (method == 0) {
+                dijkstraLinearScan(&csr, source, &result);
+            } else if (method == 2) {
+                dijkstraIndexedHeap(&csr, source, &result, 4);
+            } else {
+                dijkstraLazyHeap(&csr, source, &result);
+            }
+            total[method] += getTimeSeconds() - start;
+            if (!sameDistances(&reference, &result)) ok[method] = false;
+        }
+    }
+    
+    printf("\nVariant\t\t\tAvg time(s)\tCheck\n");
+    for (int method = 0; method < 4; method++) {
+        if (method == 0 && !runLinear) {
+            printf("%-24s(skipped, more than %d vertices)\n", names[method], LINEAR_SCAN_LIMIT);
+            continue;
+        }
+        printf("%-24s%.6f\t%s\n", names[method], total[method] / numSources,
+               ok[method] ? "OK" : "MISMATCH");
+    }
+    
+    freeShortestPathResult(&reference);
+    freeShortestPathResult(&result);
+    freeCSRGraph(&csr);
+}
+
+// Hardware cache miss counter (Linux perf events); -1 if unavailable
+int openCacheMissCounter() {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+void startCacheMissCounter(int fd) {
+    if (fd < 0) return;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+long long stopCacheMissCounter(int fd) {
+    long long count = -1;
+    if (fd < 0) return -1;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(fd, &count, sizeof(count)) != sizeof(count)) return -1;
+    return count;
+}
+
+// Read an order file into newId[] (newId[original id] = new id); the file
+// must hold a permutation of numVertices vertices
+bool loadVertexOrder(const char *path, int numVertices, int *newId) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        printf("Cannot open file %s!\n", path);
+        return false;
+    }
+    
+    OrderFileHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+              memcmp(header.magic, ORDER_FILE_MAGIC, sizeof(header.magic)) == 0 &&
+              header.version == ORDER_FILE_VERSION && header.numVertices == numVertices;
+    for (int v = 0; ok && v < numVertices; v++) {
+        newId[v] = -1;
+    }
+    for (int i = 0; ok && i < numVertices; i++) {
+        int old;
+        ok = fread(&old, sizeof(int), 1, file) == 1 && old >= 0 && old < numVertices &&
+             newId[old] == -1;
+        if (ok) newId[old] = i;
+    }
+    fclose(file);
+    if (!ok) {
+        printf("Invalid order file %s for a graph of %d vertices!\n", path, numVertices);
+    }
+    return ok;
+}
+
+// Dijkstra on a graph file before and after prog_5's reordering (menu
+// option 18 there): same sources, translated with the order file written
+// next to the reordered graph, and distances checked against each other
+void benchmarkReorderedGraph(const char *originalPath, const char *reorderedPath,
+                             int numSources) {
+    CSRGraph original, reordered;
+    ShortestPathResult before, after;
+    char orderPath[512];
+    
+    if (!loadCSRGraphBinary(&original, originalPath)) return;
+    if (!loadCSRGraphBinary(&reordered, reorderedPath)) {
+        freeCSRGraph(&original);
+        return;
+    }
+    int n = original.numVertices;
+    if (reordered.numVertices != n || reordered.numEdges != original.numEdges || n == 0) {
+        printf("The two files do not hold the same graph!\n");
+        freeCSRGraph(&original);
+        freeCSRGraph(&reordered);
+        return;
+    }
+    
+    int *newId = (int*)malloc(n * sizeof(int));
+    snprintf(orderPath, sizeof(orderPath), "%s.order", reorderedPath);
+    if (newId == NULL) printf("Memory allocation failed!\n");
+    if (newId == NULL || !loadVertexOrder(orderPath, n, newId) ||
+        !initShortestPathResult(&before, n)) {
+        free(newId);
+        freeCSRGraph(&original);
+        freeCSRGraph(&reordered);
+        return;
+    }
+    if (!initShortestPathResult(&after, n)) {
+        freeShortestPathResult(&before);
+        free(newId);
+        freeCSRGraph(&original);
+        freeCSRGraph(&reordered);
+        return;
+    }
+    
+    int counter = openCacheMissCounter();
+    if (counter < 0) {
+        printf("Hardware cache miss counter not available, reporting time only\n");
+    }
+    
+    double time[2] = {0.0, 0.0};
+    long long misses[2] = {0, 0};
+    bool ok = true;
+    unsigned long long state = 777;
+    for (int s = 0; s < numSources; s++) {
+        int source = nextRandom(&state) % n;
+        
+        startCacheMissCounter(counter);
+        double start = getTimeSeconds();
+        bool done = dijkstraIndexedHeap(&original, source, &before, 2);
+        time[0] += getTimeSeconds() - start;
+        misses[0] += stopCacheMissCounter(counter);
+        
+        startCacheMissCounter(counter);
+        start = getTimeSeconds();
+        done = dijkstraIndexedHeap(&reordered, newId[source], &after, 2) && done;
+        time[1] += getTimeSeconds() - start;
+        misses[1] += stopCacheMissCounter(counter);
+        if (!done) {
+            ok = false;
+            break;
+        }
+        
+        for (int v = 0; v < n; v++) {
+            if (before.distance[v] != after.distance[newId[v]]) ok = false;
+        }
+    }
+    
+    printf("\nGraph\t\tAvg time(s)\tAvg cache misses\n");
+    for (int i = 0; i < 2; i++) {
+        printf("%-12s\t%.6f\t", i == 0 ? "Original" : "Reordered", time[i] / numSources);
+        if (counter < 0) {
+            printf("n/a\n");
+        } else {
+            printf("%lld\n", misses[i] / numSources);
+        }
+    }
+    printf("Speedup: %.2fx, distances %s\n", time[1] > 0 ? time[0] / time[1] : 0.0,
+           ok ? "match (translated with the order file)" : "MISMATCH");
+    
+    if (counter >= 0) close(counter);
+    freeShortestPathResult(&before);
+    freeShortestPathResult(&after);
+    free(newId);
+    freeCSRGraph(&original);
+    freeCSRGraph(&reordered);
+}
+
+// Monotone integer priority queues
+// Dijkstra only ever pops keys that are >= the last popped key and weights
+// are non-negative integers, so bucket based queues can replace comparisons.
+
+// Make room for `extra` more entries; the bucket is unchanged on failure
+bool bucketReserve(Bucket *bucket, int extra) {
+    if (bucket->size + extra <= bucket->capacity) return true;
+    
+    int newCapacity = bucket->capacity > 0 ? 2 * bucket->capacity : 8;
+    while (newCapacity < bucket->size + extra) newCapacity *= 2;
+    HeapEntry *grown = (HeapEntry*)realloc(bucket->entries, newCapacity * sizeof(HeapEntry));
+    if (grown == NULL) {
+        printf("Memory allocation failed!\n");
+        return false;
+    }
+    bucket->entries = grown;
+    bucket->capacity = newCapacity;
+    return true;
+}
+
+bool bucketPush(Bucket *bucket, long long key, int vertex) {
+    if (!bucketReserve(bucket, 1)) return false;
+    bucket->entries[bucket->size].key = key;
+    bucket->entries[bucket->size].vertex = vertex;
+    bucket->size++;
+    return true;
+}
+
+// Radix heap
+// Bucket i holds keys whose highest bit differing from the last popped key
+// is bit i - 1 (bucket 0: equal to it). Popping from an empty bucket 0
+// empties the first non-empty bucket into lower buckets relative to its
+// minimum, and every key moves down at most 64 times in total.
+
+void initRadixHeap(RadixHeap *heap) {
+    memset(heap, 0, sizeof(RadixHeap));
+}
+
+void freeRadixHeap(RadixHeap *heap) {
+    for (int i = 0; i < RADIX_BUCKETS; i++) {
+        free(heap->buckets[i].entries);
+    }
+    initRadixHeap(heap);
+}
+
+int radixBucketIndex(unsigned long long key, unsigned long long last) {
+    unsigned long long diff = key ^ last;
+    return diff == 0 ? 0 : 64 - __builtin_clzll(diff);
+}
+
+bool radixHeapPush(RadixHeap *heap, long long key, int vertex) {
+    if (!bucketPush(&heap->buckets[radixBucketIndex(key, heap->last)], key, vertex)) {
+        return false;
+    }
+    heap->size++;
+    return true;
+}
+
+// Pop the minimum into *min. Fails only if redistribution cannot grow the
+// lower buckets, and then the heap is left unchanged.
+bool radixHeapPop(RadixHeap *heap, HeapEntry *min) {
+    if (heap->buckets[0].size == 0) {
+        int i = 1;
+        while (heap->buckets[i].size == 0) i++;
+        
+        Bucket *bucket = &heap->buckets[i];
+        unsigned long long newLast = (unsigned long long)bucket->entries[0].key;
+        for (int k = 1; k < bucket->size; k++) {
+            if ((unsigned long long)bucket->entries[k].key < newLast) {
+                newLast = (unsigned long long)bucket->entries[k].key;
+            }
+        }
+        
+        // Every entry lands in a strictly lower bucket; reserve all the room
+        // first so that no entry can be lost halfway through
+        int counts[RADIX_BUCKETS] = {0};
+        for (int k = 0; k < bucket->size; k++) {
+            counts[radixBucketIndex(bucket->entries[k].key, newLast)]++;
+        }
+        for (int j = 0; j < i; j++) {
+            if (!bucketReserve(&heap->buckets[j], counts[j])) return false;
+        }
+        
+        heap->last = newLast;
+        for (int k = 0; k < bucket->size; k++) {
+            HeapEntry entry = bucket->entries[k];
+            Bucket *target = &heap->buckets[radixBucketIndex(entry.key, newLast)];
+            target->entries[target->size++] = entry;
+        }
+        bucket->size = 0;
+    }
+    heap->size--;
+    *min = heap->buckets[0].entries[--heap->buckets[0].size];
+    return true;
+}
+
+// Dial's bucket queue
+// maxWeight + 1 circular buckets indexed by key mod (maxWeight + 1). All keys
+// in the queue lie in [current, current + maxWeight], so they never collide.
+
+bool initDialQueue(DialQueue *queue, int maxWeight) {
+    queue->numBuckets = maxWeight + 1;
+    queue->current = 0;
+    queue->size = 0;
+    queue->buckets = (Bucket*)calloc(queue->numBuckets, sizeof(Bucket));
+    if (queue->buckets == NULL) {
+        printf("Memory allocation failed!\n");
+        return false;
+    }
+    return true;
+}
+
+void freeDialQueue(DialQueue *queue) {
+    if (queue->buckets != NULL) {
+        for (int i = 0; i < queue->numBuckets; i++) {
+            free(queue->buckets[i].entries);
+        }
+    }
+    free(queue->buckets);
+    queue->buckets = NULL;
+    queue->size = 0;
+}
+
+bool dialPush(DialQueue *queue, long long key, int vertex) {
+    if (!bucketPush(&queue->buckets[key % queue->numBuckets], key, vertex)) return false;
+    queue->size++;
+    return true;
+}
+
+HeapEntry dialPop(DialQueue *queue) {
+    while (queue->buckets[queue->current % queue->numBuckets].size == 0) {
+        queue->current++;
+    }
+    Bucket *bucket = &queue->buckets[queue->current % queue->numBuckets];
+    queue->size--;
+    return bucket->entries[--bucket->size];
+}
+
+int maxEdgeWeight(CSRGraph *csr) {
+    int maxWeight = 0;
+    for (long long e = 0; e < csr->numEdges; e++) {
+        if (csr->weights[e] > maxWeight) maxWeight = csr->weights[e];
+    }
+    return maxWeight;
+}
+
+// Dijkstra with a radix heap (lazy deletion)
+bool dijkstraRadixHeap(CSRGraph *csr, int source, ShortestPathResult *result) {
+    RadixHeap heap;
+    initRadixHeap(&heap);
+    
+    double start = getTimeSeconds();
+    DijkstraStats stats = {0};
+    resetShortestPathResult(result);
+    result->distance[source] = 0;
+    if (!radixHeapPush(&heap, 0, source)) {
+        freeRadixHeap(&heap);
+        return false;
+    }
+    stats.pushes++;
+    
+    while (heap.size > 0) {
+        HeapEntry top;
+        if (!radixHeapPop(&heap, &top)) {
+            freeRadixHeap(&heap);
+            return false;
+        }
+        int u = top.vertex;
+        stats.pops++;
+        if (top.key > result->distance[u]) continue; // stale entry
+        stats.settled++;
+        TRACE_SETTLE(stats.settled, u, top.key);
+        
+        for (long long e = csr->offsets[u]; e < csr->offsets[u + 1]; e++) {
+            int v = csr->neighbors[e];
+            long long candidate = addPathLength(top.key, csr->weights[e]);
+            stats.relaxations++;
+            if (candidate < result->distance[v]) {
+                result->distance[v] = candidate;
+                result->parent[v] = u;
+                stats.successfulRelaxations++;
+                stats.pushes++;
+                TRACE_RELAX(v, candidate, u);
+                if (!radixHeapPush(&heap, candidate, v)) {
+                    freeRadixHeap(&heap);
+                    return false;
+                }
+            }
+        }
+    }
+    
+    stats.wallTime = getTimeSeconds() - start;
+    result->stats = stats;
+    freeRadixHeap(&heap);
+    return true;
+}
+
+// Dijkstra with Dial's bucket queue (best for small maximum weights)
+bool dijkstraDial(CSRGraph *csr, int source, ShortestPathResult *result) {
+    DialQueue queue;
+    int maxWeight = maxEdgeWeight(csr);
+    if (maxWeight > DIAL_MAX_WEIGHT) {
+        printf("Maximum weight %d too large for Dial's algorithm (limit %d)!\n",
+               maxWeight, DIAL_MAX_WEIGHT);
+        return false;
+    }
+    if (!initDialQueue(&queue, maxWeight)) return false;
+    
+    double start = getTimeSeconds();
+    DijkstraStats stats = {0};
+    resetShortestPathResult(result);
+    result->distance[source] = 0;
+    if (!dialPush(&queue, 0, source)) {
+        freeDialQueue(&queue);
+        return false;
+    }
+    stats.pushes++;
+    
+    while (queue.size > 0) {
+        HeapEntry top = dialPop(&queue);
+        int u = top.vertex;
+        stats.pops++;
+        if (top.key > result->distance[u]) continue; // stale entry
+        stats.settled++;
+        TRACE_SETTLE(stats.settled, u, top.key);
+        
+        for (long long e = csr->offsets[u]; e < csr->offsets[u + 1]; e++) {
+            int v = csr->neighbors[e];
+            long long candidate = addPathLength(top.key, csr->weights[e]);
+            stats.relaxations++;
+            if (candidate < result->distance[v]) {
+                result->distance[v] = candidate;
+                result->parent[v] = u;
+                stats.successfulRelaxations++;
+                stats.pushes++;
+                TRACE_RELAX(v, candidate, u);
+                if (!dialPush(&queue, candidate, v)) {
+                    freeDialQueue(&queue);
+                    return false;
+                }
+            }
+        }
+    }
+    
+    stats.wallTime = getTimeSeconds() - start;
+    result->stats = stats;
+    freeDialQueue(&queue);
+    return true;
+}
+
+// Run Dijkstra with the chosen priority queue
+bool dijkstraSparse(CSRGraph *csr, int source, ShortestPathResult *result, QueueType queue) {
+    switch (queue) {
+        case QUEUE_BINARY_HEAP:
+            return dijkstraIndexedHeap(csr, source, result, 2);
+        case QUEUE_FOUR_ARY_HEAP:
+            return dijkstraIndexedHeap(csr, source, result, 4);
+        case QUEUE_LAZY_HEAP:
+            return dijkstraLazyHeap(csr, source, result);
+        case QUEUE_RADIX_HEAP:
+            return dijkstraRadixHeap(csr, source, result);
+        case QUEUE_DIAL:
+            return dijkstraDial(csr, source, result);
+        default:
+            printf("Invalid priority queue!\n");
+            return false;
+    }
+}
+
+const char *queueTypeName(QueueType queue) {
+    switch (queue) {
+        case QUEUE_BINARY_HEAP: return "Indexed binary heap";
+        case QUEUE_FOUR_ARY_HEAP: return "Indexed 4-ary heap";
+        case QUEUE_LAZY_HEAP: return "Lazy binary heap";
+        case QUEUE_RADIX_HEAP: return "Radix heap";
+        case QUEUE_DIAL: return "Dial buckets";
+        default: return "Unknown";
+    }
+}
+
+// Compare heaps with the integer queues for several maximum weights
+void benchmarkIntegerQueues(int rows, int cols, int numSources) {
+    int maxWeights[] = {1, 10, 100, 1000, 100000};
+    QueueType queues[] = {QUEUE_BINARY_HEAP, QUEUE_LAZY_HEAP, QUEUE_RADIX_HEAP, QUEUE_DIAL};
+    int numWeights = sizeof(maxWeights) / sizeof(maxWeights[0]);
+    int numQueues = sizeof(queues) / sizeof(queues[0]);
+    CSRGraph csr;
+    ShortestPathResult reference, result;
+    
+    printf("\n%d x %d grid, average of %d sources (seconds)\n", rows, cols, numSources);
+    printf("Max weight");
+    for (int q = 0; q < numQueues; q++) {
+        printf("\t%s", queueTypeName(queues[q]));
+    }
+    printf("\tFastest\n");
+    
+    for (int w = 0; w < numWeights; w++) {
+        if (!generateGridGraph(&csr, rows, cols, maxWeights[w], 4242)) return;
+        if (!initShortestPathResult(&reference, csr.numVertices)) {
+            freeCSRGraph(&csr);
+            return;
+        }
+        if (!initShortestPathResult(&result, csr.numVertices)) {
+            freeShortestPathResult(&reference);
+            freeCSRGraph(&csr);
+            return;
+        }
+        
+        double times[8] = {0.0};
+        bool ok = true;
+        unsigned long long state = 777;
+        for (int s = 0; s < numSources; s++) {
+            int source = nextRandom(&state) % csr.numVertices;
+            dijkstraSparse(&csr, source, &reference, QUEUE_BINARY_HEAP);
+            for (int q = 0; q < numQueues; q++) {
+                double start = getTimeSeconds();
+                dijkstraSparse(&csr, source, &result, queues[q]);
+                times[q] += getTimeSeconds() - start;
+                if (!sameDistances(&reference, &result)) ok = false;
+            }
+        }
+        
+        int fastest = 0;
+        printf("%d", maxWeights[w]);
+        for (int q = 0; q < numQueues; q++) {
+            printf("\t\t%.6f", times[q] / numSources);
+            if (times[q] < times[fastest]) fastest = q;
+        }
+        printf("\t%s%s\n", queueTypeName(queues[fastest]), ok ? "" : " (MISMATCH)");
+        
+        freeShortestPathResult(&reference);
+        freeShortestPathResult(&result);
+        freeCSRGraph(&csr);
+    }
+}
+
+// Point-to-point queries
+
+bool initPathQuery(PathQuery *query, int numVertices) {
+    memset(query, 0, sizeof(PathQuery));
+    query->numVertices = numVertices;
+    int size = numVertices > 0 ? numVertices : 1;
+    
+    for (int side = 0; side < 2; side++) {
+        query->distance[side] = (long long*)malloc(size * sizeof(long long));
+        query->parent[side] = (int*)malloc(size * sizeof(int));
+        query->touched[side] = (int*)malloc(size * sizeof(int));
+        if (query->distance[side] == NULL || query->parent[side] == NULL ||
+            query->touched[side] == NULL || !initIndexedHeap(&query->heap[side], numVertices, 2)) {
+            printf("Memory allocation failed!\n");
+            freePathQuery(query);
+            return false;
+        }
+        for (int v = 0; v < numVertices; v++) {
+            query->distance[side][v] = INF;
+            query->parent[side][v] = -1;
+        }
+    }
+    query->meeting = -1;
+    query->pathDistance = INF;
+    return true;
+}
+
+void freePathQuery(PathQuery *query) {
+    for (int side = 0; side < 2; side++) {
+        free(query->distance[side]);
+        free(query->parent[side]);
+        free(query->touched[side]);
+        freeIndexedHeap(&query->heap[side]);
+        query->distance[side] = NULL;
+        query->parent[side] = query->touched[side] = NULL;
+    }
+}
+
+// Undo what the previous query wrote
+void resetPathQuery(PathQuery *query) {
+    for (int side = 0; side < 2; side++) {
+        for (int i = 0; i < query->numTouched[side]; i++) {
+            int v = query->touched[side][i];
+            query->distance[side][v] = INF;
+            query->parent[side][v] = -1;
+        }
+        query->numTouched[side] = 0;
+        
+        IndexedHeap *heap = &query->heap[side];
+        for (int i = 0; i < heap->size; i++) {
+            heap->position[heap->vertex[i]] = -1;
+        }
+        heap->size = 0;
+    }
+    query->meeting = -1;
+    query->pathDistance = INF;
+    memset(&query->stats, 0, sizeof(DijkstraStats));
+}
+
+void pathQueryReach(PathQuery *query, int side, int v, long long distance, int via) {
+    if (query->distance[side][v] == INF) {
+        query->touched[side][query->numTouched[side]++] = v;
+    }
+    query->distance[side][v] = distance;
+    query->parent[side][v] = via;
+}
+
+// Dijkstra from source that stops as soon as target is settled
+long long dijkstraPointToPoint(CSRGraph *csr, int source, int target, PathQuery *query) {
+    double start = getTimeSeconds();
+    DijkstraStats stats = {0};
+    IndexedHeap *heap = &query->heap[0];
+    long long *distance = query->distance[0];
+    
+    resetPathQuery(query);
+    query->source = source;
+    query->target = target;
+    pathQueryReach(query, 0, source, 0, -1);
+    indexedHeapPushOrDecrease(heap, source, 0);
+    stats.pushes++;
+    
+    while (heap->size > 0) {
+        int u = indexedHeapPopMin(heap);
+        long long du = distance[u];
+        stats.pops++;
+        stats.settled++;
+        TRACE_SETTLE(stats.settled, u, du);
+        if (u == target) {
+            query->meeting = target;
+            query->pathDistance = du;
+            break;
+        }
+        
+        for (long long e = csr->offsets[u]; e < csr->offsets[u + 1]; e++) {
+            int v = csr->neighbors[e];
+            long long candidate = addPathLength(du, csr->weights[e]);
+            stats.relaxations++;
+            if (candidate < distance[v]) {
+                stats.successfulRelaxations++;
+                if (heap->position[v] == -1) {
+                    stats.pushes++;
+                } else {
+                    stats.decreaseKeys++;
+                }
+                TRACE_RELAX(v, candidate, u);
+                pathQueryReach(query, 0, v, candidate, u);
+                indexedHeapPushOrDecrease(heap, v, candidate);
+            }
+        }
+    }
+    
+    stats.wallTime = getTimeSeconds() - start;
+    query->stats = stats;
+    return query->pathDistance;
+}
+
+// Bidirectional Dijkstra
+// Both searches advance alternately (the side with the smaller queue minimum
+// goes next). Every time a vertex is reached from one side and already has a
+// distance from the other, the joined path is a candidate for the best path.
+// Once the two queue minima add up to at least the best path, no shorter path
+// can exist. The graph is undirected, so the backward search follows the same
+// arcs as the forward search.
+long long dijkstraBidirectional(CSRGraph *csr, int source, int target, PathQuery *query) {
+    double start = getTimeSeconds();
+    DijkstraStats stats = {0};
+    long long best = INF;
+    
+    resetPathQuery(query);
+    query->source = source;
+    query->target = target;
+    pathQueryReach(query, 0, source, 0, -1);
+    pathQueryReach(query, 1, target, 0, -1);
+    if (source == target) {
+        best = 0;
+        query->meeting = source;
+    } else {
+        indexedHeapPushOrDecrease(&query->heap[0], source, 0);
+        indexedHeapPushOrDecrease(&query->heap[1], target, 0);
+        stats.pushes += 2;
+    }
+    
+    while (query->heap[0].size > 0 && query->heap[1].size > 0) {
+        long long min0 = query->heap[0].key[0];
+        long long min1 = query->heap[1].key[0];
+        if (min0 + min1 >= best) break;
+        
+        int side = min0 <= min1 ? 0 : 1;
+        int other = 1 - side;
+        IndexedHeap *heap = &query->heap[side];
+        long long *distance = query->distance[side];
+        int u = indexedHeapPopMin(heap);
+        long long du = distance[u];
+        stats.pops++;
+        stats.settled++;
+        TRACE_SETTLE(stats.settled, u, du);
+        
+        for (long long e = csr->offsets[u]; e < csr->offsets[u + 1]; e++) {
+            int v = csr->neighbors[e];
+            long long candidate = addPathLength(du, csr->weights[e]);
+            stats.relaxations++;
+            if (candidate < distance[v]) {
+                stats.successfulRelaxations++;
+                if (heap->position[v] == -1) {
+                    stats.pushes++;
+                } else {
+                    stats.decreaseKeys++;
+                }
+                TRACE_RELAX(v, candidate, u);
+                pathQueryReach(query, side, v, candidate, u);
+                indexedHeapPushOrDecrease(heap, v, candidate);
+                
+                if (query->distance[other][v] != INF &&
+                    candidate + query->distance[other][v] < best) {
+                    best = candidate + query->distance[other][v];
+                    query->meeting = v;
+                }
+            }
+        }
+    }
+    
+    query->pathDistance = best;
+    stats.wallTime = getTimeSeconds() - start;
+    query->stats = stats;
+    return query->pathDistance;
+}
+
+// Write the path of the last query into path[] (room for numVertices entries);
+// returns its length, 0 if the target is unreachable
+int queryPath(PathQuery *query, int *path) {
+    if (query->meeting == -1) return 0;
+    
+    // Forward half: source .. meeting
+    int length = reconstructPath(query->parent[0], query->meeting, path);
+    
+    // Backward half: the backward parents already point towards the target
+    for (int v = query->parent[1][query->meeting]; v != -1; v = query->parent[1][v]) {
+        path[length++] = v;
+    }
+    return length;
+}
+
+void displayPathQuery(PathQuery *query) {
+    int *path = (int*)malloc((query->numVertices > 0 ? query->numVertices : 1) * sizeof(int));
+    if (path == NULL) {
+        printf("Memory allocation failed!\n");
+        return;
+    }
+    
+    if (query->pathDistance == INF) {
+        printf("No path from %d to %d\n", query->source, query->target);
+    } else {
+        printf("Distance from %d to %d: %lld\nPath: ", query->source, query->target,
+               query->pathDistance);
+        printPathArray(path, queryPath(query, path));
+        printf("\n");
+    }
+    displayDijkstraStats(&query->stats);
+    free(path);
+}
+
+// Check that a path runs from source to target over existing edges and
+// that its weights add up to the given distance
+bool checkPath(CSRGraph *csr, int source, int target, long long distance, const int *path,
+               int length) {
+    if (distance == INF) return length == 0;
+    if (length == 0 || path[0] != source || path[length - 1] != target) {
+        return false;
+    }
+    
+    long long total = 0;
+    for (int i = 0; i + 1 < length; i++) {
+        long long best = INF;
+        for (long long e = csr->offsets[path[i]]; e < csr->offsets[path[i] + 1]; e++) {
+            if (csr->neighbors[e] == path[i + 1] && csr->weights[e] < best) {
+                best = csr->weights[e];
+            }
+        }
+        if (best == INF) return false;
+        total += best;
+    }
+    return total == distance;
+}
+
+bool checkQueryPath(CSRGraph *csr, PathQuery *query, int *path) {
+    int length = queryPath(query, path);
+    return checkPath(csr, query->source, query->target, query->pathDistance, path, length);
+}
+
+// Compare a full Dijkstra run with the early-exit and bidirectional queries
+// on random source-target pairs of a grid graph
+void benchmarkPointToPoint(int rows, int cols, int maxWeight, int numQueries) {
+    CSRGraph csr;
+    ShortestPathResult full;
+    PathQuery query;
+    const char *names[] = {"Full Dijkstra", "Early exit", "Bidirectional"};
+    double total[3] = {0.0, 0.0, 0.0};
+    long long settled[3] = {0, 0, 0};
+    bool ok = true;
+    int *path;
+    
+    printf("\nGenerating %d x %d grid graph (weights 1..%d)...\n", rows, cols, maxWeight);
+    if (!generateGridGraph(&csr, rows, cols, maxWeight, 4242)) {
+        return;
+    }
+    path = (int*)malloc(csr.numVertices * sizeof(int));
+    if (path == NULL || !initShortestPathResult(&full, csr.numVertices)) {
+        free(path);
+        freeCSRGraph(&csr);
+        return;
+    }
+    if (!initPathQuery(&query, csr.numVertices)) {
+        free(path);
+        freeShortestPathResult(&full);
+        freeCSRGraph(&csr);
+        return;
+    }
+    
+    unsigned long long state = 777;
+    for (int q = 0; q < numQueries; q++) {
+        int source = nextRandom(&state) % csr.numVertices;
+        int target = nextRandom(&state) % csr.numVertices;
+        
+        dijkstraIndexedHeap(&csr, source, &full, 2);
+        total[0] += full.stats.wallTime;
+        settled[0] += full.stats.settled;
+        
+        for (int method = 1; method < 3; method++) {
+            long long distance = method == 1
+                ? dijkstraPointToPoint(&csr, source, target, &query)
+                : dijkstraBidirectional(&csr, source, target, &query);
+            total[method] += query.stats.wallTime;
+            settled[method] += query.stats.settled;
+            if (distance != full.distance[target] || !checkQueryPath(&csr, &query, path)) {
+                ok = false;
+            }
+        }
+    }
+    
+    printf("%d queries\n", numQueries);
+    printf("Method\t\tAvg time(s)\tAvg settled\tSpeedup\n");
+    for (int method = 0; method < 3; method++) {
+        printf("%-16s%.6f\t%lld\t\t%.1fx\n", names[method], total[method] / numQueries,
+               settled[method] / numQueries,
+               total[method] > 0 ? total[0] / total[method] : 0.0);
+    }
+    printf("Distances and paths %s\n", ok ? "match full Dijkstra" : "MISMATCH");
+    
+    free(path);
+    freePathQuery(&query);
+    freeShortestPathResult(&full);
+    freeCSRGraph(&csr);
+}
+
+// A* search
+// The queue key of a vertex is its distance from the source plus a lower
+// bound on its distance to the target, so the search is pulled towards the
+// target. All heuristics below are consistent (h(u) <= w(u,v) + h(v)), hence
+// every vertex is still settled at most once and the search can stop when
+// the target is settled, exactly like dijkstraPointToPoint().
+
+long long zeroEstimate(const Heuristic *heuristic, int vertex, int target) {
+    (void)heuristic;
+    (void)vertex;
+    (void)target;
+    return 0;
+}
+
+long long euclideanEstimate(const Heuristic *heuristic, int vertex, int target) {
+    double dx = heuristic->x[vertex] - heuristic->x[target];
+    double dy = heuristic->y[vertex] - heuristic->y[target];
+    return (long long)(heuristic->scale * sqrt(dx * dx + dy * dy));
+}
+
+long long manhattanEstimate(const Heuristic *heuristic, int vertex, int target) {
+    double distance = fabs(heuristic->x[vertex] - heuristic->x[target]) +
+                      fabs(heuristic->y[vertex] - heuristic->y[target]);
+    return (long long)(heuristic->scale * distance);
+}
+
+// ALT bound: by the triangle inequality d(v,t) >= |d(L,t) - d(L,v)| for every landmark L
+long long landmarkEstimate(const Heuristic *heuristic, int vertex, int target) {
+    long long best = 0;
+    for (int i = 0; i < heuristic->numLandmarks; i++) {
+        const long long *distance =
+            heuristic->landmarkDistance + (long long)i * heuristic->numVertices;
+        if (distance[vertex] == INF || distance[target] == INF) continue;
+        long long bound = llabs(distance[target] - distance[vertex]);
+        if (bound > best) best = bound;
+    }
+    return best;
+}
+
+void initZeroHeuristic(Heuristic *heuristic) {
+    memset(heuristic, 0, sizeof(Heuristic));
+    heuristic->estimate = zeroEstimate;
+    heuristic->name = "None (Dijkstra)";
+}
+
+// Coordinate heuristic, Euclidean or Manhattan. The scale is the smallest
+// ratio of edge weight to coordinate distance over all edges, which makes
+// scale * (coordinate distance) a lower bound on every path.
+void initGeometricHeuristic(Heuristic *heuristic, CSRGraph *csr, const double *x,
+                            const double *y, bool manhattan) {
+    double minRatio = -1.0;
+    
+    memset(heuristic, 0, sizeof(Heuristic));
+    heuristic->x = x;
+    heuristic->y = y;
+    heuristic->numVertices = csr->numVertices;
+    heuristic->estimate = manhattan ? manhattanEstimate : euclideanEstimate;
+    heuristic->name = manhattan ? "Manhattan" : "Euclidean";
+    
+    for (int u = 0; u < csr->numVertices; u++) {
+        for (long long e = csr->offsets[u]; e < csr->offsets[u + 1]; e++) {
+            int v = csr->neighbors[e];
+            double dx = x[u] - x[v];
+            double dy = y[u] - y[v];
+            double length = manhattan ? fabs(dx) + fabs(dy) : sqrt(dx * dx + dy * dy);
+            if (length == 0.0) continue;
+            double ratio = csr->weights[e] / length;
+            if (minRatio < 0.0 || ratio < minRatio) minRatio = ratio;
+        }
+    }
+    
+    // Shrink slightly so rounding never lifts an estimate above the true distance
+    heuristic->scale = minRatio > 0.0 ? minRatio * (1.0 - 1e-9) : 0.0;
+}
+
+// ALT heuristic: one full Dijkstra per landmark. The first landmark is the
+// vertex farthest from vertex 0, every further one the vertex farthest from
+// all landmarks chosen so far, which spreads them around the graph border.
+bool initLandmarkHeuristic(Heuristic *heuristic, CSRGraph *csr, int numLandmarks) {
+    ShortestPathResult result;
+    int n = csr->numVertices;
+    
+    memset(heuristic, 0, sizeof(Heuristic));
+    heuristic->estimate = landmarkEstimate;
+    heuristic->name = "ALT landmarks";
+    heuristic->numVertices = n;
+    if (n == 0) return true;
+    
+    heuristic->landmarks = (int*)malloc(numLandmarks * sizeof(int));
+    heuristic->landmarkDistance =
+        (long long*)malloc((long long)numLandmarks * n * sizeof(long long));
+    long long *nearest = (long long*)malloc(n * sizeof(long long));
+    if (heuristic->landmarks == NULL || heuristic->landmarkDistance == NULL ||
+        nearest == NULL || !initShortestPathResult(&result, n)) {
+        printf("Memory allocation failed!\n");
+        free(nearest);
+        freeHeuristic(heuristic);
+        return false;
+    }
+    
+    dijkstraIndexedHeap(csr, 0, &result, 2);
+    for (int v = 0; v < n; v++) {
+        nearest[v] = result.distance[v];
+    }
+    
+    for (int i = 0; i < numLandmarks; i++) {
+        int farthest = 0;
+        for (int v = 0; v < n; v++) {
+            if (nearest[v] != INF && nearest[v] > nearest[farthest]) farthest = v;
+        }
+        
+        heuristic->landmarks[i] = farthest;
+        heuristic->numLandmarks++;
+        dijkstraIndexedHeap(csr, farthest, &result, 2);
+        
+        long long *distance = heuristic->landmarkDistance + (long long)i * n;
+        for (int v = 0; v < n; v++) {
+            distance[v] = result.distance[v];
+            if (i == 0 || distance[v] < nearest[v]) nearest[v] = distance[v];
+        }
+    }
+    
+    free(nearest);
+    freeShortestPathResult(&result);
+    return true;
+}
+
+void freeHeuristic(Heuristic *heuristic) {
+    free(heuristic->landmarks);
+    free(heuristic->landmarkDistance);
+    heuristic->landmarks = NULL;
+    heuristic->landmarkDistance = NULL;
+    heuristic->numLandmarks = 0;
+}
+
+// A* from source to target using the query workspace of dijkstraPointToPoint()
+long long astarQuery(CSRGraph *csr, int source, int target, const Heuristic *heuristic,
+                     PathQuery *query) {
+    double start = getTimeSeconds();
+    DijkstraStats stats = {0};
+    IndexedHeap *heap = &query->heap[0];
+    long long *distance = query->distance[0];
+    
+    resetPathQuery(query);
+    query->source = source;
+    query->target = target;
+    pathQueryReach(query, 0, source, 0, -1);
+    indexedHeapPushOrDecrease(heap, source, heuristic->estimate(heuristic, source, target));
+    stats.pushes++;
+    
+    while (heap->size > 0) {
+        int u = indexedHeapPopMin(heap);
+        long long du = distance[u];
+        stats.pops++;
+        stats.settled++;
+        TRACE_SETTLE(stats.settled, u, du);
+        if (u == target) {
+            query->meeting = target;
+            query->pathDistance = du;
+            break;
+        }
+        
+        for (long long e = csr->offsets[u]; e < csr->offsets[u + 1]; e++) {
+            int v = csr->neighbors[e];
+            long long candidate = addPathLength(du, csr->weights[e]);
+            stats.relaxations++;
+            if (candidate < distance[v]) {
+                stats.successfulRelaxations++;
+                if (heap->position[v] == -1) {
+                    stats.pushes++;
+                } else {
+                    stats.decreaseKeys++;
+                }
+                TRACE_RELAX(v, candidate, u);
+                pathQueryReach(query, 0, v, candidate, u);
+                indexedHeapPushOrDecrease(heap, v,
+                                          candidate + heuristic->estimate(heuristic, v, target));
+            }
+        }
+    }
+    
+    stats.wallTime = getTimeSeconds() - start;
+    query->stats = stats;
+    return query->pathDistance;
+}
+
+// Coordinates of generateGridGraph() vertices: column as x, row as y
+bool gridCoordinates(int rows, int cols, double **x, double **y) {
+    int n = rows * cols;
+    *x = (double*)malloc((n > 0 ? n : 1) * sizeof(double));
+    *y = (double*)malloc((n > 0 ? n : 1) * sizeof(double));
+    if (*x == NULL || *y == NULL) {
+        printf("Memory allocation failed!\n");
+        free(*x);
+        free(*y);
+        *x = *y = NULL;
+        return false;
+    }
+    for (int v = 0; v < n; v++) {
+        (*x)[v] = v % cols;
+        (*y)[v] = v / cols;
+    }
+    return true;
+}
+
+// Grid graph whose weights follow the geometry, as on a road network: every
+// vertex is moved up to a quarter unit from its grid point (x, y filled by
+// gridCoordinates() are perturbed in place), and an edge of length L weighs
+// round(L * unitWeight) plus up to 25% random jitter. The geometric A*
+// bounds are then nearly tight, unlike on generateGridGraph() weights.
+bool generateGeometricGridGraph(CSRGraph *csr, int rows, int cols, int unitWeight,
+                                unsigned long long seed, double *x, double *y) {
+    int n = rows * cols;
+    long long m = (long long)rows * (cols - 1) + (long long)(rows - 1) * cols;
+    int *src = (int*)malloc((m > 0 ? m : 1) * sizeof(int));
+    int *dest = (int*)malloc((m > 0 ? m : 1) * sizeof(int));
+    int *weight = (int*)malloc((m > 0 ? m : 1) * sizeof(int));
+    unsigned long long state = seed ? seed : 1;
+    
+    if (src == NULL || dest == NULL || weight == NULL) {
+        printf("Memory allocation failed!\n");
+        free(src);
+        free(dest);
+        free(weight);
+        initCSRGraph(csr);
+        return false;
+    }
+    
+    for (int v = 0; v < n; v++) {
+        x[v] += ((double)(nextRandom(&state) % 1001) / 1000.0 - 0.5) / 2.0;
+        y[v] += ((double)(nextRandom(&state) % 1001) / 1000.0 - 0.5) / 2.0;
+    }
+    
+    long long k = 0;
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            int v = r * cols + c;
+            for (int side = 0; side < 2; side++) {
+                int u = side == 0 ? v + 1 : v + cols;
+                if (side == 0 ? c + 1 >= cols : r + 1 >= rows) continue;
+                
+                double dx = x[u] - x[v], dy = y[u] - y[v];
+                double base = sqrt(dx * dx + dy * dy) * unitWeight + 0.5;
+                if (base > INT_MAX / 2) base = INT_MAX / 2;
+                int w = base >= 1.0 ? (int)base : 1;
+                src[k] = v;
+                dest[k] = u;
+                weight[k++] = w + (int)(nextRandom(&state) % (w / 4 + 1));
+            }
+        }
+    }
+    
+    bool ok = buildCSRFromEdges(csr, n, src, dest, weight, m);
+    free(src);
+    free(dest);
+    free(weight);
+    return ok;
+}
+
+// A* with no heuristic, Euclidean, Manhattan and ALT on random source-target
+// pairs, checked against the no-heuristic run
+void runAStarQueries(CSRGraph *csr, const double *x, const double *y, int numLandmarks,
+                     int numQueries) {
+    PathQuery query;
+    Heuristic heuristics[4];
+    double total[4] = {0.0, 0.0, 0.0, 0.0};
+    long long settled[4] = {0, 0, 0, 0};
+    bool ok[4] = {true, true, true, true};
+    
+    if (!initPathQuery(&query, csr->numVertices)) return;
+    
+    initZeroHeuristic(&heuristics[0]);
+    initGeometricHeuristic(&heuristics[1], csr, x, y, false);
+    initGeometricHeuristic(&heuristics[2], csr, x, y, true);
+    double start = getTimeSeconds();
+    if (!initLandmarkHeuristic(&heuristics[3], csr, numLandmarks)) {
+        freePathQuery(&query);
+        return;
+    }
+    printf("%d landmarks precomputed in %.3f seconds\n", numLandmarks, getTimeSeconds() - start);
+    
+    unsigned long long state = 777;
+    for (int q = 0; q < numQueries; q++) {
+        int source = nextRandom(&state) % csr->numVertices;
+        int target = nextRandom(&state) % csr->numVertices;
+        long long reference = 0;
+        
+        for (int h = 0; h < 4; h++) {
+            long long distance = astarQuery(csr, source, target, &heuristics[h], &query);
+            total[h] += query.stats.wallTime;
+            settled[h] += query.stats.settled;
+            if (h == 0) reference = distance;
+            else if (distance != reference) ok[h] = false;
+        }
+    }
+    
+    printf("%d queries\n", numQueries);
+    printf("Heuristic\t\tAvg time(s)\tAvg settled\tReduction\tCheck\n");
+    for (int h = 0; h < 4; h++) {
+        printf("%-24s%.6f\t%lld\t\t%.1fx\t\t%s\n", heuristics[h].name, total[h] / numQueries,
+               settled[h] / numQueries,
+               settled[h] > 0 ? (double)settled[0] / settled[h] : 0.0,
+               ok[h] ? "OK" : "MISMATCH");
+    }
+    
+    for (int h = 0; h < 4; h++) {
+        freeHeuristic(&heuristics[h]);
+    }
+    freePathQuery(&query);
+}
+
+// Settled vertices and time of A* with each heuristic against the
+// early-exit Dijkstra, first on a grid graph with random weights, then on
+// one whose weights scale with the distance between the endpoints
+void benchmarkAStar(int rows, int cols, int maxWeight, int numLandmarks, int numQueries) {
+    CSRGraph csr;
+    double *x, *y;
+    
+    if (!gridCoordinates(rows, cols, &x, &y)) return;
+    
+    printf("\nGenerating %d x %d grid graph (weights 1..%d)...\n", rows, cols, maxWeight);
+    if (generateGridGraph(&csr, rows, cols, maxWeight, 4242)) {
+        runAStarQueries(&csr, x, y, numLandmarks, numQueries);
+        freeCSRGraph(&csr);
+    }
+    
+    printf("\nGenerating %d x %d geometric grid graph (weight %d per unit of length + up to 25%%)...\n",
+           rows, cols, maxWeight);
+    if (generateGeometricGridGraph(&csr, rows, cols, maxWeight, 4242, x, y)) {
+        runAStarQueries(&csr, x, y, numLandmarks, numQueries);
+        freeCSRGraph(&csr);
+    }
+    
+    free(x);
+    free(y);
+}
+
+// Contraction hierarchies
+// Vertices are contracted one at a time in order of importance. Contracting
+// v removes it from the graph; for each pair of neighbors u, w whose
+// shortest path runs through v a shortcut u-w with the combined weight is
+// added, unless a witness search finds a path u..w avoiding v that is no
+// longer. A query then only has to search upwards (towards vertices
+// contracted later) from both ends, which settles a few hundred vertices.
+
+// FNV-1a style hash over the offsets, neighbors and weights of a graph, one
+// array element per step. Stored in the index so an index file is never
+// used with a graph it was not built from.
+unsigned long long csrGraphChecksum(CSRGraph *csr) {
+    const unsigned long long prime = 1099511628211ULL;
+    unsigned long long hash = 14695981039346656037ULL;
+    
+    for (int v = 0; v <= csr->numVertices; v++) {
+        hash = (hash ^ (unsigned long long)csr->offsets[v]) * prime;
+    }
+    for (long long e = 0; e < csr->numEdges; e++) {
+        hash = (hash ^ (unsigned int)csr->neighbors[e]) * prime;
+        if (csr->weights != NULL) hash = (hash ^ (unsigned int)csr->weights[e]) * prime;
+    }
+    return hash;
+}
+
+void initContractionHierarchy(ContractionHierarchy *ch) {
+    memset(ch, 0, sizeof(ContractionHierarchy));
+}
+
+void freeContractionHierarchy(ContractionHierarchy *ch) {
+    if (ch->mapping != NULL) {
+        munmap(ch->mapping, ch->mappingSize);
+    } else {
+        free(ch->offsets);
+        free(ch->rank);
+        free(ch->target);
+        free(ch->weight);
+        free(ch->middle);
+    }
+    initContractionHierarchy(ch);
+}
+
+// Add the arc u -> vertex, or lower its weight if it exists and the new one is shorter
+bool chSetArc(CHArcList *list, int vertex, long long weight, int middle) {
+    for (int i = 0; i < list->size; i++) {
+        if (list->arcs[i].vertex == vertex) {
+            if (weight < list->arcs[i].weight) {
+                list->arcs[i].weight = weight;
+                list->arcs[i].middle = middle;
+            }
+            return true;
+        }
+    }
+    
+    if (list->size == list->capacity) {
+        int newCapacity = list->capacity > 0 ? 2 * list->capacity : 4;
+        CHArc *grown = (CHArc*)realloc(list->arcs, newCapacity * sizeof(CHArc));
+        if (grown == NULL) {
+            printf("Memory allocation failed!\n");
+            return false;
+        }
+        list->arcs = grown;
+        list->capacity = newCapacity;
+    }
+    list->arcs[list->size].vertex = vertex;
+    list->arcs[list->size].weight = weight;
+    list->arcs[list->size].middle = middle;
+    list->size++;
+    return true;
+}
+
+// Drop the arc to a contracted vertex so later searches do not scan it
+void chRemoveArc(CHArcList *list, int vertex) {
+    for (int i = 0; i < list->size; i++) {
+        if (list->arcs[i].vertex == vertex) {
+            list->arcs[i] = list->arcs[--list->size];
+            return;
+        }
+    }
+}
+
+bool initCHBuilder(CHBuilder *builder, CSRGraph *csr) {
+    int n = csr->numVertices;
+    int size = n > 0 ? n : 1;
+    
+    memset(builder, 0, sizeof(CHBuilder));
+    builder->numVertices = n;
+    builder->adjacency = (CHArcList*)calloc(size, sizeof(CHArcList));
+    builder->contracted = (bool*)calloc(size, sizeof(bool));
+    builder->deletedNeighbors = (int*)calloc(size, sizeof(int));
+    builder->distance = (long long*)malloc(size * sizeof(long long));
+    builder->touched = (int*)malloc(size * sizeof(int));
+    if (builder->adjacency == NULL || builder->contracted == NULL ||
+        builder->deletedNeighbors == NULL || builder->distance == NULL ||
+        builder->touched == NULL || !initIndexedHeap(&builder->heap, n, 4)) {
+        printf("Memory allocation failed!\n");
+        freeCHBuilder(builder);
+        return false;
+    }
+    
+    for (int u = 0; u < n; u++) {
+        builder->distance[u] = INF;
+        for (long long e = csr->offsets[u]; e < csr->offsets[u + 1]; e++) {
+            if (csr->neighbors[e] == u) continue;
+            if (!chSetArc(&builder->adjacency[u], csr->neighbors[e], csr->weights[e], -1)) {
+                freeCHBuilder(builder);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void freeCHBuilder(CHBuilder *builder) {
+    if (builder->adjacency != NULL) {
+        for (int v = 0; v < builder->numVertices; v++) {
+            free(builder->adjacency[v].arcs);
+        }
+    }
+    free(builder->adjacency);
+    free(builder->contracted);
+    free(builder->deletedNeighbors);
+    free(builder->distance);
+    free(builder->touched);
+    freeIndexedHeap(&builder->heap);
+    builder->adjacency = NULL;
+    builder->contracted = NULL;
+    builder->deletedNeighbors = builder->touched = NULL;
+    builder->distance = NULL;
+}
+
+// Dijkstra from source in the remaining graph without excluded, stopping at
+// distance limit or after CH_WITNESS_SETTLE_LIMIT vertices
+void chWitnessSearch(CHBuilder *builder, int source, int excluded, long long limit) {
+    IndexedHeap *heap = &builder->heap;
+    
+    for (int i = 0; i < builder->numTouched; i++) {
+        builder->distance[builder->touched[i]] = INF;
+    }
+    for (int i = 0; i < heap->size; i++) {
+        heap->position[heap->vertex[i]] = -1;
+    }
+    heap->size = 0;
+    builder->numTouched = 0;
+    
+    builder->distance[source] = 0;
+    builder->touched[builder->numTouched++] = source;
+    indexedHeapPushOrDecrease(heap, source, 0);
+    
+    int settled = 0;
+    while (heap->size > 0 && heap->key[0] <= limit && settled < CH_WITNESS_SETTLE_LIMIT) {
+        int u = indexedHeapPopMin(heap);
+        long long du = builder->distance[u];
+        settled++;
+        
+        CHArcList *list = &builder->adjacency[u];
+        for (int i = 0; i < list->size; i++) {
+            int v = list->arcs[i].vertex;
+            if (v == excluded || builder->contracted[v]) continue;
+            long long candidate = du + list->arcs[i].weight;
+            if (candidate < builder->distance[v]) {
+                if (builder->distance[v] == INF) {
+                    builder->touched[builder->numTouched++] = v;
+                }
+                builder->distance[v] = candidate;
+                indexedHeapPushOrDecrease(heap, v, candidate);
+            }
+        }
+    }
+}
+
+// Contract v, or with simulate only count the shortcuts it would need.
+// Returns the number of shortcuts, -1 on allocation failure.
+int chContract(CHBuilder *builder, int v, bool simulate) {
+    CHArcList *list = &builder->adjacency[v];
+    int shortcuts = 0;
+    
+    for (int i = 0; i < list->size; i++) {
+        int u = list->arcs[i].vertex;
+        if (builder->contracted[u]) continue;
+        
+        // Longest path through v to a later neighbor bounds the witness search
+        long long maxOut = -1;
+        for (int j = i + 1; j < list->size; j++) {
+            if (!builder->contracted[list->arcs[j].vertex] && list->arcs[j].weight > maxOut) {
+                maxOut = list->arcs[j].weight;
+            }
+        }
+        if (maxOut < 0) continue;
+        
+        long long weightIn = list->arcs[i].weight;
+        chWitnessSearch(builder, u, v, weightIn + maxOut);
+        
+        for (int j = i + 1; j < list->size; j++) {
+            int w = list->arcs[j].vertex;
+            if (builder->contracted[w]) continue;
+            long long via = weightIn + list->arcs[j].weight;
+            if (builder->distance[w] <= via) continue; // witness found
+            
+            shortcuts++;
+            if (!simulate) {
+                if (!chSetArc(&builder->adjacency[u], w, via, v) ||
+                    !chSetArc(&builder->adjacency[w], u, via, v)) {
+                    return -1;
+                }
+            }
+        }
+    }
+    return shortcuts;
+}
+
+// Priority of v: edge difference (shortcuts added minus arcs removed, with
+// shortcuts counted twice, which gave fewer shortcuts on grid graphs) plus
+// the number of contracted neighbors, which spreads contraction evenly
+int chPriority(CHBuilder *builder, int v) {
+    int degree = builder->adjacency[v].size;
+    return 2 * chContract(builder, v, true) - degree + builder->deletedNeighbors[v];
+}
+
+// Contract all vertices in order of priority and collect the upward arcs.
+// Priorities are updated lazily: a popped vertex is re-evaluated and pushed
+// back if it is no longer the minimum; neighbors of a contracted vertex are
+// re-evaluated immediately.
+bool buildContractionHierarchy(ContractionHierarchy *ch, CSRGraph *csr) {
+    CHBuilder builder;
+    LazyHeap queue;
+    int n = csr->numVertices;
+    
+    initContractionHierarchy(ch);
+    if (!initCHBuilder(&builder, csr)) return false;
+    int *priority = (int*)malloc((n > 0 ? n : 1) * sizeof(int));
+    ch->rank = (int*)malloc((n > 0 ? n : 1) * sizeof(int));
+    ch->offsets = (long long*)calloc(n + 1, sizeof(long long));
+    if (priority == NULL || ch->rank == NULL || ch->offsets == NULL || !initLazyHeap(&queue, n)) {
+        printf("Memory allocation failed!\n");
+        free(priority);
+        freeCHBuilder(&builder);
+        freeContractionHierarchy(ch);
+        return false;
+    }
+    ch->numVertices = n;
+    ch->graphArcs = csr->numEdges;
+    ch->graphChecksum = csrGraphChecksum(csr);
+    
+    for (int v = 0; v < n; v++) {
+        priority[v] = chPriority(&builder, v);
+        lazyHeapPush(&queue, priority[v], v);
+    }
+    
+    bool ok = true;
+    int order = 0;
+    while (ok && queue.size > 0) {
+        HeapEntry top = lazyHeapPop(&queue);
+        int v = top.vertex;
+        if (builder.contracted[v] || top.key != priority[v]) continue; // stale entry
+        
+        int current = chPriority(&builder, v);
+        if (current > priority[v] && queue.size > 0 && current > queue.entries[0].key) {
+            priority[v] = current;
+            ok = lazyHeapPush(&queue, current, v);
+            continue;
+        }
+        
+        ch->rank[v] = order++;
+        if (chContract(&builder, v, false) < 0) {
+            ok = false;
+            break;
+        }
+        builder.contracted[v] = true;
+        
+        CHArcList *list = &builder.adjacency[v];
+        for (int i = 0; ok && i < list->size; i++) {
+            int u = list->arcs[i].vertex;
+            if (builder.contracted[u]) continue;
+            chRemoveArc(&builder.adjacency[u], v);
+            builder.deletedNeighbors[u]++;
+            priority[u] = chPriority(&builder, u);
+            ok = lazyHeapPush(&queue, priority[u], u);
+        }
+    }
+    freeLazyHeap(&queue);
+    free(priority);
+    
+    // Arcs to higher ranked vertices never change after a vertex is contracted
+    if (ok) {
+        for (int v = 0; v < n; v++) {
+            CHArcList *list = &builder.adjacency[v];
+            for (int i = 0; i < list->size; i++) {
+                if (ch->rank[list->arcs[i].vertex] > ch->rank[v]) ch->offsets[v + 1]++;
+            }
+        }
+        for (int v = 0; v < n; v++) {
+            ch->offsets[v + 1] += ch->offsets[v];
+        }
+        ch->numArcs = ch->offsets[n];
+        
+        long long size = ch->numArcs > 0 ? ch->numArcs : 1;
+        ch->target = (int*)malloc(size * sizeof(int));
+        ch->weight = (long long*)malloc(size * sizeof(long long));
+        ch->middle = (int*)malloc(size * sizeof(int));
+        ok = ch->target != NULL && ch->weight != NULL && ch->middle != NULL;
+        if (!ok) printf("Memory allocation failed!\n");
+    }
+    if (ok) {
+        for (int v = 0; v < n; v++) {
+            long long e = ch->offsets[v];
+            CHArcList *list = &builder.adjacency[v];
+            for (int i = 0; i < list->size; i++) {
+                if (ch->rank[list->arcs[i].vertex] <= ch->rank[v]) continue;
+                ch->target[e] = list->arcs[i].vertex;
+                ch->weight[e] = list->arcs[i].weight;
+                ch->middle[e] = list->arcs[i].middle;
+                if (list->arcs[i].middle != -1) ch->numShortcuts++;
+                e++;
+            }
+        }
+    }
+    
+    freeCHBuilder(&builder);
+    if (!ok) freeContractionHierarchy(ch);
+    return ok;
+}
+
+// Bytes of the serialized index
+long long contractionHierarchySize(ContractionHierarchy *ch) {
+    return (long long)sizeof(CHFileHeader) + (ch->numVertices + 1LL) * sizeof(long long) +
+           ch->numArcs * sizeof(long long) + (long long)ch->numVertices * sizeof(int) +
+           2 * ch->numArcs * sizeof(int);
+}
+
+bool saveContractionHierarchy(ContractionHierarchy *ch, const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        printf("Cannot open file %s for writing!\n", path);
+        return false;
+    }
+    
+    CHFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CH_FILE_MAGIC, sizeof(header.magic));
+    header.version = CH_FILE_VERSION;
+    header.numVertices = ch->numVertices;
+    header.numArcs = ch->numArcs;
+    header.numShortcuts = ch->numShortcuts;
+    header.graphArcs = ch->graphArcs;
+    header.graphChecksum = ch->graphChecksum;
+    
+    size_t m = (size_t)ch->numArcs;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(ch->offsets, sizeof(long long), ch->numVertices + 1, file) ==
+                  (size_t)ch->numVertices + 1 &&
+              fwrite(ch->weight, sizeof(long long), m, file) == m &&
+              fwrite(ch->rank, sizeof(int), ch->numVertices, file) == (size_t)ch->numVertices &&
+              fwrite(ch->target, sizeof(int), m, file) == m &&
+              fwrite(ch->middle, sizeof(int), m, file) == m;
+    
+    if (fclose(file) != 0) ok = false;
+    if (!ok) {
+        printf("Error writing file %s!\n", path);
+    }
+    return ok;
+}
+
+// Structure of a mapped index: offsets start at 0, never decrease and end at
+// numArcs, rank is a permutation, every arc leads to a higher ranked vertex
+// with a non-negative weight, and a shortcut bypasses a vertex ranked below
+// both ends. Queries and chUnpackPath() rely on all of it.
+bool validContractionHierarchy(ContractionHierarchy *ch) {
+    int n = ch->numVertices;
+    if (ch->offsets[0] != 0 || ch->offsets[n] != ch->numArcs) return false;
+    
+    bool *seen = (bool*)calloc(n > 0 ? n : 1, sizeof(bool));
+    if (seen == NULL) {
+        printf("Memory allocation failed!\n");
+        return false;
+    }
+    bool valid = true;
+    for (int v = 0; valid && v < n; v++) {
+        int r = ch->rank[v];
+        valid = ch->offsets[v + 1] >= ch->offsets[v] && r >= 0 && r < n && !seen[r];
+        if (valid) seen[r] = true;
+    }
+    free(seen);
+    
+    for (int v = 0; valid && v < n; v++) {
+        for (long long e = ch->offsets[v]; valid && e < ch->offsets[v + 1]; e++) {
+            int w = ch->target[e];
+            int m = ch->middle[e];
+            valid = w >= 0 && w < n && ch->rank[w] > ch->rank[v] && ch->weight[e] >= 0 &&
+                    (m == -1 || (m >= 0 && m < n && ch->rank[m] < ch->rank[v]));
+        }
+    }
+    return valid;
+}
+
+// Map an index file and use its arrays in place (zero copy). The file must
+// have been built from csr: its vertex and arc counts and checksum are
+// compared with the fingerprint in the header.
+bool loadContractionHierarchy(ContractionHierarchy *ch, const char *path, CSRGraph *csr) {
+    initContractionHierarchy(ch);
+    
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Cannot open file %s!\n", path);
+        return false;
+    }
+    
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(CHFileHeader)) {
+        printf("Invalid index file %s!\n", path);
+        close(fd);
+        return false;
+    }
+    
+    size_t size = (size_t)info.st_size;
+    void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        printf("Cannot map file %s!\n", path);
+        return false;
+    }
+    
+    CHFileHeader *header = (CHFileHeader*)mapping;
+    bool valid = memcmp(header->magic, CH_FILE_MAGIC, sizeof(header->magic)) == 0 &&
+                 header->version == CH_FILE_VERSION &&
+                 header->numVertices >= 0 && header->numVertices < INT_MAX &&
+                 header->numArcs >= 0;
+    if (valid) {
+        // Compare the arc count with the bytes left instead of multiplying
+        // it out, which a corrupt count could overflow
+        size_t remaining = size - sizeof(CHFileHeader);
+        size_t vertexBytes = ((size_t)header->numVertices + 1) * sizeof(long long) +
+                             (size_t)header->numVertices * sizeof(int);
+        size_t arcBytes = sizeof(long long) + 2 * sizeof(int);
+        valid = vertexBytes <= remaining &&
+                (size_t)header->numArcs <= (remaining - vertexBytes) / arcBytes &&
+                (size_t)header->numArcs * arcBytes == remaining - vertexBytes;
+    }
+    if (valid) {
+        char *base = (char*)mapping + sizeof(CHFileHeader);
+        ch->numVertices = (int)header->numVertices;
+        ch->numArcs = header->numArcs;
+        ch->numShortcuts = header->numShortcuts;
+        ch->offsets = (long long*)base;
+        ch->weight = ch->offsets + header->numVertices + 1;
+        ch->rank = (int*)(ch->weight + header->numArcs);
+        ch->target = ch->rank + header->numVertices;
+        ch->middle = ch->target + header->numArcs;
+        valid = validContractionHierarchy(ch);
+    }
+    if (!valid) {
+        printf("Invalid or unsupported index file %s!\n", path);
+        munmap(mapping, size);
+        initContractionHierarchy(ch);
+        return false;
+    }
+    
+    if (header->numVertices != csr->numVertices || header->graphArcs != csr->numEdges ||
+        header->graphChecksum != csrGraphChecksum(csr)) {
+        printf("Index file %s was built from a different graph!\n", path);
+        munmap(mapping, size);
+        initContractionHierarchy(ch);
+        return false;
+    }
+    
+    ch->graphArcs = header->graphArcs;
+    ch->graphChecksum = header->graphChecksum;
+    ch->mapping = mapping;
+    ch->mappingSize = size;
+    return true;
+}
+
+// Bidirectional upward search
+// Both sides only relax upward arcs, so they meet at the highest ranked
+// vertex of the shortest path. Unlike dijkstraBidirectional() a side may
+// only stop once its own queue minimum reaches the best path found.
+long long chQuery(ContractionHierarchy *ch, int source, int target, PathQuery *query) {
+    double start = getTimeSeconds();
+    DijkstraStats stats = {0};
+    long long best = INF;
+    
+    resetPathQuery(query);
+    query->source = source;
+    query->target = target;
+    pathQueryReach(query, 0, source, 0, -1);
+    pathQueryReach(query, 1, target, 0, -1);
+    if (source == target) {
+        best = 0;
+        query->meeting = source;
+    }
+    indexedHeapPushOrDecrease(&query->heap[0], source, 0);
+    indexedHeapPushOrDecrease(&query->heap[1], target, 0);
+    stats.pushes += 2;
+    
+    while (query->heap[0].size > 0 || query->heap[1].size > 0) {
+        int side;
+        if (query->heap[1].size == 0) {
+            side = 0;
+        } else if (query->heap[0].size == 0) {
+            side = 1;
+        } else {
+            side = query->heap[0].key[0] <= query->heap[1].key[0] ? 0 : 1;
+        }
+        if (query->heap[side].key[0] >= best) break;
+        
+        int other = 1 - side;
+        IndexedHeap *heap = &query->heap[side];
+        long long *distance = query->distance[side];
+        int u = indexedHeapPopMin(heap);
+        long long du = distance[u];
+        stats.pops++;
+        stats.settled++;
+        TRACE_SETTLE(stats.settled, u, du);
+        
+        for (long long e = ch->offsets[u]; e < ch->offsets[u + 1]; e++) {
+            int v = ch->target[e];
+            long long candidate = du + ch->weight[e];
+            stats.relaxations++;
+            if (candidate < distance[v]) {
+                stats.successfulRelaxations++;
+                if (heap->position[v] == -1) {
+                    stats.pushes++;
+                } else {
+                    stats.decreaseKeys++;
+                }
+                TRACE_RELAX(v, candidate, u);
+                pathQueryReach(query, side, v, candidate, u);
+                indexedHeapPushOrDecrease(heap, v, candidate);
+                
+                if (query->distance[other][v] != INF &&
+                    candidate + query->distance[other][v] < best) {
+                    best = candidate + query->distance[other][v];
+                    query->meeting = v;
+                }
+            }
+        }
+    }
+    
+    query->pathDistance = best;
+    stats.wallTime = getTimeSeconds() - start;
+    query->stats = stats;
+    return query->pathDistance;
+}
+
+// Index of the arc between a and b, stored at the lower ranked of the two
+long long chFindArc(ContractionHierarchy *ch, int a, int b) {
+    int low = ch->rank[a] < ch->rank[b] ? a : b;
+    int high = low == a ? b : a;
+    for (long long e = ch->offsets[low]; e < ch->offsets[low + 1]; e++) {
+        if (ch->target[e] == high) return e;
+    }
+    return -1;
+}
+
+// Path of the last chQuery() in original edges, written to path[] (room for
+// numVertices entries). Shortcuts are expanded with an explicit stack: a
+// shortcut a-b with middle m is replaced by the arcs a-m and m-b, both
+// stored at m since m was contracted before a and b. Returns the length.
+int chUnpackPath(ContractionHierarchy *ch, PathQuery *query, int *path) {
+    int n = ch->numVertices;
+    int *packed = (int*)malloc((n > 0 ? n : 1) * sizeof(int));
+    int *stack = (int*)malloc((n > 0 ? 2 * n : 2) * sizeof(int));
+    if (packed == NULL || stack == NULL) {
+        printf("Memory allocation failed!\n");
+        free(packed);
+        free(stack);
+        return 0;
+    }
+    
+    int packedLength = queryPath(query, packed);
+    int length = 0;
+    int top = 0;
+    if (packedLength > 0) path[length++] = packed[0];
+    
+    // Push in reverse so the first arc is expanded first
+    for (int i = packedLength - 1; i > 0; i--) {
+        stack[top++] = packed[i - 1];
+        stack[top++] = packed[i];
+    }
+    
+    // Every stacked arc becomes at least one arc of a simple path, so at most
+    // n - 1 are stacked; only an inconsistent index can exceed the arrays,
+    // and then no path is returned
+    while (top > 0) {
+        int b = stack[--top];
+        int a = stack[--top];
+        long long e = chFindArc(ch, a, b);
+        if (e < 0 || ch->middle[e] == -1) {
+            if (length == n) {
+                length = 0;
+                break;
+            }
+            path[length++] = b;
+        } else if (top + 4 > 2 * n) {
+            length = 0;
+            break;
+        } else {
+            int m = ch->middle[e];
+            stack[top++] = m;
+            stack[top++] = b;
+            stack[top++] = a;
+            stack[top++] = m;
+        }
+    }
+    
+    free(packed);
+    free(stack);
+    return length;
+}
+
+// Build, save, reload (mmap) and query a contraction hierarchy of a grid
+// graph, comparing query latency with bidirectional Dijkstra
+void benchmarkContractionHierarchy(int rows, int cols, int maxWeight, const char *indexPath,
+                                   int numQueries) {
+    CSRGraph csr;
+    ContractionHierarchy ch;
+    PathQuery query;
+    double dijkstraTime = 0.0, chTime = 0.0;
+    long long dijkstraSettled = 0, chSettled = 0;
+    bool ok = true;
+    int *path;
+    
+    printf("\nGenerating %d x %d grid graph (weights 1..%d)...\n", rows, cols, maxWeight);
+    if (!generateGridGraph(&csr, rows, cols, maxWeight, 4242)) {
+        return;
+    }
+    
+    double start = getTimeSeconds();
+    if (!buildContractionHierarchy(&ch, &csr)) {
+        freeCSRGraph(&csr);
+        return;
+    }
+    double buildTime = getTimeSeconds() - start;
+    printf("Preprocessing: %.3f seconds\n", buildTime);
+    printf("Original arcs: %lld, upward arcs: %lld (%lld shortcuts)\n",
+           csr.numEdges / 2, ch.numArcs, ch.numShortcuts);
+    
+    bool saved = saveContractionHierarchy(&ch, indexPath);
+    freeContractionHierarchy(&ch);
+    if (!saved) {
+        freeCSRGraph(&csr);
+        return;
+    }
+    start = getTimeSeconds();
+    if (!loadContractionHierarchy(&ch, indexPath, &csr)) {
+        freeCSRGraph(&csr);
+        return;
+    }
+    printf("Index %s: %.2f MB, mapped in %.6f seconds\n", indexPath,
+           contractionHierarchySize(&ch) / 1e6, getTimeSeconds() - start);
+    
+    path = (int*)malloc(csr.numVertices * sizeof(int));
+    if (path == NULL || !initPathQuery(&query, csr.numVertices)) {
+        free(path);
+        freeContractionHierarchy(&ch);
+        freeCSRGraph(&csr);
+        return;
+    }
+    
+    unsigned long long state = 777;
+    for (int q = 0; q < numQueries; q++) {
+        int source = nextRandom(&state) % csr.numVertices;
+        int target = nextRandom(&state) % csr.numVertices;
+        
+        long long expected = dijkstraBidirectional(&csr, source, target, &query);
+        dijkstraTime += query.stats.wallTime;
+        dijkstraSettled += query.stats.settled;
+        
+        long long distance = chQuery(&ch, source, target, &query);
+        chTime += query.stats.wallTime;
+        chSettled += query.stats.settled;
+        
+        int length = chUnpackPath(&ch, &query, path);
+        if (distance != expected || !checkPath(&csr, source, target, distance, path, length)) {
+            ok = false;
+        }
+    }
+    
+    printf("%d queries\n", numQueries);
+    printf("Method\t\t\tAvg latency(us)\tAvg settled\n");
+    printf("Bidirectional Dijkstra\t%.1f\t\t%lld\n", 1e6 * dijkstraTime / numQueries,
+           dijkstraSettled / numQueries);
+    printf("Contraction hierarchy\t%.1f\t\t%lld\n", 1e6 * chTime / numQueries,
+           chSettled / numQueries);
+    printf("Speedup: %.1fx, distances and unpacked paths %s\n",
+           chTime > 0 ? dijkstraTime / chTime : 0.0, ok ? "match Dijkstra" : "MISMATCH");
+    
+    free(path);
+    freePathQuery(&query);
+    freeContractionHierarchy(&ch);
+    freeCSRGraph(&csr);
+}
+
+// Build a contraction hierarchy of csr and answer one query with it,
+// printing the preprocessing time, the distance and the unpacked path
+bool queryContractionHierarchy(CSRGraph *csr, int source, int target, PathQuery *query) {
+    ContractionHierarchy ch;
+    int *path = (int*)malloc((csr->numVertices > 0 ? csr->numVertices : 1) * sizeof(int));
+    if (path == NULL) {
+        printf("Memory allocation failed!\n");
+        return false;
+    }
+    
+    double start = getTimeSeconds();
+    if (!buildContractionHierarchy(&ch, csr)) {
+        free(path);
+        return false;
+    }
+    printf("Preprocessing: %.3f seconds (%lld shortcuts)\n", getTimeSeconds() - start,
+           ch.numShortcuts);
+    
+    long long distance = chQuery(&ch, source, target, query);
+    if (distance == INF) {
+        printf("No path from %d to %d\n", source, target);
+    } else {
+        printf("Distance from %d to %d: %lld\nPath: ", source, target, distance);
+        printPathArray(path, chUnpackPath(&ch, query, path));
+        printf("\n");
+    }
+    displayDijkstraStats(&query->stats);
+    
+    free(path);
+    freeContractionHierarchy(&ch);
+    return true;
+}
+
+// Many-to-many distance tables
+// Each source is an independent Dijkstra that stops once every target is
+// settled. Worker threads claim sources from a shared counter, so threads
+// finishing early take more sources, and each keeps one PathQuery workspace
+// whose touched list makes the reset between sources proportional to the
+// previous search instead of V.
+
+// Dijkstra from source until all numTargets distinct target vertices are settled
+void dijkstraToTargets(CSRGraph *csr, int source, const bool *isTarget, int numTargets,
+                       PathQuery *query) {
+    double start = getTimeSeconds();
+    DijkstraStats stats = {0};
+    IndexedHeap *heap = &query->heap[0];
+    long long *distance = query->distance[0];
+    int remaining = numTargets;
+    
+    resetPathQuery(query);
+    query->source = source;
+    pathQueryReach(query, 0, source, 0, -1);
+    indexedHeapPushOrDecrease(heap, source, 0);
+    stats.pushes++;
+    
+    while (heap->size > 0 && remaining > 0) {
+        int u = indexedHeapPopMin(heap);
+        long long du = distance[u];
+        stats.pops++;
+        stats.settled++;
+        if (isTarget[u]) remaining--;
+        
+        for (long long e = csr->offsets[u]; e < csr->offsets[u + 1]; e++) {
+            int v = csr->neighbors[e];
+            long long candidate = addPathLength(du, csr->weights[e]);
+            stats.relaxations++;
+            if (candidate < distance[v]) {
+                stats.successfulRelaxations++;
+                if (heap->position[v] == -1) {
+                    stats.pushes++;
+                } else {
+                    stats.decreaseKeys++;
+                }
+                pathQueryReach(query, 0, v, candidate, u);
+                indexedHeapPushOrDecrease(heap, v, candidate);
+            }
+        }
+    }
+    
+    stats.wallTime = getTimeSeconds() - start;
+    query->stats = stats;
+}
+
+void *manyToManyWorker(void *arg) {
+    ManyToManyWorker *worker = (ManyToManyWorker*)arg;
+    ManyToManyContext *ctx = worker->context;
+    
+    while (1) {
+        int i = __atomic_fetch_add(&ctx->nextSource, 1, __ATOMIC_RELAXED);
+        if (i >= ctx->numSources) break;
+        
+        dijkstraToTargets(ctx->csr, ctx->sources[i], ctx->isTarget, ctx->numDistinctTargets,
+                          &worker->query);
+        worker->settled += worker->query.stats.settled;
+        
+        // Targets are settled (final) or were never reached (INF)
+        long long *row = ctx->matrix + (long long)i * ctx->numTargets;
+        for (int j = 0; j < ctx->numTargets; j++) {
+            row[j] = worker->query.distance[0][ctx->targets[j]];
+        }
+    }
+    return NULL;
+}
+
+// Distances from every source to every target into matrix (numSources x
+// numTargets, row-major, INF if unreachable). Returns false if memory runs out.
+bool manyToManyDistances(CSRGraph *csr, const int *sources, int numSources,
+                         const int *targets, int numTargets, int numThreads, long long *matrix,
+                         long long *settledTotal) {
+    pthread_t threads[MAX_THREADS];
+    ManyToManyWorker workers[MAX_THREADS];
+    ManyToManyContext ctx;
+    bool ok = true;
+    
+    if (numThreads < 1) numThreads = 1;
+    if (numThreads > MAX_THREADS) numThreads = MAX_THREADS;
+    if (numThreads > numSources) numThreads = numSources > 0 ? numSources : 1;
+    
+    bool *isTarget = (bool*)calloc(csr->numVertices > 0 ? csr->numVertices : 1, sizeof(bool));
+    if (isTarget == NULL) {
+        printf("Memory allocation failed!\n");
+        return false;
+    }
+    
+    ctx.csr = csr;
+    ctx.sources = sources;
+    ctx.numSources = numSources;
+    ctx.targets = targets;
+    ctx.numTargets = numTargets;
+    ctx.isTarget = isTarget;
+    ctx.numDistinctTargets = 0;
+    ctx.matrix = matrix;
+    ctx.nextSource = 0;
+    for (int j = 0; j < numTargets; j++) {
+        if (!isTarget[targets[j]]) {
+            isTarget[targets[j]] = true;
+            ctx.numDistinctTargets++;
+        }
+    }
+    
+    int numWorkers = 0;
+    for (int t = 0; t < numThreads; t++) {
+        workers[t].context = &ctx;
+        workers[t].settled = 0;
+        if (!initPathQuery(&workers[t].query, csr->numVertices)) {
+            ok = false;
+            break;
+        }
+        numWorkers++;
+    }
+    
+    if (ok) {
+        // The calling thread is worker 0. Sources are claimed dynamically,
+        // so if a thread cannot be created the ones running take its share
+        int running = 1;
+        while (running < numWorkers &&
+               pthread_create(&threads[running], NULL, manyToManyWorker,
+                              &workers[running]) == 0) {
+            running++;
+        }
+        if (running < numWorkers) {
+            printf("Could only start %d of %d threads\n", running, numWorkers);
+        }
+        manyToManyWorker(&workers[0]);
+        for (int t = 1; t < running; t++) {
+            pthread_join(threads[t], NULL);
+        }
+    }
+    
+    if (settledTotal != NULL) *settledTotal = 0;
+    for (int t = 0; t < numWorkers; t++) {
+        if (settledTotal != NULL) *settledTotal += workers[t].settled;
+        freePathQuery(&workers[t].query);
+    }
+    free(isTarget);
+    return ok;
+}
+
+// Print the many-to-many distance table between the given vertices
+bool displayDistanceTable(CSRGraph *csr, const int *sources, int numSources,
+                          const int *targets, int numTargets, int numThreads) {
+    for (int i = 0; i < numSources + numTargets; i++) {
+        int v = i < numSources ? sources[i] : targets[i - numSources];
+        if (v < 0 || v >= csr->numVertices) {
+            printf("Invalid vertex %d!\n", v);
+            return false;
+        }
+    }
+    
+    long long *matrix = (long long*)malloc((size_t)numSources * numTargets * sizeof(long long));
+    if (matrix == NULL) {
+        printf("Memory allocation failed!\n");
+        return false;
+    }
+    long long settled = 0;
+    double start = getTimeSeconds();
+    bool ok = manyToManyDistances(csr, sources, numSources, targets, numTargets, numThreads,
+                                  matrix, &settled);
+    double elapsed = getTimeSeconds() - start;
+    
+    if (ok) {
+        printf("From\\To");
+        for (int j = 0; j < numTargets; j++) printf("\t%d", targets[j]);
+        printf("\n");
+        for (int i = 0; i < numSources; i++) {
+            printf("%d", sources[i]);
+            for (int j = 0; j < numTargets; j++) {
+                long long d = matrix[(long long)i * numTargets + j];
+                if (d == INF) {
+                    printf("\tINF");
+                } else {
+                    printf("\t%lld", d);
+                }
+            }
+            printf("\n");
+        }
+        printf("%d x %d table in %.6f s, %lld vertices settled\n", numSources, numTargets,
+               elapsed, settled);
+    }
+    free(matrix);
+    return ok;
+}
+
+// Floyd-Warshall on a dense n x n matrix
+// The matrix holds int distances so the inner loop runs on 32-bit lanes;
+// INT_MAX marks a missing path. Entries use FW_INF = INT_MAX / 2 for missing
+// paths while running, so the sum of two never overflows and the inner loop
+// needs no branch; distances must stay below FW_INF. INT_MAX is restored at
+// the end.
+
+#define FW_INF (INT_MAX / 2)
+
+// Dense distance matrix of a CSR graph: 0 on the diagonal, edge weights, INT_MAX elsewhere
+bool denseDistanceMatrix(CSRGraph *csr, int **matrix) {
+    int n = csr->numVertices;
+    *matrix = (int*)malloc(((long long)n * n > 0 ? (long long)n * n : 1) * sizeof(int));
+    if (*matrix == NULL) {
+        printf("Memory allocation failed!\n");
+        return false;
+    }
+    
+    for (long long i = 0; i < (long long)n * n; i++) {
+        (*matrix)[i] = INT_MAX;
+    }
+    for (int u = 0; u < n; u++) {
+        (*matrix)[(long long)u * n + u] = 0;
+        for (long long e = csr->offsets[u]; e < csr->offsets[u + 1]; e++) {
+            int *entry = &(*matrix)[(long long)u * n + csr->neighbors[e]];
+            if (csr->weights[e] < *entry) *entry = csr->weights[e];
+        }
+    }
+    return true;
+}
+
+// row[j] = min(row[j], dik + rowK[j]) for begin <= j < end. Row k itself
+// never changes in round k (dist[k][k] is 0), so callers skip i == k and the
+// rows never alias. GCC's -O2 cost model only vectorizes loops that need no
+// scalar epilogue, so the row is done in FW_RELAX_WIDTH wide pieces (a
+// constant trip count that becomes straight vector code) and a short tail.
+void floydWarshallRelaxRow(int *restrict row, const int *restrict rowK, int dik,
+                           int begin, int end) {
+    int j = begin;
+    for (; j + FW_RELAX_WIDTH <= end; j += FW_RELAX_WIDTH) {
+        for (int t = 0; t < FW_RELAX_WIDTH; t++) {
+            int through = dik + rowK[j + t];
+            row[j + t] = through < row[j + t] ? through : row[j + t];
+        }
+    }
+    for (; j < end; j++) {
+        int through = dik + rowK[j];
+        row[j] = through < row[j] ? through : row[j];
+    }
+}
+
+void floydWarshallEnter(int *dist, int n) {
+    for (long long i = 0; i < (long long)n * n; i++) {
+        if (dist[i] > FW_INF) dist[i] = FW_INF;
+    }
+}
+
+void floydWarshallLeave(int *dist, int n) {
+    for (long long i = 0; i < (long long)n * n; i++) {
+        if (dist[i] >= FW_INF) dist[i] = INT_MAX;
+    }
+}
+
+// Textbook triple loop, the reference for the blocked version
+void floydWarshall(int *dist, int n) {
+    floydWarshallEnter(dist, n);
+    for (int k = 0; k < n; k++) {
+        const int *rowK = dist + (long long)k * n;
+        for (int i = 0; i < n; i++) {
+            if (i == k) continue;
+            int *rowI = dist + (long long)i * n;
+            floydWarshallRelaxRow(rowI, rowK, rowI[k], 0, n);
+        }
+    }
+    floydWarshallLeave(dist, n);
+}
+
+// Relax block (bi, bj) through the k values of block bk
+void floydWarshallBlock(int *dist, int n, int bi, int bj, int bk) {
+    int iEnd = bi + FW_BLOCK < n ? bi + FW_BLOCK : n;
+    int jEnd = bj + FW_BLOCK < n ? bj + FW_BLOCK : n;
+    int kEnd = bk + FW_BLOCK < n ? bk + FW_BLOCK : n;
+    
+    for (int k = bk; k < kEnd; k++) {
+        const int *rowK = dist + (long long)k * n;
+        for (int i = bi; i < iEnd; i++) {
+            if (i == k) continue;
+            int *rowI = dist + (long long)i * n;
+            floydWarshallRelaxRow(rowI, rowK, rowI[k], bj, jEnd);
+        }
+    }
+}
+
+// Blocked Floyd-Warshall
+// For each diagonal block k: (1) close the diagonal block itself, (2) the
+// blocks in its row and column, which only depend on it, (3) all other
+// blocks from their row and column blocks. Each phase works on three
+// FW_BLOCK x FW_BLOCK tiles that stay in cache.
+void floydWarshallBlocked(int *dist, int n) {
+    floydWarshallEnter(dist, n);
+    for (int bk = 0; bk < n; bk += FW_BLOCK) {
+        floydWarshallBlock(dist, n, bk, bk, bk);
+        
+        for (int b = 0; b < n; b += FW_BLOCK) {
+            if (b == bk) continue;
+            floydWarshallBlock(dist, n, bk, b, bk);
+            floydWarshallBlock(dist, n, b, bk, bk);
+        }
+        
+        for (int bi = 0; bi < n; bi += FW_BLOCK) {
+            if (bi == bk) continue;
+            for (int bj = 0; bj < n; bj += FW_BLOCK) {
+                if (bj == bk) continue;
+                floydWarshallBlock(dist, n, bi, bj, bk);
+            }
+        }
+    }
+    floydWarshallLeave(dist, n);
+}
+
+// Time many-to-many tables for 1, 2, 4, ... threads on a grid graph
+void benchmarkManyToMany(int rows, int cols, int maxWeight, int numSources, int numTargets,
+                         int maxThreads) {
+    CSRGraph csr;
+    
+    printf("\nGenerating %d x %d grid graph (weights 1..%d)...\n", rows, cols, maxWeight);
+    if (!generateGridGraph(&csr, rows, cols, maxWeight, 4242)) {
+        return;
+    }
+    
+    int *sources = (int*)malloc(numSources * sizeof(int));
+    int *targets = (int*)malloc(numTargets * sizeof(int));
+    long long *reference =
+        (long long*)malloc((long long)numSources * numTargets * sizeof(long long));
+    long long *matrix = (long long*)malloc((long long)numSources * numTargets * sizeof(long long));
+    if (sources == NULL || targets == NULL || reference == NULL || matrix == NULL) {
+        printf("Memory allocation failed!\n");
+        free(sources);
+        free(targets);
+        free(reference);
+        free(matrix);
+        freeCSRGraph(&csr);
+        return;
+    }
+    
+    unsigned long long state = 777;
+    for (int i = 0; i < numSources; i++) {
+        sources[i] = nextRandom(&state) % csr.numVertices;
+    }
+    for (int j = 0; j < numTargets; j++) {
+        targets[j] = nextRandom(&state) % csr.numVertices;
+    }
+    
+    printf("%d x %d table\n", numSources, numTargets);
+    printf("Threads\tTime(s)\t\tSpeedup\tAvg settled\tCheck\n");
+    double baseTime = 0.0;
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        long long settled = 0;
+        long long *out = threads == 1 ? reference : matrix;
+        double start = getTimeSeconds();
+        if (!manyToManyDistances(&csr, sources, numSources, targets, numTargets, threads,
+                                 out, &settled)) {
+            break;
+        }
+        double elapsed = getTimeSeconds() - start;
+        if (threads == 1) baseTime = elapsed;
+        
+        bool ok = memcmp(reference, out,
+                         (long long)numSources * numTargets * sizeof(long long)) == 0;
+        printf("%d\t%.6f\t%.2fx\t%lld\t\t%s\n", threads, elapsed,
+               elapsed > 0 ? baseTime / elapsed : 0.0, settled / numSources,
+               ok ? "OK" : "MISMATCH");
+    }
+    
+    // Spot check against independent full runs
+    ShortestPathResult full;
+    bool ok = true;
+    if (initShortestPathResult(&full, csr.numVertices)) {
+        for (int i = 0; i < numSources && i < 3; i++) {
+            dijkstraIndexedHeap(&csr, sources[i], &full, 2);
+            for (int j = 0; j < numTargets; j++) {
+                if (reference[(long long)i * numTargets + j] != full.distance[targets[j]]) ok = false;
+            }
+        }
+        printf("Rows checked against full Dijkstra: %s\n", ok ? "OK" : "MISMATCH");
+        freeShortestPathResult(&full);
+    }
+    
+    free(sources);
+    free(targets);
+    free(reference);
+    free(matrix);
+    freeCSRGraph(&csr);
+}
+
+// All-pairs table of a small grid graph: Floyd-Warshall, blocked
+// Floyd-Warshall and the many-to-many API with every vertex as source and target
+void benchmarkAllPairs(int rows, int cols, int maxWeight, int numThreads) {
+    CSRGraph csr;
+    int *reference = NULL, *blocked = NULL, *all = NULL;
+    long long *table = NULL;
+    
+    printf("\nGenerating %d x %d grid graph (weights 1..%d)...\n", rows, cols, maxWeight);
+    if (!generateGridGraph(&csr, rows, cols, maxWeight, 4242)) {
+        return;
+    }
+    int n = csr.numVertices;
+    long long cells = (long long)n * n;
+    
+    if (!denseDistanceMatrix(&csr, &reference) || !denseDistanceMatrix(&csr, &blocked)) {
+        free(reference);
+        freeCSRGraph(&csr);
+        return;
+    }
+    table = (long long*)malloc(cells * sizeof(long long));
+    all = (int*)malloc(n * sizeof(int));
+    if (table == NULL || all == NULL) {
+        printf("Memory allocation failed!\n");
+    } else {
+        for (int v = 0; v < n; v++) {
+            all[v] = v;
+        }
+        
+        double start = getTimeSeconds();
+        floydWarshall(reference, n);
+        double plainTime = getTimeSeconds() - start;
+        
+        start = getTimeSeconds();
+        floydWarshallBlocked(blocked, n);
+        double blockedTime = getTimeSeconds() - start;
+        
+        start = getTimeSeconds();
+        bool ran = manyToManyDistances(&csr, all, n, all, n, numThreads, table, NULL);
+        double tableTime = getTimeSeconds() - start;
+        
+        printf("%d vertices, %lld entries\n", n, cells);
+        printf("Method\t\t\t\tTime(s)\t\tCheck\n");
+        printf("Floyd-Warshall\t\t\t%.6f\t(reference)\n", plainTime);
+        printf("Blocked Floyd-Warshall\t\t%.6f\t%s\n", blockedTime,
+               memcmp(reference, blocked, cells * sizeof(int)) == 0 ? "OK" : "MISMATCH");
+        if (ran) {
+            bool same = true;
+            for (long long i = 0; i < cells; i++) {
+                long long expected = reference[i] == INT_MAX ? INF : reference[i];
+                if (table[i] != expected) same = false;
+            }
+            printf("Many-to-many Dijkstra (%d thr)\t%.6f\t%s\n", numThreads, tableTime,
+                   same ? "OK" : "MISMATCH");
+        }
+    }
+    
+    free(reference);
+    free(blocked);
+    free(table);
+    free(all);
+    freeCSRGraph(&csr);
+}
+
+// Delta-stepping
+// Vertices are grouped in buckets of width delta by tentative distance.
+// All vertices of the lowest non-empty bucket are removed at once and their
+// light edges (weight <= delta) relaxed in parallel; this may refill the same
+// bucket, so it repeats until the bucket stays empty. Heavy edges cannot
+// land in the current bucket and are relaxed once per removed vertex at the
+// end. Distances are lowered with compare-and-swap; improved vertices go to
+// thread-local buckets that are gathered into a shared frontier between
+// rounds, like the frontier merge of the parallel BFS in prog_5.
+// delta = 1 behaves like Dijkstra, a very large delta like Bellman-Ford.
+
+// Lower *address to value if smaller; true if this call lowered it
+bool atomicMinLongLong(long long *address, long long value) {
+    long long current = __atomic_load_n(address, __ATOMIC_RELAXED);
+    while (value < current) {
+        if (__atomic_compare_exchange_n(address, &current, value, false,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Parent of v = lowest numbered neighbor u with distance[u] + w(u,v) == distance[v].
+// With positive weights this always forms a shortest path tree, and it does
+// not depend on the order in which vertices were processed.
+void canonicalParents(CSRGraph *csr, const long long *distance, int *parent, int source,
+                      int begin, int end) {
+    for (int v = begin; v < end; v++) {
+        parent[v] = -1;
+        if (v == source || distance[v] == INF) continue;
+        for (long long e = csr->offsets[v]; e < csr->offsets[v + 1]; e++) {
+            int u = csr->neighbors[e];
+            if (distance[u] != INF && distance[u] + csr->weights[e] == distance[v] &&
+                (parent[v] == -1 || u < parent[v])) {
+                parent[v] = u;
+            }
+        }
+    }
+}
+
+bool deltaBinPush(DeltaSteppingWorker *worker, long long bin, long long key, int vertex) {
+    if (bin >= INT_MAX / 2) {
+        printf("Too many buckets for delta %d!\n", worker->ctx->delta);
+        return false;
+    }
+    if (bin >= worker->numBins) {
+        int newCount = worker->numBins > 0 ? worker->numBins : 16;
+        while (newCount <= bin) newCount *= 2;
+        Bucket *grown = (Bucket*)realloc(worker->bins, newCount * sizeof(Bucket));
+        if (grown == NULL) {
+            printf("Memory allocation failed!\n");
+            return false;
+        }
+        memset(grown + worker->numBins, 0, (newCount - worker->numBins) * sizeof(Bucket));
+        worker->bins = grown;
+        worker->numBins = newCount;
+    }
+    worker->stats.pushes++;
+    return bucketPush(&worker->bins[bin], key, vertex);
+}
+
+// Relax the light or the heavy edges of u
+void deltaRelax(DeltaSteppingWorker *worker, int u, long long du, bool light) {
+    DeltaSteppingContext *ctx = worker->ctx;
+    CSRGraph *csr = ctx->csr;
+    
+    for (long long e = csr->offsets[u]; e < csr->offsets[u + 1]; e++) {
+        int weight = csr->weights[e];
+        if ((weight <= ctx->delta) != light) continue;
+        int v = csr->neighbors[e];
+        long long candidate = addPathLength(du, weight);
+        worker->stats.relaxations++;
+        if (atomicMinLongLong(&ctx->distance[v], candidate)) {
+            worker->stats.successfulRelaxations++;
+            if (!deltaBinPush(worker, candidate / ctx->delta, candidate, v)) ctx->failed = true;
+        }
+    }
+}
+
+// Move every thread's entries of bucket bin into the shared frontier
+void deltaGather(DeltaSteppingWorker *worker, int bin) {
+    DeltaSteppingContext *ctx = worker->ctx;
+    int t = worker->id;
+    
+    ctx->binCount[t] = bin < worker->numBins ? worker->bins[bin].size : 0;
+    pthread_barrier_wait(&ctx->barrier);
+    
+    long long offset = 0, total = 0;
+    for (int k = 0; k < ctx->numThreads; k++) {
+        if (k < t) offset += ctx->binCount[k];
+        total += ctx->binCount[k];
+    }
+    if (t == 0 && total > ctx->frontierCapacity) {
+        HeapEntry *grown = (HeapEntry*)realloc(ctx->frontier, total * sizeof(HeapEntry));
+        if (grown == NULL) {
+            printf("Memory allocation failed!\n");
+            ctx->failed = true;
+        } else {
+            ctx->frontier = grown;
+            ctx->frontierCapacity = total;
+        }
+    }
+    pthread_barrier_wait(&ctx->barrier);
+    
+    if (!ctx->failed && ctx->binCount[t] > 0) {
+        memcpy(ctx->frontier + offset, worker->bins[bin].entries,
+               ctx->binCount[t] * sizeof(HeapEntry));
+    }
+    if (bin < worker->numBins) worker->bins[bin].size = 0;
+    if (t == 0) ctx->frontierSize = ctx->failed ? 0 : total;
+    pthread_barrier_wait(&ctx->barrier);
+}
+
+void *deltaSteppingWorker(void *arg) {
+    DeltaSteppingWorker *worker = (DeltaSteppingWorker*)arg;
+    DeltaSteppingContext *ctx = worker->ctx;
+    int t = worker->id;
+    int current = 0;
+    
+    // Wait until deltaStepping() knows how many threads could be started
+    while (!__atomic_load_n(&ctx->started, __ATOMIC_ACQUIRE)) sched_yield();
+    
+    while (1) {
+        // Light edges, until the current bucket is not refilled any more
+        while (ctx->frontierSize > 0) {
+            long long size = ctx->frontierSize;
+            long long begin = size * t / ctx->numThreads;
+            long long end = size * (t + 1) / ctx->numThreads;
+            
+            for (long long i = begin; i < end; i++) {
+                HeapEntry entry = ctx->frontier[i];
+                int u = entry.vertex;
+                worker->stats.pops++;
+                if (entry.key != __atomic_load_n(&ctx->distance[u], __ATOMIC_RELAXED)) continue;
+                
+                // At most one live entry per vertex and round, so no race on lastBucket
+                if (ctx->lastBucket[u] != current) {
+                    ctx->lastBucket[u] = current;
+                    worker->stats.settled++;
+                    if (worker->numRemoved == worker->removedCapacity) {
+                        int newCapacity = 2 * worker->removedCapacity;
+                        int *grown = (int*)realloc(worker->removed, newCapacity * sizeof(int));
+                        if (grown == NULL) {
+                            ctx->failed = true;
+                            continue;
+                        }
+                        worker->removed = grown;
+                        worker->removedCapacity = newCapacity;
+                    }
+                    worker->removed[worker->numRemoved++] = u;
+                }
+                deltaRelax(worker, u, entry.key, true);
+            }
+            pthread_barrier_wait(&ctx->barrier);
+            deltaGather(worker, current);
+        }
+        
+        // Heavy edges of everything removed from the bucket, with final distances
+        for (int i = 0; i < worker->numRemoved; i++) {
+            int u = worker->removed[i];
+            deltaRelax(worker, u, __atomic_load_n(&ctx->distance[u], __ATOMIC_RELAXED), false);
+        }
+        worker->numRemoved = 0;
+        
+        // Next bucket: the lowest non-empty one of any thread
+        int localMin = INT_MAX;
+        for (int b = current + 1; b < worker->numBins; b++) {
+            if (worker->bins[b].size > 0) {
+                localMin = b;
+                break;
+            }
+        }
+        ctx->binMin[t] = localMin;
+        pthread_barrier_wait(&ctx->barrier);
+        
+        int next = INT_MAX;
+        for (int k = 0; k < ctx->numThreads; k++) {
+            if (ctx->binMin[k] < next) next = ctx->binMin[k];
+        }
+        if (next == INT_MAX || ctx->failed) break;
+        current = next;
+        deltaGather(worker, current);
+    }
+    return NULL;
+}
+
+// Parallel delta-stepping from source; parents follow canonicalParents()
+bool deltaStepping(CSRGraph *csr, int source, ShortestPathResult *result, int delta,
+                   int numThreads) {
+    int n = csr->numVertices;
+    DeltaSteppingContext ctx;
+    DeltaSteppingWorker workers[MAX_THREADS];
+    pthread_t threads[MAX_THREADS];
+    bool ok = true;
     
-    for (int i = 0; i < vertices; i++) {
-        for (int j = 0; j < vertices; j++) {
-            g->adjMatrix[i][j] = 0;
+    if (numThreads < 1) numThreads = 1;
+    if (numThreads > MAX_THREADS) numThreads = MAX_THREADS;
+    if (delta < 1) delta = 1;
+    
+    double start = getTimeSeconds();
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.csr = csr;
+    ctx.distance = result->distance;
+    ctx.delta = delta;
+    ctx.numThreads = numThreads;
+    ctx.lastBucket = (int*)malloc((n > 0 ? n : 1) * sizeof(int));
+    ctx.frontierCapacity = 1024;
+    ctx.frontier = (HeapEntry*)malloc(ctx.frontierCapacity * sizeof(HeapEntry));
+    for (int t = 0; t < numThreads; t++) {
+        memset(&workers[t], 0, sizeof(DeltaSteppingWorker));
+        workers[t].ctx = &ctx;
+        workers[t].id = t;
+        workers[t].removedCapacity = 1024;
+        workers[t].removed = (int*)malloc(workers[t].removedCapacity * sizeof(int));
+        if (workers[t].removed == NULL) ok = false;
+    }
+    if (ctx.lastBucket == NULL || ctx.frontier == NULL) ok = false;
+    
+    if (ok) {
+        resetShortestPathResult(result);
+        for (int v = 0; v < n; v++) {
+            ctx.lastBucket[v] = -1;
+        }
+        result->distance[source] = 0;
+        ctx.frontier[0].key = 0;
+        ctx.frontier[0].vertex = source;
+        ctx.frontierSize = 1;
+        
+        // Threads that failed to start are left out: the barrier and the
+        // work split only count the ones running before the gate opens
+        int running = 1;
+        while (running < numThreads &&
+               pthread_create(&threads[running], NULL, deltaSteppingWorker,
+                              &workers[running]) == 0) {
+            running++;
+        }
+        if (running < numThreads) {
+            printf("Could only start %d of %d threads\n", running, numThreads);
         }
+        ctx.numThreads = running;
+        pthread_barrier_init(&ctx.barrier, NULL, running);
+        __atomic_store_n(&ctx.started, true, __ATOMIC_RELEASE);
+        
+        deltaSteppingWorker(&workers[0]);
+        for (int t = 1; t < running; t++) {
+            pthread_join(threads[t], NULL);
+        }
+        pthread_barrier_destroy(&ctx.barrier);
+        ok = !ctx.failed;
+    } else {
+        printf("Memory allocation failed!\n");
+    }
+    
+    if (ok) {
+        canonicalParents(csr, result->distance, result->parent, source, 0, n);
     }
+    
+    DijkstraStats stats = {0};
+    for (int t = 0; t < numThreads; t++) {
+        stats.pushes += workers[t].stats.pushes;
+        stats.pops += workers[t].stats.pops;
+        stats.relaxations += workers[t].stats.relaxations;
+        stats.successfulRelaxations += workers[t].stats.successfulRelaxations;
+        stats.settled += workers[t].stats.settled;
+        for (int b = 0; b < workers[t].numBins; b++) {
+            free(workers[t].bins[b].entries);
+        }
+        free(workers[t].bins);
+        free(workers[t].removed);
+    }
+    free(ctx.lastBucket);
+    free(ctx.frontier);
+    stats.wallTime = getTimeSeconds() - start;
+    result->stats = stats;
+    return ok;
 }
 
-void addEdge(Graph *g, int src, int dest, int weight) {
-    if (src >= g->numVertices || dest >= g->numVertices || src < 0 || dest < 0) {
-        printf("Invalid vertices!\n");
-        return;
+bool sameParents(ShortestPathResult *a, ShortestPathResult *b) {
+    for (int v = 0; v < a->numVertices; v++) {
+        if (a->parent[v] != b->parent[v]) return false;
     }
+    return true;
+}
+
+// Delta-stepping against Dijkstra for several thread counts and deltas
+void benchmarkDeltaStepping(int rows, int cols, int maxWeight, int maxThreads) {
+    CSRGraph csr;
+    ShortestPathResult reference, result;
+    int deltas[] = {1, maxWeight / 4 > 1 ? maxWeight / 4 : 2, maxWeight, 4 * maxWeight};
+    int numDeltas = sizeof(deltas) / sizeof(deltas[0]);
     
-    if (weight < 0) {
-        printf("Dijkstra's algorithm doesn't work with negative weights!\n");
+    printf("\nGenerating %d x %d grid graph (weights 1..%d)...\n", rows, cols, maxWeight);
+    if (!generateGridGraph(&csr, rows, cols, maxWeight, 4242)) {
+        return;
+    }
+    if (!initShortestPathResult(&reference, csr.numVertices)) {
+        freeCSRGraph(&csr);
+        return;
+    }
+    if (!initShortestPathResult(&result, csr.numVertices)) {
+        freeShortestPathResult(&reference);
+        freeCSRGraph(&csr);
         return;
     }
     
-    g->adjMatrix[src][dest] = weight;
-    g->adjMatrix[dest][src] = weight; // For undirected graph
+    int source = csr.numVertices / 2;
+    dijkstraIndexedHeap(&csr, source, &reference, 2);
+    double dijkstraTime = reference.stats.wallTime;
+    canonicalParents(&csr, reference.distance, reference.parent, source, 0, csr.numVertices);
+    printf("Dijkstra (binary heap): %.6f seconds, %lld relaxations\n", dijkstraTime,
+           reference.stats.relaxations);
+    
+    printf("Delta\tThreads\tTime(s)\t\tvs Dijkstra\tRelaxations\tCheck\n");
+    for (int d = 0; d < numDeltas; d++) {
+        for (int threads = 1; threads <= maxThreads; threads *= 2) {
+            if (!deltaStepping(&csr, source, &result, deltas[d], threads)) break;
+            bool ok = sameDistances(&reference, &result) && sameParents(&reference, &result);
+            printf("%d\t%d\t%.6f\t%.2fx\t\t%lld\t%s\n", deltas[d], threads,
+                   result.stats.wallTime,
+                   result.stats.wallTime > 0 ? dijkstraTime / result.stats.wallTime : 0.0,
+                   result.stats.relaxations, ok ? "OK" : "MISMATCH");
+        }
+    }
+    
+    freeShortestPathResult(&reference);
+    freeShortestPathResult(&result);
+    freeCSRGraph(&csr);
 }
 
-void displayGraph(Graph *g) {
-    printf("\nAdjacency Matrix (Weighted):\n");
-    printf("     ");
-    for (int i = 0; i < g->numVertices; i++) {
-        printf("%3d ", i);
+// Incremental shortest paths
+// After an edge change only some distances can change:
+// - Lower weight (or new edge) u-v: only vertices that become closer through
+//   the edge. They are found by a Dijkstra started at the endpoint that
+//   improves, which stops where distances do not improve.
+// - Higher weight (or removed edge): nothing changes unless the edge is in
+//   the shortest path tree. Then only the subtree below it loses its paths;
+//   those vertices restart from their best neighbor outside the subtree and
+//   a Dijkstra over the subtree settles them again.
+// Both repairs touch the affected vertices and their edges only.
+
+void initDynamicSSSP(DynamicSSSP *dynamic, Graph *g, int source) {
+    dynamic->graph = g;
+    dynamic->source = source;
+    dynamic->affected = 0;
+    for (int v = 0; v < MAX_VERTICES; v++) {
+        dynamic->queued[v] = false;
     }
-    printf("\n");
+    dijkstra(g, source, &dynamic->result);
+}
+
+// Queue a vertex whose distance was lowered
+void dynamicEnqueue(DynamicSSSP *dynamic, int v, DijkstraStats *stats) {
+    if (dynamic->queued[v]) {
+        stats->decreaseKeys++;
+    } else {
+        dynamic->queued[v] = true;
+        stats->pushes++;
+    }
+}
+
+// Settle the vertices in the repair queue, relaxing their edges. The queue is
+// scanned for its minimum like findMinDistance(), which costs no more than
+// the O(V) edge scan of each settled vertex and works for every Distance type.
+void dynamicPropagate(DynamicSSSP *dynamic, DijkstraStats *stats) {
+    Graph *g = dynamic->graph;
+    DijkstraResult *result = &dynamic->result;
     
-    for (int i = 0; i < g->numVertices; i++) {
-        printf("%3d  ", i);
-        for (int j = 0; j < g->numVertices; j++) {
-            if (g->adjMatrix[i][j] == 0 && i != j) {
-                printf("  - ");
-            } else {
-                printf("%3d ", g->adjMatrix[i][j]);
+    while (1) {
+        int u = -1;
+        for (int v = 0; v < g->numVertices; v++) {
+            if (dynamic->queued[v] && (u == -1 || result->distance[v] < result->distance[u])) {
+                u = v;
+            }
+        }
+        if (u == -1) break;
+        dynamic->queued[u] = false;
+        stats->pops++;
+        stats->settled++;
+        
+        for (int v = 0; v < g->numVertices; v++) {
+            if (g->adjMatrix[u][v] == 0 || v == u) continue;
+            stats->relaxations++;
+            Distance candidate = addDistance(result->distance[u], g->adjMatrix[u][v]);
+            if (candidate < result->distance[v]) {
+                stats->successfulRelaxations++;
+                result->distance[v] = candidate;
+                result->parent[v] = u;
+                TRACE_RELAX(v, candidate, u);
+                dynamicEnqueue(dynamic, v, stats);
             }
         }
-        printf("\n");
     }
 }
 
-int findMinDistance(DijkstraResult *result, int numVertices) {
-    int min = INF;
-    int minIndex = -1;
+// Set the weight of edge u-v (0 removes it) and repair the shortest paths
+bool dynamicSetEdge(DynamicSSSP *dynamic, int u, int v, Weight weight) {
+    Graph *g = dynamic->graph;
+    DijkstraResult *result = &dynamic->result;
+    int n = g->numVertices;
     
-    for (int v = 0; v < numVertices; v++) {
-        if (!result->visited[v] && result->distance[v] < min) {
-            min = result->distance[v];
-            minIndex = v;
+    if (u < 0 || v < 0 || u >= n || v >= n || u == v) {
+        printf("Invalid vertices!\n");
+        return false;
+    }
+    if (weight < 0) {
+        printf("Negative weights not allowed in Dijkstra's algorithm!\n");
+        return false;
+    }
+    
+    double start = getTimeSeconds();
+    DijkstraStats stats = {0};
+    Weight old = g->adjMatrix[u][v];
+    g->adjMatrix[u][v] = weight;
+    g->adjMatrix[v][u] = weight;
+    bool longer = old != 0 && (weight == 0 || weight > old);
+    bool shorter = weight != 0 && (old == 0 || weight < old);
+    
+    if (shorter) {
+        int ends[2][2] = {{u, v}, {v, u}};
+        for (int k = 0; k < 2; k++) {
+            int from = ends[k][0], to = ends[k][1];
+            Distance candidate = addDistance(result->distance[from], weight);
+            if (candidate < result->distance[to]) {
+                result->distance[to] = candidate;
+                result->parent[to] = from;
+                dynamicEnqueue(dynamic, to, &stats);
+            }
+        }
+        dynamicPropagate(dynamic, &stats);
+    } else if (longer) {
+        int child = result->parent[v] == u ? v : (result->parent[u] == v ? u : -1);
+        if (child != -1) {
+            // Collect the subtree below the changed tree edge
+            bool inSubtree[MAX_VERTICES] = {false};
+            int subtree[MAX_VERTICES];
+            int size = 0;
+            subtree[size++] = child;
+            inSubtree[child] = true;
+            for (int i = 0; i < size; i++) {
+                for (int x = 0; x < n; x++) {
+                    if (result->parent[x] == subtree[i] && !inSubtree[x]) {
+                        inSubtree[x] = true;
+                        subtree[size++] = x;
+                    }
+                }
+            }
+            for (int i = 0; i < size; i++) {
+                result->distance[subtree[i]] = DISTANCE_INF;
+                result->parent[subtree[i]] = -1;
+            }
+            
+            // Best entry into the subtree from outside, then settle it again
+            for (int i = 0; i < size; i++) {
+                int x = subtree[i];
+                for (int y = 0; y < n; y++) {
+                    if (inSubtree[y] || g->adjMatrix[y][x] == 0) continue;
+                    stats.relaxations++;
+                    Distance candidate = addDistance(result->distance[y], g->adjMatrix[y][x]);
+                    if (candidate < result->distance[x]) {
+                        result->distance[x] = candidate;
+                        result->parent[x] = y;
+                    }
+                }
+                if (result->distance[x] != DISTANCE_INF) {
+                    dynamicEnqueue(dynamic, x, &stats);
+                }
+            }
+            dynamicPropagate(dynamic, &stats);
+            
+            // Vertices still at INF were cut off; the settled ones are counted already
+            for (int i = 0; i < size; i++) {
+                if (result->distance[subtree[i]] == DISTANCE_INF) stats.settled++;
+            }
         }
     }
     
-    return minIndex;
+    for (int x = 0; x < n; x++) {
+        result->visited[x] = result->distance[x] != DISTANCE_INF;
+    }
+    dynamic->affected = (int)stats.settled;
+    stats.wallTime = getTimeSeconds() - start;
+    result->stats = stats;
+    return true;
 }
 
-void dijkstra(Graph *g, int source, DijkstraResult *result) {
-    if (source >= g->numVertices || source < 0) {
-        printf("Invalid source vertex!\n");
-        return;
+// Check a repaired result: same distances as a fresh run, and every parent
+// is a graph neighbor on a shortest path (equal-length paths may differ)
+bool checkDynamicSSSP(DynamicSSSP *dynamic) {
+    Graph *g = dynamic->graph;
+    DijkstraResult fresh;
+    
+    dijkstra(g, dynamic->source, &fresh);
+    for (int v = 0; v < g->numVertices; v++) {
+        if (fresh.distance[v] != dynamic->result.distance[v]) return false;
+        int p = dynamic->result.parent[v];
+        if (v == dynamic->source || dynamic->result.distance[v] == DISTANCE_INF) {
+            if (p != -1) return false;
+        } else if (p < 0 || g->adjMatrix[p][v] == 0 ||
+                   addDistance(dynamic->result.distance[p], g->adjMatrix[p][v]) !=
+                       dynamic->result.distance[v]) {
+            return false;
+        }
     }
+    return true;
+}
+
+// Random graphs and random weight changes (inserts, decreases, increases,
+// removals), each repaired result compared with a fresh dijkstra() run
+void testDynamicSSSP(int numGraphs, int updatesPerGraph) {
+    Graph g;
+    DynamicSSSP dynamic;
+    unsigned long long state = 2024;
+    long long updates = 0, failures = 0, affected = 0, vertices = 0;
+    double repairTime = 0.0, fullTime = 0.0;
     
-    for (int i = 0; i < g->numVertices; i++) {
-        result->distance[i] = INF;
-        result->parent[i] = -1;
-        result->visited[i] = false;
+    for (int k = 0; k < numGraphs; k++) {
+        int n = 2 + nextRandom(&state) % (MAX_VERTICES - 1);
+        initGraph(&g, n);
+        for (int u = 0; u < n; u++) {
+            for (int v = u + 1; v < n; v++) {
+                if (nextRandom(&state) % 100 < 25) {
+                    Weight weight = 1 + nextRandom(&state) % 20;
+                    g.adjMatrix[u][v] = g.adjMatrix[v][u] = weight;
+                }
+            }
+        }
+        
+        initDynamicSSSP(&dynamic, &g, nextRandom(&state) % n);
+        for (int i = 0; i < updatesPerGraph; i++) {
+            int u = nextRandom(&state) % n;
+            int v = nextRandom(&state) % n;
+            if (u == v) continue;
+            Weight weight = nextRandom(&state) % 100 < 20 ? 0 : 1 + nextRandom(&state) % 20;
+            
+            dynamicSetEdge(&dynamic, u, v, weight);
+            repairTime += dynamic.result.stats.wallTime;
+            affected += dynamic.affected;
+            vertices += n;
+            updates++;
+            
+            double start = getTimeSeconds();
+            if (!checkDynamicSSSP(&dynamic)) failures++;
+            fullTime += getTimeSeconds() - start;
+        }
     }
     
-    result->distance[source] = 0;
+    printf("\n%lld updates on %d random graphs\n", updates, numGraphs);
+    printf("Average affected vertices: %.2f of %.2f\n",
+           updates > 0 ? (double)affected / updates : 0.0,
+           updates > 0 ? (double)vertices / updates : 0.0);
+    printf("Average repair time: %.3f us, full run: %.3f us\n",
+           updates > 0 ? 1e6 * repairTime / updates : 0.0,
+           updates > 0 ? 1e6 * fullTime / updates : 0.0);
+    printf("Mismatches against full Dijkstra: %lld (%s)\n", failures,
+           failures == 0 ? "OK" : "FAILED");
+}
+
+// Every CSR variant from source against dijkstraLinearScan(), and against
+// expected[] when given: the priority queues (Dial refuses weights above
+// DIAL_MAX_WEIGHT), point-to-point queries to every target, a contraction
+// hierarchy, delta-stepping and a many-to-many row
+bool checkCSRVariants(CSRGraph *csr, int source, const long long *expected) {
+    QueueType queues[] = {QUEUE_BINARY_HEAP, QUEUE_FOUR_ARY_HEAP, QUEUE_LAZY_HEAP,
+                          QUEUE_RADIX_HEAP};
+    int numQueues = sizeof(queues) / sizeof(queues[0]);
+    int n = csr->numVertices;
+    ShortestPathResult reference, result;
+    PathQuery query;
+    ContractionHierarchy ch;
+    bool ok = true;
     
-    printf("\n=== Running Dijkstra's Algorithm ===\n");
-    printf("Source vertex: %d\n\n", source);
+    memset(&reference, 0, sizeof(reference));
+    memset(&result, 0, sizeof(result));
+    memset(&query, 0, sizeof(query));
+    initContractionHierarchy(&ch);
+    int *path = (int*)malloc(n * sizeof(int));
+    int *all = (int*)malloc(n * sizeof(int));
+    long long *row = (long long*)malloc(n * sizeof(long long));
+    bool ready = path != NULL && all != NULL && row != NULL;
+    if (!ready) printf("Memory allocation failed!\n");
+    ready = ready && initShortestPathResult(&reference, n) &&
+            initShortestPathResult(&result, n) && initPathQuery(&query, n) &&
+            buildContractionHierarchy(&ch, csr);
     
-    for (int count = 0; count < g->numVertices - 1; count++) {
-        int u = findMinDistance(result, g->numVertices);
-        
-        if (u == -1) break; // No more reachable vertices
+    if (ready) {
+        dijkstraLinearScan(csr, source, &reference);
+        for (int v = 0; expected != NULL && v < n; v++) {
+            if (reference.distance[v] != expected[v]) ok = false;
+        }
+        for (int q = 0; q < numQueues; q++) {
+            if (!dijkstraSparse(csr, source, &result, queues[q]) ||
+                !sameDistances(&reference, &result)) {
+                ok = false;
+            }
+        }
         
-        result->visited[u] = true;
+        for (int target = 0; target < n; target++) {
+            long long distance = dijkstraPointToPoint(csr, source, target, &query);
+            if (distance != reference.distance[target] || !checkQueryPath(csr, &query, path)) {
+                ok = false;
+            }
+            distance = dijkstraBidirectional(csr, source, target, &query);
+            if (distance != reference.distance[target] || !checkQueryPath(csr, &query, path)) {
+                ok = false;
+            }
+            distance = chQuery(&ch, source, target, &query);
+            int length = chUnpackPath(&ch, &query, path);
+            if (distance != reference.distance[target] ||
+                !checkPath(csr, source, target, distance, path, length)) {
+                ok = false;
+            }
+        }
         
-        printf("Step %d: Visiting vertex %d (distance: %d)\n", count + 1, u, 
-               result->distance[u] == INF ? -1 : result->distance[u]);
+        canonicalParents(csr, reference.distance, reference.parent, source, 0, n);
+        if (!deltaStepping(csr, source, &result, INT_MAX / 4, 2) ||
+            !sameDistances(&reference, &result) || !sameParents(&reference, &result)) {
+            ok = false;
+        }
         
-        // Update distance values of adjacent vertices
-        for (int v = 0; v < g->numVertices; v++) {
-            // Update distance[v] if:
-            // - v is not visited
-            // - there is an edge from u to v
-            // - total weight from source to v through u is less than current distance[v]
-            if (!result->visited[v] && 
-                g->adjMatrix[u][v] != 0 && 
-                result->distance[u] != INF && 
-                result->distance[u] + g->adjMatrix[u][v] < result->distance[v]) {
-                
-                result->distance[v] = result->distance[u] + g->adjMatrix[u][v];
-                result->parent[v] = u;
-                
-                printf("  -> Updated distance to vertex %d: %d (via %d)\n", 
-                       v, result->distance[v], u);
-            }
+        for (int v = 0; v < n; v++) {
+            all[v] = v;
+        }
+        if (!manyToManyDistances(csr, &source, 1, all, n, 2, row, NULL) ||
+            memcmp(row, reference.distance, n * sizeof(long long)) != 0) {
+            ok = false;
         }
-    }
-}
-
-// Print path from source to destination
-void printPath(DijkstraResult *result, int dest) {
-    if (result->parent[dest] == -1) {
-        printf("%d", dest);
-        return;
     }
     
-    printPath(result, result->parent[dest]);
-    printf(" -> %d", dest);
+    freeContractionHierarchy(&ch);
+    freePathQuery(&query);
+    freeShortestPathResult(&reference);
+    freeShortestPathResult(&result);
+    free(path);
+    free(all);
+    free(row);
+    return ready && ok;
 }
 
-// Display results
-void displayResults(DijkstraResult *result, int source, int numVertices) {
-    printf("Destination\tDistance\tPath\n");
+// Shortest paths longer than INT_MAX: the path 0 - 1 - 2 with two edges of
+// weight 2000000000 (distances 0, 2000000000, 4000000000), then random graphs
+// with weights up to INT_MAX, all through checkCSRVariants()
+void testLargeWeights(int numGraphs) {
+    CSRGraph csr;
+    int src[MAX_VERTICES * MAX_VERTICES], dest[MAX_VERTICES * MAX_VERTICES];
+    int weight[MAX_VERTICES * MAX_VERTICES];
+    long long expected[] = {0, 2000000000LL, 4000000000LL};
+    unsigned long long state = 4242;
+    int failures = 0;
     
-    for (int i = 0; i < numVertices; i++) {
-        printf("%d\t\t", i);
-        
-        if (result->distance[i] == INF) {
-            printf("INF\t\tNo path\n");
-        } else {
-            printf("%d\t\t", result->distance[i]);
-            printPath(result, i);
-            printf("\n");
+    src[0] = 0;
+    dest[0] = 1;
+    src[1] = 1;
+    dest[1] = 2;
+    weight[0] = weight[1] = 2000000000;
+    if (buildCSRFromEdges(&csr, 3, src, dest, weight, 2)) {
+        if (!checkCSRVariants(&csr, 0, expected)) failures++;
+        freeCSRGraph(&csr);
+    }
+    
+    for (int k = 0; k < numGraphs; k++) {
+        int n = 2 + nextRandom(&state) % (MAX_VERTICES - 1);
+        long long m = 0;
+        for (int u = 0; u < n; u++) {
+            for (int v = u + 1; v < n; v++) {
+                if (nextRandom(&state) % 100 < 25) {
+                    src[m] = u;
+                    dest[m] = v;
+                    weight[m++] = 1 + nextRandom(&state) % INT_MAX;
+                }
+            }
         }
+        if (!buildCSRFromEdges(&csr, n, src, dest, weight, m)) continue;
+        if (!checkCSRVariants(&csr, nextRandom(&state) % n, NULL)) failures++;
+        freeCSRGraph(&csr);
     }
+    
+    printf("Large weights: %d of %d graphs differ from the expected distances (%s)\n",
+           failures, numGraphs + 1, failures == 0 ? "OK" : "FAILED");
 }
 
 // Create example graph
@@ -188,22 +4397,67 @@ int main() {
     displayGraph(&g);
     
     // Run Dijkstra's algorithm from vertex 0
+    printf("\n=== Running Dijkstra's Algorithm ===\n");
+    printf("Source vertex: %d\n\n", 0);
     dijkstra(&g, 0, &result);
     displayResults(&result, 0, g.numVertices);
     
     // Run from different source
+    printf("\n=== Running Dijkstra's Algorithm ===\n");
+    printf("Source vertex: %d\n\n", 2);
     dijkstra(&g, 2, &result);
     displayResults(&result, 2, g.numVertices);
     
+    // Same queries with the heap-based sparse Dijkstra
+    printf("\n--- Heap-Based Dijkstra (indexed binary heap) ---\n");
+    CSRGraph csr;
+    ShortestPathResult pathResult;
+    if (buildCSRFromGraph(&csr, &g) && initShortestPathResult(&pathResult, csr.numVertices)) {
+        dijkstraIndexedHeap(&csr, 0, &pathResult, 2);
+        displayShortestPaths(&pathResult);
+        freeShortestPathResult(&pathResult);
+    }
+    freeCSRGraph(&csr);
+    
+    // Mapped graph file of option 6; while it is loaded the sparse options
+    // (7, 10, 21) run on it instead of the adjacency matrix
+    CSRGraph loaded;
+    CSRGraph *sparse;
+    initCSRGraph(&loaded);
+    
     // Interactive mode
-    int choice, vertices, src, dest, weight, source;
+    int choice, vertices, src, dest, weight, source, rows, cols;
+    Weight edgeWeight;
+    char path[256];
+    DijkstraStats lastStats = result.stats;
+    const char *lastLabel = "matrix";
+    DynamicSSSP dynamic;
+    bool tracking = false;
     
     while (1) {
         printf("\n1. Create new graph\n");
         printf("2. Add edge\n");
         printf("3. Display graph\n");
         printf("4. Run Dijkstra's algorithm\n");
-        printf("5. Exit\n");
+        printf("5. Save graph to binary file\n");
+        printf("6. Load graph from binary file\n");
+        printf("7. Run heap-based Dijkstra (sparse graph)\n");
+        printf("8. Benchmark Dijkstra variants on grid graph\n");
+        printf("9. Benchmark integer priority queues (radix heap / Dial)\n");
+        printf("10. Shortest path query (source -> target)\n");
+        printf("11. Benchmark point-to-point queries\n");
+        printf("12. Benchmark A* heuristics on grid graph\n");
+        printf("13. Contraction hierarchy on grid graph (build, save, query)\n");
+        printf("14. Benchmark many-to-many distance tables (threads)\n");
+        printf("15. Benchmark all-pairs: Floyd-Warshall vs many-to-many\n");
+        printf("16. Benchmark parallel delta-stepping (threads x delta)\n");
+        printf("17. Track shortest paths from a source (incremental updates)\n");
+        printf("18. Change edge weight and repair tracked paths\n");
+        printf("19. Self-check incremental updates and large weights against full Dijkstra\n");
+        printf("20. Export last Dijkstra counters to CSV\n");
+        printf("21. Distance table between vertices (many-to-many)\n");
+        printf("22. Benchmark Dijkstra on a graph file before and after reordering\n");
+        printf("23. Exit\n");
         printf("Enter choice: ");
         
         if (scanf("%d", &choice) != 1) {
@@ -221,6 +4475,8 @@ int main() {
                 } else {
                     initGraph(&g, vertices);
                     printf("Graph with %d vertices created.\n", vertices);
+                    tracking = false;
+                    freeCSRGraph(&loaded);
                 }
                 break;
                 
@@ -230,9 +4486,19 @@ int main() {
                 printf("Enter destination vertex: ");
                 scanf("%d", &dest);
                 printf("Enter edge weight: ");
-                scanf("%d", &weight);
-                addEdge(&g, src, dest, weight);
-                printf("Edge added: %d -- %d (weight: %d)\n", src, dest, weight);
+                scanf("%" WEIGHT_SCN, &edgeWeight);
+                // The matrix is the graph being edited from now on
+                freeCSRGraph(&loaded);
+                if (tracking) {
+                    if (dynamicSetEdge(&dynamic, src, dest, edgeWeight)) {
+                        printf("Edge added: %d -- %d (weight: %" WEIGHT_PRI
+                               "), %d tracked vertices affected\n",
+                               src, dest, edgeWeight, dynamic.affected);
+                    }
+                    break;
+                }
+                addEdge(&g, src, dest, edgeWeight);
+                printf("Edge added: %d -- %d (weight: %" WEIGHT_PRI ")\n", src, dest, edgeWeight);
                 break;
                 
             case 3:
@@ -242,11 +4508,323 @@ int main() {
             case 4:
                 printf("Enter source vertex: ");
                 scanf("%d", &source);
+                if (source >= g.numVertices || source < 0) {
+                    printf("Invalid source vertex!\n");
+                    break;
+                }
+                printf("\n=== Running Dijkstra's Algorithm ===\n");
+                printf("Source vertex: %d\n\n", source);
                 dijkstra(&g, source, &result);
                 displayResults(&result, source, g.numVertices);
+                lastStats = result.stats;
+                lastLabel = "matrix";
                 break;
                 
             case 5:
+                printf("Enter output binary file: ");
+                scanf("%255s", path);
+                if (buildCSRFromGraph(&csr, &g)) {
+                    if (saveCSRGraphBinary(&csr, path)) {
+                        printf("Graph saved to %s\n", path);
+                    }
+                    freeCSRGraph(&csr);
+                }
+                break;
+                
+            case 6:
+                printf("Enter binary graph file: ");
+                scanf("%255s", path);
+                freeCSRGraph(&loaded);
+                if (loadCSRGraphBinary(&loaded, path)) {
+                    printf("Mapped %d vertices, %lld arcs; options 7, 10 and 21 run on it "
+                           "until the matrix graph is changed\n", loaded.numVertices,
+                           loaded.numEdges);
+                    // Small graphs are also copied into the matrix for options 3 and 4
+                    if (loaded.numVertices <= MAX_VERTICES && loadGraphFromCSR(&g, &loaded)) {
+                        displayGraph(&g);
+                        tracking = false;
+                    }
+                }
+                break;
+                
+            case 7: {
+                int queue, delta = 1, threads = 1;
+                printf("Enter source vertex: ");
+                scanf("%d", &source);
+                printf("Priority queue (0 = binary heap, 1 = 4-ary heap, 2 = lazy heap, "
+                       "3 = radix heap, 4 = Dial, 5 = parallel delta-stepping): ");
+                scanf("%d", &queue);
+                if (queue == QUEUE_DIAL + 1) {
+                    printf("Enter delta and threads (1-%d): ", MAX_THREADS);
+                    scanf("%d %d", &delta, &threads);
+                }
+                sparse = NULL;
+                if (queue < QUEUE_BINARY_HEAP || queue > QUEUE_DIAL + 1) {
+                    printf("Invalid priority queue!\n");
+                } else if (delta < 1 || threads < 1 || threads > MAX_THREADS) {
+                    printf("Invalid delta-stepping parameters!\n");
+                } else if ((sparse = currentSparseGraph(&loaded, &g, &csr)) == NULL) {
+                    break;
+                } else if (source >= sparse->numVertices || source < 0) {
+                    printf("Invalid source vertex!\n");
+                } else if (initShortestPathResult(&pathResult, sparse->numVertices)) {
+                    bool ok = queue == QUEUE_DIAL + 1 ?
+                              deltaStepping(sparse, source, &pathResult, delta, threads) :
+                              dijkstraSparse(sparse, source, &pathResult, (QueueType)queue);
+                    if (ok) {
+                        displayShortestPathSummary(&pathResult);
+                        lastStats = pathResult.stats;
+                        lastLabel = queue == QUEUE_DIAL + 1 ? "delta-stepping" :
+                                    queueTypeName((QueueType)queue);
+                    }
+                    freeShortestPathResult(&pathResult);
+                }
+                if (sparse != NULL) freeCSRGraph(&csr);
+                break;
+            }
+                
+            case 8:
+                printf("Enter grid rows and columns (e.g. 1000 1000): ");
+                scanf("%d %d", &rows, &cols);
+                printf("Enter maximum edge weight (e.g. 100): ");
+                scanf("%d", &weight);
+                if (rows < 1 || cols < 1 || (long long)rows * cols > 50000000 || weight < 1) {
+                    printf("Invalid benchmark parameters!\n");
+                } else {
+                    benchmarkDijkstra(rows, cols, weight, 5);
+                }
+                break;
+                
+            case 9:
+                printf("Enter grid rows and columns (e.g. 1000 1000): ");
+                scanf("%d %d", &rows, &cols);
+                if (rows < 1 || cols < 1 || (long long)rows * cols > 50000000) {
+                    printf("Invalid benchmark parameters!\n");
+                } else {
+                    benchmarkIntegerQueues(rows, cols, 3);
+                }
+                break;
+                
+            case 10: {
+                int search;
+                PathQuery query;
+                printf("Enter source and target vertices: ");
+                scanf("%d %d", &source, &dest);
+                printf("Search (0 = early exit, 1 = bidirectional, 2 = contraction hierarchy): ");
+                scanf("%d", &search);
+                if (search < 0 || search > 2) {
+                    printf("Invalid search!\n");
+                    break;
+                }
+                if ((sparse = currentSparseGraph(&loaded, &g, &csr)) == NULL) break;
+                if (source >= sparse->numVertices || source < 0 ||
+                    dest >= sparse->numVertices || dest < 0) {
+                    printf("Invalid vertices!\n");
+                } else if (initPathQuery(&query, sparse->numVertices)) {
+                    if (search == 2) {
+                        queryContractionHierarchy(sparse, source, dest, &query);
+                    } else {
+                        if (search == 1) {
+                            dijkstraBidirectional(sparse, source, dest, &query);
+                        } else {
+                            dijkstraPointToPoint(sparse, source, dest, &query);
+                        }
+                        displayPathQuery(&query);
+                    }
+                    lastStats = query.stats;
+                    lastLabel = search == 2 ? "contraction hierarchy" :
+                                search == 1 ? "bidirectional" : "early exit";
+                    freePathQuery(&query);
+                }
+                freeCSRGraph(&csr);
+                break;
+            }
+                
+            case 11:
+                printf("Enter grid rows and columns (e.g. 1000 1000): ");
+                scanf("%d %d", &rows, &cols);
+                printf("Enter maximum edge weight (e.g. 100): ");
+                scanf("%d", &weight);
+                if (rows < 1 || cols < 1 || (long long)rows * cols > 50000000 || weight < 1) {
+                    printf("Invalid benchmark parameters!\n");
+                } else {
+                    benchmarkPointToPoint(rows, cols, weight, 20);
+                }
+                break;
+                
+            case 12: {
+                int numLandmarks;
+                printf("Enter grid rows and columns (e.g. 1000 1000): ");
+                scanf("%d %d", &rows, &cols);
+                printf("Enter maximum edge weight (e.g. 100): ");
+                scanf("%d", &weight);
+                printf("Enter number of landmarks (e.g. 8): ");
+                scanf("%d", &numLandmarks);
+                if (rows < 1 || cols < 1 || (long long)rows * cols > 50000000 || weight < 1 ||
+                    numLandmarks < 1 || numLandmarks > 64) {
+                    printf("Invalid benchmark parameters!\n");
+                } else {
+                    benchmarkAStar(rows, cols, weight, numLandmarks, 20);
+                }
+                break;
+            }
+                
+            case 13:
+                printf("Enter grid rows and columns (e.g. 200 200): ");
+                scanf("%d %d", &rows, &cols);
+                printf("Enter maximum edge weight (e.g. 100): ");
+                scanf("%d", &weight);
+                printf("Enter index file: ");
+                scanf("%255s", path);
+                if (rows < 1 || cols < 1 || (long long)rows * cols > 50000000 || weight < 1) {
+                    printf("Invalid benchmark parameters!\n");
+                } else {
+                    benchmarkContractionHierarchy(rows, cols, weight, path, 1000);
+                }
+                break;
+                
+            case 14: {
+                int numSources, numTargets, threads;
+                printf("Enter grid rows and columns (e.g. 500 500): ");
+                scanf("%d %d", &rows, &cols);
+                printf("Enter maximum edge weight (e.g. 100): ");
+                scanf("%d", &weight);
+                printf("Enter number of sources and targets (e.g. 200 200): ");
+                scanf("%d %d", &numSources, &numTargets);
+                printf("Enter maximum threads (1-%d): ", MAX_THREADS);
+                scanf("%d", &threads);
+                if (rows < 1 || cols < 1 || (long long)rows * cols > 50000000 || weight < 1 ||
+                    numSources < 1 || numTargets < 1 ||
+                    (long long)numSources * numTargets > 100000000 ||
+                    threads < 1 || threads > MAX_THREADS) {
+                    printf("Invalid benchmark parameters!\n");
+                } else {
+                    benchmarkManyToMany(rows, cols, weight, numSources, numTargets, threads);
+                }
+                break;
+            }
+                
+            case 15: {
+                int threads;
+                printf("Enter grid rows and columns (e.g. 30 30): ");
+                scanf("%d %d", &rows, &cols);
+                printf("Enter maximum edge weight (e.g. 100): ");
+                scanf("%d", &weight);
+                printf("Enter threads for many-to-many (1-%d): ", MAX_THREADS);
+                scanf("%d", &threads);
+                if (rows < 1 || cols < 1 || (long long)rows * cols > 5000 || weight < 1 ||
+                    threads < 1 || threads > MAX_THREADS) {
+                    printf("Invalid benchmark parameters (at most 5000 vertices)!\n");
+                } else {
+                    benchmarkAllPairs(rows, cols, weight, threads);
+                }
+                break;
+            }
+                
+            case 16: {
+                int threads;
+                printf("Enter grid rows and columns (e.g. 1000 1000): ");
+                scanf("%d %d", &rows, &cols);
+                printf("Enter maximum edge weight (e.g. 100): ");
+                scanf("%d", &weight);
+                printf("Enter maximum threads (1-%d): ", MAX_THREADS);
+                scanf("%d", &threads);
+                if (rows < 1 || cols < 1 || (long long)rows * cols > 50000000 || weight < 1 ||
+                    threads < 1 || threads > MAX_THREADS) {
+                    printf("Invalid benchmark parameters!\n");
+                } else {
+                    benchmarkDeltaStepping(rows, cols, weight, threads);
+                }
+                break;
+            }
+                
+            case 17:
+                printf("Enter source vertex: ");
+                scanf("%d", &source);
+                if (source >= g.numVertices || source < 0) {
+                    printf("Invalid source vertex!\n");
+                    break;
+                }
+                initDynamicSSSP(&dynamic, &g, source);
+                tracking = true;
+                printf("Tracking shortest paths from %d\n", source);
+                displayResults(&dynamic.result, source, g.numVertices);
+                break;
+                
+            case 18:
+                if (!tracking) {
+                    printf("Start tracking with option 17 first!\n");
+                    break;
+                }
+                printf("Enter edge vertices: ");
+                scanf("%d %d", &src, &dest);
+                printf("Enter new weight (0 removes the edge): ");
+                scanf("%" WEIGHT_SCN, &edgeWeight);
+                if (dynamicSetEdge(&dynamic, src, dest, edgeWeight)) {
+                    printf("Edge %d -- %d set to %" WEIGHT_PRI ", %d vertices affected\n", src,
+                           dest, edgeWeight, dynamic.affected);
+                    displayResults(&dynamic.result, dynamic.source, g.numVertices);
+                    lastStats = dynamic.result.stats;
+                    lastLabel = "incremental";
+                }
+                break;
+                
+            case 19:
+                testDynamicSSSP(1000, 50);
+                testLargeWeights(200);
+                break;
+                
+            case 20:
+                printf("Enter CSV file: ");
+                scanf("%255s", path);
+                if (exportDijkstraStatsCSV(path, lastLabel, &lastStats)) {
+                    printf("Counters of last run (%s) appended to %s\n", lastLabel, path);
+                }
+                break;
+                
+            case 21: {
+                int numSources, numTargets, threads;
+                printf("Enter number of sources and targets: ");
+                scanf("%d %d", &numSources, &numTargets);
+                if (numSources < 1 || numTargets < 1 ||
+                    (long long)numSources * numTargets > 100000000) {
+                    printf("Invalid table size!\n");
+                    break;
+                }
+                int *vertexList = (int*)malloc(((size_t)numSources + numTargets) * sizeof(int));
+                if (vertexList == NULL) {
+                    printf("Memory allocation failed!\n");
+                    break;
+                }
+                printf("Enter %d source vertices: ", numSources);
+                for (int i = 0; i < numSources; i++) scanf("%d", &vertexList[i]);
+                printf("Enter %d target vertices: ", numTargets);
+                for (int j = 0; j < numTargets; j++) scanf("%d", &vertexList[numSources + j]);
+                printf("Enter threads (1-%d): ", MAX_THREADS);
+                scanf("%d", &threads);
+                if (threads < 1 || threads > MAX_THREADS) {
+                    printf("Invalid number of threads!\n");
+                } else if ((sparse = currentSparseGraph(&loaded, &g, &csr)) != NULL) {
+                    displayDistanceTable(sparse, vertexList, numSources,
+                                         vertexList + numSources, numTargets, threads);
+                    freeCSRGraph(&csr);
+                }
+                free(vertexList);
+                break;
+            }
+                
+            case 22: {
+                char reorderedPath[256];
+                printf("Enter original binary graph file: ");
+                scanf("%255s", path);
+                printf("Enter reordered binary graph file (with its .order file): ");
+                scanf("%255s", reorderedPath);
+                benchmarkReorderedGraph(path, reorderedPath, 5);
+                break;
+            }
+                
+            case 23:
+                freeCSRGraph(&loaded);
                 printf("Exiting...\n");
                 return 0;
                 